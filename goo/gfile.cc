@@ -54,6 +54,10 @@
 #    include <unixlib.h>
 #  endif
 #endif // _WIN32
+#ifdef HAVE_SYS_MMAN_H
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
 #include <stdio.h>
 #include <limits>
 #include "GooString.h"
@@ -676,6 +680,18 @@ GooFile* GooFile::open(const wchar_t *fileName) {
   return handle == INVALID_HANDLE_VALUE ? nullptr : new GooFile(handle);
 }
 
+const char *GooFile::map(Goffset *length) const {
+  // not implemented, files are read with ReadFile
+  *length = 0;
+  return nullptr;
+}
+
+void GooFile::unmap(const char *data, Goffset length) {
+}
+
+void GooFile::adviseSequential(const char *data, Goffset length) {
+}
+
 #else
 
 int GooFile::read(char *buf, int n, Goffset offset) const {
@@ -703,6 +719,51 @@ GooFile* GooFile::open(const GooString *fileName) {
   
   return fd < 0 ? nullptr : new GooFile(fd);
 }
+
+const char *GooFile::map(Goffset *length) const {
+#ifdef HAVE_SYS_MMAN_H
+  struct stat statbuf;
+  void *data;
+
+  *length = 0;
+  // pipes and such can't be mapped, and an empty mapping isn't allowed
+  if (fstat(fd, &statbuf) < 0 || !S_ISREG(statbuf.st_mode) ||
+      statbuf.st_size <= 0 ||
+      (unsigned long long)statbuf.st_size > (size_t)-1) {
+    return nullptr;
+  }
+  data = mmap(nullptr, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+  *length = statbuf.st_size;
+  return (const char *)data;
+#else
+  *length = 0;
+  return nullptr;
+#endif
+}
+
+void GooFile::unmap(const char *data, Goffset length) {
+#ifdef HAVE_SYS_MMAN_H
+  munmap((void *)data, length);
+#endif
+}
+
+void GooFile::adviseSequential(const char *data, Goffset length) {
+#if defined(HAVE_SYS_MMAN_H) && defined(MADV_SEQUENTIAL)
+  static const long pageSize = sysconf(_SC_PAGESIZE);
+  size_t offset;
+
+  if (pageSize <= 0) {
+    return;
+  }
+  // madvise wants a page aligned address
+  offset = (size_t)data % pageSize;
+  madvise((void *)(data - offset), length + offset, MADV_SEQUENTIAL);
+  madvise((void *)(data - offset), length + offset, MADV_WILLNEED);
+#endif
+}
 GooFile::GooFile(int fdA)
  : fd(fdA)
 {
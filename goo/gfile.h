@@ -141,6 +141,16 @@ public:
 
   int read(char *buf, int n, Goffset offset) const;
   Goffset size() const;
+
+  // Maps the whole file in memory, read only, and sets <length> to its
+  // size.  Returns NULL if the file can't be mapped, e.g. if it isn't a
+  // regular file.  The mapping must be released with unmap().
+  const char *map(Goffset *length) const;
+  static void unmap(const char *data, Goffset length);
+
+  // Tells the system that <length> bytes at <data>, in a mapping, will
+  // soon be read from start to end.
+  static void adviseSequential(const char *data, Goffset length);
   
   static GooFile *open(const GooString *fileName);
   
@@ -32,12 +32,13 @@
 
 #include <stdlib.h>
 #include <stddef.h>
+#include <string.h>
 #include "goo/gmem.h"
 #include "Object.h"
 #include "Array.h"
 
 #ifdef MULTITHREADED
-#  define arrayLocker()   MutexLocker locker(&mutex)
+#  define arrayLocker()   MutexLocker locker(getMutex())
 #else
 #  define arrayLocker()
 #endif
@@ -48,21 +49,58 @@
 Array::Array(XRef *xrefA) {
   xref = xrefA;
   elems = nullptr;
+  elemsInline = gFalse;
   size = length = 0;
   ref = 1;
 #ifdef MULTITHREADED
-  gInitMutex(&mutex);
+  mutexInit = gFalse;
 #endif
 }
 
+Array::Array(XRef *xrefA, Object *elemsA, int lengthA) {
+  xref = xrefA;
+  size = length = lengthA;
+  ref = 1;
+#ifdef MULTITHREADED
+  mutexInit = gFalse;
+#endif
+
+  elems = (Object *)(this + 1);
+  elemsInline = gTrue;
+  for (int i = 0; i < length; ++i) {
+    elems[i].initNullAfterMalloc();
+    elems[i] = std::move(elemsA[i]);
+  }
+}
+
+void *Array::operator new(size_t size, int nElems) {
+  return gmalloc(size + (size_t)nElems * sizeof(Object));
+}
+
+#ifdef MULTITHREADED
+// Like dictionaries, most arrays are never modified once made, so the
+// mutex is only set up the first time it is needed.
+GooMutex *Array::getMutex() const {
+  std::call_once(mutexOnce, [this] {
+    gInitMutex(&mutex);
+    mutexInit = gTrue;
+  });
+  return &mutex;
+}
+#endif
+
 Array::~Array() {
   int i;
 
   for (i = 0; i < length; ++i)
     elems[i].free();
-  gfree(elems);
+  if (!elemsInline) {
+    gfree(elems);
+  }
 #ifdef MULTITHREADED
-  gDestroyMutex(&mutex);
+  if (mutexInit) {
+    gDestroyMutex(&mutex);
+  }
 #endif
 }
 
@@ -75,16 +113,24 @@ Object Array::copy(XRef *xrefA) const {
   return Object(a);
 }
 
-int Array::incRef() {
+Array *Array::deepCopy() const {
   arrayLocker();
-  ++ref;
-  return ref;
+  Array *a = new Array(xref);
+  a->size = a->length = length;
+  a->elems = (Object *)gmallocn(length, sizeof(Object));
+  for (int i = 0; i < length; ++i) {
+    a->elems[i].initNullAfterMalloc();
+    a->elems[i] = elems[i].deepCopy();
+  }
+  return a;
+}
+
+int Array::incRef() {
+  return ++ref;
 }
 
 int Array::decRef() {
-  arrayLocker();
-  --ref;
-  return ref;
+  return --ref;
 }
 
 void Array::add(Object &&elem) {
@@ -95,7 +141,14 @@ void Array::add(Object &&elem) {
     } else {
       size *= 2;
     }
-    elems = (Object *)greallocn(elems, size, sizeof(Object));
+    if (elemsInline) {
+      Object *elemsA = (Object *)gmallocn(size, sizeof(Object));
+      memcpy(static_cast<void*>(elemsA), elems, length * sizeof(Object));
+      elems = elemsA;
+      elemsInline = gFalse;
+    } else {
+      elems = (Object *)greallocn(elems, size, sizeof(Object));
+    }
   }
   elems[length].initNullAfterMalloc();
   elems[length] = std::move(elem);
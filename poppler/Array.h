@@ -33,7 +33,12 @@
 
 #include "poppler-config.h"
 #include "Object.h"
+#include "goo/gmem.h"
 #include "goo/GooMutex.h"
+#ifdef MULTITHREADED
+#include <atomic>
+#include <mutex>
+#endif
 
 class XRef;
 
@@ -46,6 +51,15 @@ public:
 
   // Constructor.
   Array(XRef *xrefA);
+  // Constructor for the <lengthA> elements in <elemsA>, which become
+  // dead objects.  They are stored in the same block as the array: it
+  // must be created with new (lengthA).
+  Array(XRef *xrefA, Object *elemsA, int lengthA);
+
+  static void *operator new(size_t size) { return gmalloc(size); }
+  static void *operator new(size_t size, int nElems);
+  static void operator delete(void *p) { gfree(p); }
+  static void operator delete(void *p, int) { gfree(p); }
 
   // Destructor.
   ~Array();
@@ -59,6 +73,9 @@ public:
   // Copy array with new xref
   Object copy(XRef *xrefA) const;
 
+  // Copy array, and the arrays and dictionaries in it, recursively.
+  Array *deepCopy() const;
+
   // Add an element
   // elem becomes a dead object after this call
   void add(Object &&elem);
@@ -80,11 +97,18 @@ private:
 
   XRef *xref;			// the xref table for this PDF file
   Object *elems;		// array of elements
+  GBool elemsInline;		// <elems> follows the Array in its block
   int size;			// size of <elems> array
   int length;			// number of elements in array
-  int ref;			// reference count
 #ifdef MULTITHREADED
+  std::atomic_int ref;		// reference count
+  mutable std::once_flag mutexOnce; // <mutex> is set up when first locked
+  mutable GBool mutexInit;	// set once <mutex> is set up
   mutable GooMutex mutex;
+
+  GooMutex *getMutex() const;
+#else
+  int ref;			// reference count
 #endif
 };
 
@@ -64,6 +64,7 @@ static void str_term_source(j_decompress_ptr cinfo)
 DCTStream::DCTStream(Stream *strA, int colorXformA, Dict *dict, int recursion) :
   FilterStream(strA) {
   colorXform = colorXformA;
+  minWidth = minHeight = 0;
   if (dict != nullptr) {
     Object obj = dict->lookup("Width", recursion);
     err.width = (obj.isInt() && obj.getInt() <= JPEG_MAX_DIMENSION) ? obj.getInt() : 0;
@@ -116,7 +117,10 @@ void DCTStream::init()
 
 void DCTStream::reset() {
   int row_stride;
+  // the hint is only good for this reset
+  int minW = minWidth, minH = minHeight;
 
+  minWidth = minHeight = 0;
   str->reset();
 
   if (row_buffer)
@@ -188,6 +192,23 @@ void DCTStream::reset() {
 	break;
       }
 
+      // libjpeg decodes at 1/2, 1/4 or 1/8 of the size by only running
+      // the IDCT on the low frequencies, which is much cheaper than
+      // decoding everything to scale it down afterwards.  Only when the
+      // JPEG data agrees with the image dictionary on the size.
+      if (minW > 0 && minH > 0 &&
+	  (int)cinfo.image_width == err.width &&
+	  (int)cinfo.image_height == err.height) {
+	for (int denom = 8; denom > 1; denom >>= 1) {
+	  if ((int)(cinfo.image_width + denom - 1) / denom >= minW &&
+	      (int)(cinfo.image_height + denom - 1) / denom >= minH) {
+	    cinfo.scale_num = 1;
+	    cinfo.scale_denom = denom;
+	    break;
+	  }
+	}
+      }
+
       jpeg_start_decompress(&cinfo);
 
       row_stride = cinfo.output_width * cinfo.output_components;
@@ -196,6 +217,21 @@ void DCTStream::reset() {
   }
 }
 
+void DCTStream::setMinImageSize(int minWidthA, int minHeightA) {
+  minWidth = minWidthA;
+  minHeight = minHeightA;
+}
+
+GBool DCTStream::getReducedImageSize(int *widthA, int *heightA) {
+  if (!row_buffer || (cinfo.output_width == cinfo.image_width &&
+		      cinfo.output_height == cinfo.image_height)) {
+    return gFalse;
+  }
+  *widthA = cinfo.output_width;
+  *heightA = cinfo.output_height;
+  return gTrue;
+}
+
 // we can not go with inline since gcc
 // refuses to inline because of setjmp
 #define DO_GET_CHAR \
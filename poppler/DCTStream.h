@@ -72,6 +72,9 @@ public:
   int lookChar() override;
   GooString *getPSFilter(int psLevel, const char *indent) override;
   GBool isBinary(GBool last = gTrue) override;
+  GBool usesImageHints() override { return gTrue; }
+  void setMinImageSize(int minWidthA, int minHeightA) override;
+  GBool getReducedImageSize(int *widthA, int *heightA) override;
 
 private:
   void init();
@@ -80,6 +83,8 @@ private:
   int getChars(int nChars, Guchar *buffer) override;
 
   int colorXform;
+  int minWidth, minHeight;	// size hint for the next reset(),
+				//   0 to decode at full size
   JSAMPLE *current;
   JSAMPLE *limit;
   struct jpeg_decompress_struct cinfo;
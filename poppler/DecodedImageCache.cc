@@ -0,0 +1,213 @@
+//========================================================================
+//
+// DecodedImageCache.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+//========================================================================
+
+#include <config.h>
+
+#include "DecodedImageCache.h"
+
+#include <limits.h>
+#include <string.h>
+
+#include "goo/gmem.h"
+#include "Object.h"
+#include "PopplerCache.h"
+#include "Stream.h"
+#include "XRef.h"
+
+// at most this many images are remembered, most of them only as seen once
+#define decodedImageCacheSize 1024
+
+//------------------------------------------------------------------------
+// DecodedImageData
+//------------------------------------------------------------------------
+
+// The decoded data of an image, shared by the cache and the streams
+// reading it.  The reference count is protected by the cache lock.
+struct DecodedImageData {
+  char *buf;
+  int length;
+  int refCnt;
+};
+
+static void releaseImageData(PopplerCache *cache, DecodedImageData *data) {
+  GBool done;
+
+  cache->lock();
+  done = --data->refCnt == 0;
+  cache->unlock();
+  if (done) {
+    gfree(data->buf);
+    delete data;
+  }
+}
+
+//------------------------------------------------------------------------
+// DecodedImageKey / DecodedImageItem
+//------------------------------------------------------------------------
+
+namespace {
+
+class DecodedImageKey : public PopplerCacheKey {
+public:
+  DecodedImageKey(Ref refA, int widthA, int heightA, int nCompsA, int nBitsA,
+		  Guint modificationCountA)
+    : ref(refA), width(widthA), height(heightA), nComps(nCompsA),
+      nBits(nBitsA), modificationCount(modificationCountA)
+  {
+  }
+
+  bool operator==(const PopplerCacheKey &key) const override
+  {
+    const DecodedImageKey *k = static_cast<const DecodedImageKey*>(&key);
+    return k->ref.num == ref.num && k->ref.gen == ref.gen &&
+           k->width == width && k->height == height &&
+           k->nComps == nComps && k->nBits == nBits &&
+           k->modificationCount == modificationCount;
+  }
+
+  size_t hash() const override
+  {
+    return ((size_t)ref.num << 8) ^ ref.gen ^ ((size_t)width << 16) ^ height;
+  }
+
+  Ref ref;
+  int width, height, nComps, nBits;
+  // the object behind ref changes when the document is modified
+  Guint modificationCount;
+};
+
+class DecodedImageItem : public PopplerCacheItem {
+public:
+  // data is NULL for an image only seen once so far
+  DecodedImageItem(PopplerCache *cacheA, DecodedImageData *dataA)
+    : cache(cacheA), data(dataA)
+  {
+  }
+
+  ~DecodedImageItem()
+  {
+    if (data) {
+      // called with the cache locked, the lock is recursive
+      releaseImageData(cache, data);
+    }
+  }
+
+  PopplerCache *cache;
+  DecodedImageData *data;
+};
+
+}
+
+//------------------------------------------------------------------------
+// DecodedImageStream
+//------------------------------------------------------------------------
+
+class DecodedImageStream : public MemStream {
+public:
+  DecodedImageStream(PopplerCache *cacheA, DecodedImageData *dataA)
+    : MemStream(dataA->buf, 0, dataA->length, Object(objNull)),
+      cache(cacheA), data(dataA)
+  {
+  }
+
+  ~DecodedImageStream()
+  {
+    releaseImageData(cache, data);
+  }
+
+private:
+  PopplerCache *cache;
+  DecodedImageData *data;
+};
+
+//------------------------------------------------------------------------
+// DecodedImageCache
+//------------------------------------------------------------------------
+
+DecodedImageCache::DecodedImageCache(size_t maxCostA) {
+  maxCost = maxCostA;
+  cache = new PopplerCache(decodedImageCacheSize, maxCost, true);
+  hits = 0;
+  misses = 0;
+}
+
+DecodedImageCache::~DecodedImageCache() {
+  delete cache;
+}
+
+void DecodedImageCache::clear() {
+  cache->clear();
+}
+
+Stream *DecodedImageCache::getImageStream(XRef *xref, Object *ref, Stream *str,
+					  int width, int height,
+					  int nComps, int nBits) {
+  DecodedImageItem *item;
+  DecodedImageData *data;
+  int lineSize, length, n;
+
+  // inline images and images that aren't indirect objects can't be told
+  // apart from other ones
+  if (!ref || !ref->isRef() || !xref) {
+    return str;
+  }
+
+  // same line size as ImageStream
+  if (width <= 0 || height <= 0 || nComps <= 0 || nBits <= 0 ||
+      width > INT_MAX / nComps || width * nComps > INT_MAX / nBits - 7) {
+    return str;
+  }
+  lineSize = (width * nComps * nBits + 7) >> 3;
+  if (lineSize > INT_MAX / height) {
+    return str;
+  }
+  length = lineSize * height;
+  // don't let a single image flush everything else
+  if ((size_t)length > maxCost / 2) {
+    return str;
+  }
+
+  DecodedImageKey key(ref->getRef(), width, height, nComps, nBits,
+		      xref->getModificationCount());
+  cache->lock();
+  item = static_cast<DecodedImageItem *>(cache->lookup(key));
+  if (item && item->data) {
+    data = item->data;
+    ++data->refCnt;
+    ++hits;
+    cache->unlock();
+    return new DecodedImageStream(cache, data);
+  }
+  ++misses;
+  if (!item) {
+    // only keep the data of images drawn at least twice, most images
+    // are drawn only once
+    cache->put(new DecodedImageKey(key.ref, width, height, nComps, nBits,
+				   key.modificationCount),
+	       new DecodedImageItem(cache, nullptr));
+    cache->unlock();
+    return str;
+  }
+  cache->unlock();
+
+  // decode the whole image, ImageStream would read EOF as 0xff
+  data = new DecodedImageData;
+  data->buf = (char *)gmalloc(length);
+  data->length = length;
+  data->refCnt = 2;
+  str->reset();
+  n = str->doGetChars(length, (Guchar *)data->buf);
+  if (n < length) {
+    memset(data->buf + n, 0xff, length - n);
+  }
+
+  cache->put(new DecodedImageKey(key.ref, width, height, nComps, nBits,
+				 key.modificationCount),
+	     new DecodedImageItem(cache, data), length);
+  return new DecodedImageStream(cache, data);
+}
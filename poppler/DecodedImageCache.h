@@ -0,0 +1,67 @@
+//========================================================================
+//
+// DecodedImageCache.h
+//
+// This file is licensed under the GPLv2 or later
+//
+//========================================================================
+
+#ifndef DECODEDIMAGECACHE_H
+#define DECODEDIMAGECACHE_H
+
+#include <stddef.h>
+
+#include "goo/gtypes.h"
+
+class Object;
+class PopplerCache;
+class Stream;
+class XRef;
+
+//------------------------------------------------------------------------
+// DecodedImageCache
+//
+// Keeps the decoded (i.e. unfiltered) data of image XObjects that are
+// drawn more than once, typically a logo or background repeated on
+// every page, so that the DCT/JPX/Flate/... filters don't have to run
+// again each time.
+//------------------------------------------------------------------------
+
+class DecodedImageCache {
+public:
+
+  // Keeps at most maxCostA bytes of decoded data
+  DecodedImageCache(size_t maxCostA);
+  ~DecodedImageCache();
+
+  DecodedImageCache(const DecodedImageCache &) = delete;
+  DecodedImageCache& operator=(const DecodedImageCache &other) = delete;
+
+  // Returns the stream to read the data of the image <str> from, with
+  // the parameters an ImageStream would be given for it.  That is <str>
+  // itself, or a stream over the cached data if <ref> is the reference
+  // of an image XObject already seen.  In the later case <str> might not
+  // be read at all, and the stream returned must be deleted by the
+  // caller once done.
+  Stream *getImageStream(XRef *xref, Object *ref, Stream *str,
+			 int width, int height, int nComps, int nBits);
+
+  // Forgets all the images
+  void clear();
+
+  // The number of images drawn from cached data / the number of images
+  // that had to be decoded
+  unsigned long getNumHits() { return hits; }
+  unsigned long getNumMisses() { return misses; }
+
+private:
+
+  friend class DecodedImageStream;
+
+  PopplerCache *cache;
+  size_t maxCost;
+  unsigned long hits;
+  unsigned long misses;
+};
+
+#endif
@@ -568,6 +568,73 @@ int DecryptStream::lookChar() {
   return (nextCharBuff = c);
 }
 
+int DecryptStream::getChars(int nChars, Guchar *buffer) {
+  Guchar in[16];
+  int n, m, i;
+
+  if (nChars <= 0) {
+    return 0;
+  }
+  n = 0;
+  if (nextCharBuff != EOF) {
+    buffer[n++] = (Guchar)nextCharBuff;
+    nextCharBuff = EOF;
+  }
+
+  switch (algo) {
+  case cryptRC4:
+    m = str->doGetChars(nChars - n, buffer + n);
+    for (i = n; i < n + m; ++i) {
+      buffer[i] = rc4DecryptByte(state.rc4.state, &state.rc4.x, &state.rc4.y,
+				 buffer[i]);
+    }
+    n += m;
+    break;
+  case cryptAES:
+    while (n < nChars) {
+      if (state.aes.bufIdx == 16) {
+	if (aesReadBlock(str, in, gFalse)) {
+	  aesDecryptBlock(&state.aes, in, str->lookChar() == EOF);
+	}
+	if (state.aes.bufIdx == 16) {
+	  break;
+	}
+      }
+      m = 16 - state.aes.bufIdx;
+      if (m > nChars - n) {
+	m = nChars - n;
+      }
+      memcpy(buffer + n, state.aes.buf + state.aes.bufIdx, m);
+      state.aes.bufIdx += m;
+      n += m;
+    }
+    break;
+  case cryptAES256:
+    while (n < nChars) {
+      if (state.aes256.bufIdx == 16) {
+	if (aesReadBlock(str, in, gFalse)) {
+	  aes256DecryptBlock(&state.aes256, in, str->lookChar() == EOF);
+	}
+	if (state.aes256.bufIdx == 16) {
+	  break;
+	}
+      }
+      m = 16 - state.aes256.bufIdx;
+      if (m > nChars - n) {
+	m = nChars - n;
+      }
+      memcpy(buffer + n, state.aes256.buf + state.aes256.bufIdx, m);
+      state.aes256.bufIdx += m;
+      n += m;
+    }
+    break;
+  case cryptNone:
+    break;
+  }
+  charactersRead += n;
+  return n;
+}
+
 //------------------------------------------------------------------------
 // RC4-compatible decryption
 //------------------------------------------------------------------------
@@ -614,14 +681,7 @@ static GBool aesReadBlock(Stream *str, Guchar *in, GBool addPadding)
 {
   int c, i;
 
-  for (i = 0; i < 16; ++i) {
-    if ((c = str->getChar()) != EOF) {
-      in[i] = (Guchar)c;
-    } else {
-      break;
-    }
-  }
-
+  i = str->doGetChars(16, in);
   if (i == 16) {
     return gTrue;
   } else {
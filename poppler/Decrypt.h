@@ -152,6 +152,11 @@ public:
   ~DecryptStream();
   void reset() override;
   int lookChar() override;
+
+private:
+
+  GBool hasGetChars() override { return true; }
+  int getChars(int nChars, Guchar *buffer) override;
 };
  
 //------------------------------------------------------------------------
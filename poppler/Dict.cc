@@ -43,7 +43,7 @@
 #include "Dict.h"
 
 #ifdef MULTITHREADED
-#  define dictLocker()   MutexLocker locker(&mutex)
+#  define dictLocker()   MutexLocker locker(getMutex())
 #else
 #  define dictLocker()
 #endif
@@ -79,11 +79,12 @@ static int binarySearch(const char *key, DictEntry *entries, int length)
 Dict::Dict(XRef *xrefA) {
   xref = xrefA;
   entries = nullptr;
+  entriesInline = gFalse;
   size = length = 0;
   ref = 1;
   sorted = gFalse;
 #ifdef MULTITHREADED
-  gInitMutex(&mutex);
+  mutexInit = gFalse;
 #endif
 }
 
@@ -92,18 +93,54 @@ Dict::Dict(Dict* dictA) {
   size = length = dictA->length;
   ref = 1;
 #ifdef MULTITHREADED
-  gInitMutex(&mutex);
+  mutexInit = gFalse;
 #endif
 
   sorted = dictA->sorted;
   entries = (DictEntry *)gmallocn(size, sizeof(DictEntry));
+  entriesInline = gFalse;
   for (int i=0; i<length; i++) {
-    entries[i].key = copyString(dictA->entries[i].key);
+    entries[i].key = isInternedName(dictA->entries[i].key) ?
+                       dictA->entries[i].key : copyString(dictA->entries[i].key);
     entries[i].val.initNullAfterMalloc();
     entries[i].val = dictA->entries[i].val.copy();
   }
 }
 
+Dict::Dict(XRef *xrefA, char **keys, Object *vals, int lengthA) {
+  xref = xrefA;
+  size = length = lengthA;
+  ref = 1;
+  sorted = gFalse;
+#ifdef MULTITHREADED
+  mutexInit = gFalse;
+#endif
+
+  entries = (DictEntry *)(this + 1);
+  entriesInline = gTrue;
+  for (int i = 0; i < length; ++i) {
+    entries[i].key = keys[i];
+    entries[i].val.initNullAfterMalloc();
+    entries[i].val = std::move(vals[i]);
+  }
+}
+
+void *Dict::operator new(size_t size, int nEntries) {
+  return gmalloc(size + (size_t)nEntries * sizeof(DictEntry));
+}
+
+#ifdef MULTITHREADED
+// Most dictionaries, like those of content streams, are never modified
+// nor sorted, so they don't need a mutex at all.
+GooMutex *Dict::getMutex() const {
+  std::call_once(mutexOnce, [this] {
+    gInitMutex(&mutex);
+    mutexInit = gTrue;
+  });
+  return &mutex;
+}
+#endif
+
 Dict *Dict::copy(XRef *xrefA) {
   dictLocker();
   Dict *dictA = new Dict(this);
@@ -121,25 +158,40 @@ Dict::~Dict() {
   int i;
 
   for (i = 0; i < length; ++i) {
-    gfree(entries[i].key);
+    freeName(entries[i].key);
     entries[i].val.free();
   }
-  gfree(entries);
+  if (!entriesInline) {
+    gfree(entries);
+  }
 #ifdef MULTITHREADED
-  gDestroyMutex(&mutex);
+  if (mutexInit) {
+    gDestroyMutex(&mutex);
+  }
 #endif
 }
 
-int Dict::incRef() {
+Dict *Dict::deepCopy() const {
   dictLocker();
-  ++ref;
-  return ref;
+  Dict *dictA = new Dict(xref);
+  dictA->size = dictA->length = length;
+  dictA->sorted = sorted;
+  dictA->entries = (DictEntry *)gmallocn(length, sizeof(DictEntry));
+  for (int i = 0; i < length; ++i) {
+    dictA->entries[i].key = isInternedName(entries[i].key) ?
+                              entries[i].key : copyString(entries[i].key);
+    dictA->entries[i].val.initNullAfterMalloc();
+    dictA->entries[i].val = entries[i].val.deepCopy();
+  }
+  return dictA;
+}
+
+int Dict::incRef() {
+  return ++ref;
 }
 
 int Dict::decRef() {
-  dictLocker();
-  --ref;
-  return ref;
+  return --ref;
 }
 
 void Dict::add(char *key, Object &&val) {
@@ -156,7 +208,14 @@ void Dict::add(char *key, Object &&val) {
     } else {
       size *= 2;
     }
-    entries = (DictEntry *)greallocn(entries, size, sizeof(DictEntry));
+    if (entriesInline) {
+      DictEntry *entriesA = (DictEntry *)gmallocn(size, sizeof(DictEntry));
+      memcpy(static_cast<void*>(entriesA), entries, length * sizeof(DictEntry));
+      entries = entriesA;
+      entriesInline = gFalse;
+    } else {
+      entries = (DictEntry *)greallocn(entries, size, sizeof(DictEntry));
+    }
   }
   entries[length].key = key;
   entries[length].val.initNullAfterMalloc();
@@ -198,7 +257,7 @@ void Dict::remove(const char *key) {
     const int pos = binarySearch(key, entries, length);
     if (pos != -1) {
       length -= 1;
-      gfree(entries[pos].key);
+      freeName(entries[pos].key);
       entries[pos].val.free();
       if (pos != length) {
         memmove(static_cast<void*>(&entries[pos]), &entries[pos + 1], (length - pos) * sizeof(DictEntry));
@@ -221,7 +280,7 @@ void Dict::remove(const char *key) {
       return;
     }
     //replace the deleted entry with the last entry
-    gfree(entries[i].key);
+    freeName(entries[i].key);
     entries[i].val.free();
     length -= 1;
     if (i!=length) {
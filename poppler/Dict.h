@@ -35,7 +35,12 @@
 
 #include "poppler-config.h"
 #include "Object.h"
+#include "goo/gmem.h"
 #include "goo/GooMutex.h"
+#ifdef MULTITHREADED
+#include <atomic>
+#include <mutex>
+#endif
 
 //------------------------------------------------------------------------
 // Dict
@@ -52,7 +57,19 @@ public:
   // Constructor.
   Dict(XRef *xrefA);
   Dict(Dict* dictA);
+  // Constructor for the <lengthA> entries in <keys> and <vals>, which
+  // are stored in the same block as the dictionary: it must be created
+  // with new (lengthA).  Takes over the keys, like add(), and the values
+  // become dead objects.
+  Dict(XRef *xrefA, char **keys, Object *vals, int lengthA);
+
+  static void *operator new(size_t size) { return gmalloc(size); }
+  static void *operator new(size_t size, int nEntries);
+  static void operator delete(void *p) { gfree(p); }
+  static void operator delete(void *p, int) { gfree(p); }
   Dict *copy(XRef *xrefA);
+  // Copy the dictionary, and the arrays and dictionaries in it, recursively.
+  Dict *deepCopy() const;
 
   // Destructor.
   ~Dict();
@@ -63,7 +80,7 @@ public:
   // Get number of entries.
   int getLength() const { return length; }
 
-  // Add an entry.  NB: does not copy key.
+  // Add an entry.  NB: does not copy key, which is freed with freeName().
   // val becomes a dead object after the call
   void add(char *key, Object &&val);
 
@@ -106,11 +123,18 @@ private:
   mutable GBool sorted;
   XRef *xref;			// the xref table for this PDF file
   DictEntry *entries;		// array of entries
+  GBool entriesInline;		// <entries> follows the Dict in its block
   int size;			// size of <entries> array
   int length;			// number of entries in dictionary
-  int ref;			// reference count
 #ifdef MULTITHREADED
+  std::atomic_int ref;		// reference count
+  mutable std::once_flag mutexOnce; // <mutex> is set up when first locked
+  mutable GBool mutexInit;	// set once <mutex> is set up
   mutable GooMutex mutex;
+
+  GooMutex *getMutex() const;
+#else
+  int ref;			// reference count
 #endif
 
   DictEntry *find(const char *key) const;
@@ -0,0 +1,317 @@
+//========================================================================
+//
+// DisplayList.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+//========================================================================
+
+#include <config.h>
+
+#include "DisplayList.h"
+
+#include <string.h>
+
+#include "goo/GooString.h"
+#include "Error.h"
+#include "Gfx.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "PopplerCache.h"
+#include "XRef.h"
+
+//------------------------------------------------------------------------
+// DisplayList
+//------------------------------------------------------------------------
+
+static size_t objectCost(Object *obj) {
+  size_t cost;
+  int i;
+
+  cost = sizeof(Object);
+  switch (obj->getType()) {
+  case objString:
+    cost += obj->getString()->getLength();
+    break;
+  case objName:
+    cost += strlen(obj->getName()) + 1;
+    break;
+  case objCmd:
+    cost += strlen(obj->getCmd()) + 1;
+    break;
+  case objArray:
+    for (i = 0; i < obj->arrayGetLength(); ++i) {
+      Object elem = obj->arrayGetNF(i);
+      cost += objectCost(&elem);
+    }
+    break;
+  case objDict:
+    for (i = 0; i < obj->dictGetLength(); ++i) {
+      Object val = obj->dictGetValNF(i);
+      cost += strlen(obj->dictGetKey(i)) + 1 + objectCost(&val);
+    }
+    break;
+  default:
+    break;
+  }
+  return cost;
+}
+
+DisplayList *DisplayList::parse(XRef *xref, Object *obj, size_t maxCost) {
+  DisplayList *list;
+  Object cmdArgs[maxArgs];
+  int numArgs;
+
+  list = new DisplayList();
+  Parser parser(xref, new Lexer(xref, obj), gFalse);
+  numArgs = 0;
+  Object o = parser.getObj();
+  while (!o.isEOF()) {
+    if (o.isCmd()) {
+      // the image data follows BI/ID in the content stream
+      if (o.isCmd("BI")) {
+	list->decRefCnt();
+	return nullptr;
+      }
+      list->addCmd(o.getCmd(), cmdArgs, numArgs, &o);
+      numArgs = 0;
+    } else if (numArgs < maxArgs) {
+      cmdArgs[numArgs++] = std::move(o);
+    } else {
+      error(errSyntaxError, parser.getPos(), "Too many args in content stream");
+    }
+    if (list->cost > maxCost) {
+      list->decRefCnt();
+      return nullptr;
+    }
+    o = parser.getObj();
+  }
+
+  // args at end with no command
+  if (numArgs > 0) {
+    error(errSyntaxError, parser.getPos(), "Leftover args in content stream");
+  }
+
+  list->cmds.shrink_to_fit();
+  list->nums.shrink_to_fit();
+  list->args.shrink_to_fit();
+  return list;
+}
+
+void DisplayList::addCmd(const char *name, Object *cmdArgs, int numArgs,
+			 Object *cmd) {
+  Operator *op;
+  Cmd c;
+  int i;
+
+  op = Gfx::findOp(name);
+  c.opIdx = op ? op - Gfx::opTab : -1;
+  c.numArgs = numArgs;
+  c.intArgs = 0;
+  c.packed = op != nullptr && numArgs <= 32;
+  for (i = 0; i < numArgs && c.packed; ++i) {
+    c.packed = cmdArgs[i].isInt() || cmdArgs[i].isReal();
+  }
+
+  if (c.packed) {
+    c.firstArg = nums.size();
+    for (i = 0; i < numArgs; ++i) {
+      if (cmdArgs[i].isInt()) {
+	c.intArgs |= 1u << i;
+      }
+      nums.push_back(cmdArgs[i].getNum());
+      cmdArgs[i].setToNull();
+    }
+    cost += numArgs * sizeof(double);
+  } else {
+    c.firstArg = args.size();
+    for (i = 0; i < numArgs; ++i) {
+      cost += objectCost(&cmdArgs[i]);
+      args.push_back(std::move(cmdArgs[i]));
+    }
+    if (!op) {
+      cost += objectCost(cmd);
+      args.push_back(std::move(*cmd));
+    }
+  }
+  cmds.push_back(c);
+  cost += sizeof(Cmd);
+}
+
+DisplayList::DisplayList() {
+  cost = sizeof(DisplayList);
+  refCnt = 1;
+#ifdef MULTITHREADED
+  gInitMutex(&mutex);
+#endif
+}
+
+DisplayList::~DisplayList() {
+#ifdef MULTITHREADED
+  gDestroyMutex(&mutex);
+#endif
+}
+
+void DisplayList::incRefCnt() {
+#ifdef MULTITHREADED
+  gLockMutex(&mutex);
+#endif
+  ++refCnt;
+#ifdef MULTITHREADED
+  gUnlockMutex(&mutex);
+#endif
+}
+
+void DisplayList::decRefCnt() {
+  GBool done;
+
+#ifdef MULTITHREADED
+  gLockMutex(&mutex);
+#endif
+  done = --refCnt == 0;
+#ifdef MULTITHREADED
+  gUnlockMutex(&mutex);
+#endif
+  if (done) {
+    delete this;
+  }
+}
+
+Operator *DisplayList::getOp(int i) {
+  const Cmd &cmd = cmds[i];
+
+  return cmd.opIdx >= 0 ? &Gfx::opTab[cmd.opIdx] : nullptr;
+}
+
+const char *DisplayList::getOpName(int i) {
+  const Cmd &cmd = cmds[i];
+
+  if (cmd.opIdx >= 0) {
+    return Gfx::opTab[cmd.opIdx].name;
+  }
+  return args[cmd.firstArg + cmd.numArgs].getCmd();
+}
+
+Object *DisplayList::getArgs(int i, Object *buf) {
+  const Cmd &cmd = cmds[i];
+  const double *num;
+  int j;
+
+  if (!cmd.packed) {
+    return &args[cmd.firstArg];
+  }
+  num = &nums[cmd.firstArg];
+  for (j = 0; j < cmd.numArgs; ++j) {
+    if (cmd.intArgs & (1u << j)) {
+      buf[j] = Object((int)num[j]);
+    } else {
+      buf[j] = Object(num[j]);
+    }
+  }
+  return buf;
+}
+
+//------------------------------------------------------------------------
+// DisplayListKey / DisplayListItem
+//------------------------------------------------------------------------
+
+namespace {
+
+class DisplayListKey : public PopplerCacheKey {
+public:
+  DisplayListKey(Ref refA, Guint modificationCountA)
+    : ref(refA), modificationCount(modificationCountA)
+  {
+  }
+
+  bool operator==(const PopplerCacheKey &key) const override
+  {
+    const DisplayListKey *k = static_cast<const DisplayListKey*>(&key);
+    return k->ref.num == ref.num && k->ref.gen == ref.gen &&
+           k->modificationCount == modificationCount;
+  }
+
+  size_t hash() const override
+  {
+    return ((size_t)ref.num << 8) ^ ref.gen;
+  }
+
+  Ref ref;
+  // the object behind ref changes when the document is modified
+  Guint modificationCount;
+};
+
+class DisplayListItem : public PopplerCacheItem {
+public:
+  // list is NULL for a stream that can't have a display list
+  DisplayListItem(DisplayList *listA) : list(listA)
+  {
+  }
+
+  ~DisplayListItem()
+  {
+    if (list) {
+      list->decRefCnt();
+    }
+  }
+
+  DisplayList *list;
+};
+
+}
+
+//------------------------------------------------------------------------
+// DisplayListCache
+//------------------------------------------------------------------------
+
+// at most this many lists are kept, whatever their cost
+#define displayListCacheSize 1024
+
+DisplayListCache::DisplayListCache(size_t maxCostA) {
+  maxCost = maxCostA;
+  cache = new PopplerCache(displayListCacheSize, maxCost, true);
+  hits = 0;
+  misses = 0;
+}
+
+DisplayListCache::~DisplayListCache() {
+  delete cache;
+}
+
+void DisplayListCache::clear() {
+  cache->clear();
+}
+
+DisplayList *DisplayListCache::getDisplayList(XRef *xref, Object *ref,
+					      Object *str) {
+  DisplayListItem *item;
+  DisplayList *list;
+
+  if (!ref || !ref->isRef() || ref->getRefNum() < 0 || !xref) {
+    return nullptr;
+  }
+
+  DisplayListKey key(ref->getRef(), xref->getModificationCount());
+  cache->lock();
+  item = static_cast<DisplayListItem *>(cache->lookup(key));
+  if (item) {
+    list = item->list;
+    if (list) {
+      list->incRefCnt();
+      ++hits;
+    }
+    cache->unlock();
+    return list;
+  }
+  ++misses;
+  cache->unlock();
+
+  // don't let a single list flush everything else
+  list = DisplayList::parse(xref, str, maxCost / 2);
+  if (list) {
+    list->incRefCnt();
+  }
+  cache->put(new DisplayListKey(key.ref, key.modificationCount),
+	     new DisplayListItem(list), list ? list->getCost() : 0);
+  return list;
+}
@@ -0,0 +1,138 @@
+//========================================================================
+//
+// DisplayList.h
+//
+// This file is licensed under the GPLv2 or later
+//
+//========================================================================
+
+#ifndef DISPLAYLIST_H
+#define DISPLAYLIST_H
+
+#include "poppler-config.h"
+
+#include <stddef.h>
+#include <vector>
+
+#include "goo/gtypes.h"
+#include "Object.h"
+
+#ifdef MULTITHREADED
+#include "goo/GooMutex.h"
+#endif
+
+class PopplerCache;
+class XRef;
+struct Operator;
+
+//------------------------------------------------------------------------
+// DisplayList
+//
+// A content stream split in commands once, with the operators already
+// looked up, so that it can be run by Gfx any number of times without
+// going through the Lexer and Parser again.  The operands of commands
+// taking only numbers, the vast majority, are packed as doubles instead
+// of being kept as Objects.  A display list is never modified once built
+// and can be shared by several threads.
+//------------------------------------------------------------------------
+
+class DisplayList {
+public:
+
+  // Splits the content stream, or array of content streams, <obj> in
+  // commands.  Sets the initial reference count to 1.  Returns NULL if
+  // it has inline images, whose data can only be read straight from the
+  // content stream, or if it takes more than <maxCost> bytes.
+  static DisplayList *parse(XRef *xref, Object *obj, size_t maxCost);
+
+  DisplayList(const DisplayList &) = delete;
+  DisplayList& operator=(const DisplayList &other) = delete;
+
+  void incRefCnt();
+  void decRefCnt();
+
+  int getNumCmds() { return cmds.size(); }
+
+  // The operator of command <i>, NULL if it is unknown.
+  Operator *getOp(int i);
+
+  // The name of the operator of command <i>.
+  const char *getOpName(int i);
+
+  // The arguments of command <i>.  Packed numbers are unpacked into
+  // <buf>, which must have room for maxArgs objects.
+  Object *getArgs(int i, Object *buf);
+  int getNumArgs(int i) { return cmds[i].numArgs; }
+
+  // Approximate memory used by the list, in bytes.
+  size_t getCost() { return cost; }
+
+private:
+
+  struct Cmd {
+    short opIdx;		// index in Gfx::opTab, -1 if unknown
+    Guchar numArgs;
+    Guchar packed;		// are the arguments in nums?
+    int firstArg;		// index of the first argument in nums
+				//   or args
+    Guint intArgs;		// packed arguments that are integers,
+				//   one bit per argument
+  };
+
+  DisplayList();
+  ~DisplayList();
+
+  void addCmd(const char *name, Object *cmdArgs, int numArgs, Object *cmd);
+
+  std::vector<Cmd> cmds;
+  // packed arguments
+  std::vector<double> nums;
+  // other arguments; the arguments of an unknown operator are followed
+  // by the operator itself
+  std::vector<Object> args;
+  size_t cost;
+  int refCnt;
+#ifdef MULTITHREADED
+  GooMutex mutex;
+#endif
+};
+
+//------------------------------------------------------------------------
+// DisplayListCache
+//
+// The display lists of the content streams of a document that are drawn
+// repeatedly, e.g. Form XObjects, keyed by the reference of the stream.
+//------------------------------------------------------------------------
+
+class DisplayListCache {
+public:
+
+  // Keeps at most <maxCostA> bytes of display lists.
+  DisplayListCache(size_t maxCostA);
+  ~DisplayListCache();
+
+  DisplayListCache(const DisplayListCache &) = delete;
+  DisplayListCache& operator=(const DisplayListCache &other) = delete;
+
+  // Returns the display list of the content stream <str>, <ref> being
+  // the reference it was fetched from, building it if needed.  The
+  // caller must decRefCnt() the list once done.  Returns NULL if there
+  // can't be a list for <str>, it has to be parsed directly then.
+  DisplayList *getDisplayList(XRef *xref, Object *ref, Object *str);
+
+  // Forgets all the lists.
+  void clear();
+
+  // The number of lists found in the cache / built.
+  unsigned long getNumHits() { return hits; }
+  unsigned long getNumMisses() { return misses; }
+
+private:
+
+  PopplerCache *cache;
+  size_t maxCost;
+  unsigned long hits;
+  unsigned long misses;
+};
+
+#endif
@@ -28,100 +28,160 @@ FlateStream::FlateStream(Stream *strA, int predictor, int columns, int colors, i
 {
   if (predictor != 1) {
     pred = new StreamPredictor(this, predictor, columns, colors, bits);
+    if (!pred->isOk()) {
+      delete pred;
+      pred = NULL;
+    }
   } else {
     pred = NULL;
   }
-  out_pos = 0;
   memset(&d_stream, 0, sizeof(d_stream));
-  inflateInit(&d_stream);
+  zInit = gFalse;
+  eof = gTrue;
+  readAhead = gFalse;
+  out_pos = out_buf_len = 0;
 }
 
 FlateStream::~FlateStream() {
-  inflateEnd(&d_stream);
+  if (zInit) {
+    inflateEnd(&d_stream);
+  }
   delete pred;
   delete str;
 }
 
 void FlateStream::reset() {
-  //FIXME: what are the semantics of reset?
-  //i.e. how much intialization has to happen in the constructor?
+  int cmf, flg;
 
-  /* reinitialize zlib */
-  inflateEnd(&d_stream);
+  if (zInit) {
+    inflateEnd(&d_stream);
+    zInit = gFalse;
+  }
   memset(&d_stream, 0, sizeof(d_stream));
-  inflateInit(&d_stream);
-
+  out_pos = out_buf_len = 0;
+  readAhead = str->canReadAhead();
   str->reset();
-  d_stream.avail_in = 0;
-  status = Z_OK;
-  out_pos = 0;
-  out_buf_len = 0;
+
+  // check the header like the built-in decoder, zlib only gets the
+  // deflate data so that a wrong checksum at the end isn't an error
+  eof = gTrue;
+  cmf = str->getChar();
+  flg = str->getChar();
+  if (cmf == EOF || flg == EOF)
+    return;
+  if ((cmf & 0x0f) != 0x08) {
+    error(errSyntaxError, getPos(), "Unknown compression method in flate stream");
+    return;
+  }
+  if ((((cmf << 8) + flg) % 31) != 0) {
+    error(errSyntaxError, getPos(), "Bad FCHECK in flate stream");
+    return;
+  }
+  if (flg & 0x20) {
+    error(errSyntaxError, getPos(), "FDICT bit set in flate stream");
+    return;
+  }
+  if (inflateInit2(&d_stream, -MAX_WBITS) != Z_OK) {
+    error(errInternal, -1, "Couldn't initialize zlib");
+    return;
+  }
+  zInit = gTrue;
+  eof = gFalse;
 }
 
 int FlateStream::getRawChar() {
   return doGetRawChar();
 }
 
-void FlateStream::getRawChars(int nChars, int *buffer) {
-  for (int i = 0; i < nChars; ++i)
-    buffer[i] = doGetRawChar();
+int FlateStream::getRawChars(int nChars, Guchar *buffer) {
+  int n, m;
+
+  n = 0;
+  while (n < nChars) {
+    if (out_pos >= out_buf_len) {
+      // inflate large requests straight into the caller's buffer
+      if (nChars - n >= flateOutBufSize) {
+	if (!(m = inflateSome(buffer + n, nChars - n))) {
+	  break;
+	}
+	n += m;
+	continue;
+      }
+      if (!fill_buffer()) {
+	break;
+      }
+    }
+    m = out_buf_len - out_pos;
+    if (m > nChars - n) {
+      m = nChars - n;
+    }
+    memcpy(buffer + n, out_buf + out_pos, m);
+    out_pos += m;
+    n += m;
+  }
+  return n;
 }
 
 int FlateStream::getChar() {
   if (pred)
     return pred->getChar();
   else
-    return getRawChar();
+    return doGetRawChar();
 }
 
 int FlateStream::lookChar() {
   if (pred)
     return pred->lookChar();
 
-  if (fill_buffer())
+  if (out_pos >= out_buf_len && !fill_buffer())
     return EOF;
 
   return out_buf[out_pos];
 }
 
-int FlateStream::fill_buffer() {
-  /* only fill the buffer if it has all been used */
-  if (out_pos >= out_buf_len) {
-    /* check if the flatestream has been exhausted */
-    if (status == Z_STREAM_END) {
-      return -1;
-    }
+int FlateStream::getChars(int nChars, Guchar *buffer) {
+  if (pred)
+    return pred->getChars(nChars, buffer);
+  else
+    return getRawChars(nChars, buffer);
+}
 
-    /* set to the begining of out_buf */
-    d_stream.avail_out = sizeof(out_buf);
-    d_stream.next_out = out_buf;
-    out_pos = 0;
-
-    while (1) {
-      /* buffer is empty so we need to fill it */
-      if (d_stream.avail_in == 0) {
-	int c;
-	/* read from the source stream */
-	while (d_stream.avail_in < sizeof(in_buf) && (c = str->getChar()) != EOF) {
-	  in_buf[d_stream.avail_in++] = c;
-	}
-	d_stream.next_in = in_buf;
-      }
+GBool FlateStream::fill_buffer() {
+  out_pos = 0;
+  out_buf_len = inflateSome(out_buf, sizeof(out_buf));
+  return out_buf_len > 0;
+}
 
-      /* keep decompressing until we can't anymore */
-      if (d_stream.avail_out == 0 || d_stream.avail_in == 0 || (status != Z_OK && status != Z_BUF_ERROR))
+// Inflates up to <size> bytes into <out>, returns the number of bytes
+// decoded, 0 at the end of the stream.  The data decoded before an error
+// is returned, like the built-in decoder does, and the input isn't read
+// past the end of the compressed data if the stream doesn't allow it.
+int FlateStream::inflateSome(Guchar *out, int size) {
+  int n, ret;
+
+  d_stream.next_out = out;
+  d_stream.avail_out = size;
+  while (d_stream.avail_out > 0 && !eof) {
+    if (d_stream.avail_in == 0) {
+      n = str->doGetChars(readAhead ? sizeof(in_buf) : 1, in_buf);
+      if (n <= 0) {
+	// truncated stream
+	eof = gTrue;
 	break;
-      status = inflate(&d_stream, Z_SYNC_FLUSH);
+      }
+      d_stream.next_in = in_buf;
+      d_stream.avail_in = n;
+    }
+    ret = inflate(&d_stream, Z_NO_FLUSH);
+    if (ret == Z_STREAM_END) {
+      eof = gTrue;
+    } else if (ret != Z_OK) {
+      error(errSyntaxError, getPos(), "Error in flate stream: {0:s}",
+	    d_stream.msg ? d_stream.msg : "unknown error");
+      eof = gTrue;
     }
-
-    out_buf_len = sizeof(out_buf) - d_stream.avail_out;
-    if (status != Z_OK && status != Z_STREAM_END)
-      return -1;
-    if (!out_buf_len)
-      return -1;
   }
-
-  return 0;
+  return size - d_stream.avail_out;
 }
 
 GooString *FlateStream::getPSFilter(int psLevel, const char *indent) {
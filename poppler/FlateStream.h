@@ -41,35 +41,46 @@ extern "C" {
 #include <zlib.h>
 }
 
+// input is read by blocks of this size when the stream allows it
+#define flateInBufSize 4096
+// and decoded by blocks of this size, unless read in larger blocks
+#define flateOutBufSize 65536
+
 class FlateStream: public FilterStream {
 public:
 
   FlateStream(Stream *strA, int predictor, int columns, int colors, int bits);
-  virtual ~FlateStream();
-  virtual StreamKind getKind() override { return strFlate; }
-  virtual void reset() override;
-  virtual int getChar() override;
-  virtual int lookChar() override;
-  virtual int getRawChar() override;
-  virtual void getRawChars(int nChars, int *buffer) override;
-  virtual GooString *getPSFilter(int psLevel, const char *indent) override;
-  virtual GBool isBinary(GBool last = gTrue) override;
+  ~FlateStream();
+  StreamKind getKind() override { return strFlate; }
+  void reset() override;
+  int getChar() override;
+  int lookChar() override;
+  int getRawChar() override;
+  int getRawChars(int nChars, Guchar *buffer) override;
+  GooString *getPSFilter(int psLevel, const char *indent) override;
+  GBool isBinary(GBool last = gTrue) override;
 
 private:
   inline int doGetRawChar() {
-    if (fill_buffer())
+    if (out_pos >= out_buf_len && !fill_buffer())
       return EOF;
 
     return out_buf[out_pos++];
   }
 
-  int fill_buffer(void);
+  GBool hasGetChars() override { return true; }
+  int getChars(int nChars, Guchar *buffer) override;
+
+  GBool fill_buffer();
+  int inflateSome(Guchar *out, int size);
+
   z_stream d_stream;
   StreamPredictor *pred;
-  int status;
-  /* in_buf currently needs to be 1 or we over read from EmbedStreams */
-  unsigned char in_buf[1];
-  unsigned char out_buf[4096];
+  GBool zInit;			// is d_stream initialized?
+  GBool eof;			// end of data or error
+  GBool readAhead;		// can the input be read in blocks?
+  unsigned char in_buf[flateInBufSize];
+  unsigned char out_buf[flateOutBufSize];
   int out_pos;
   int out_buf_len;
 };
@@ -70,6 +70,7 @@
 #include "Stream.h"
 #include "Lexer.h"
 #include "Parser.h"
+#include "DisplayList.h"
 #include "GfxFont.h"
 #include "GfxState.h"
 #include "OutputDev.h"
@@ -305,6 +306,54 @@ Operator Gfx::opTab[] = {
 
 #define numOps (sizeof(opTab) / sizeof(Operator))
 
+// Operator names have at most 3 characters, findOp() packs them in an
+// int and looks them up in a hash table.  opHashMul was chosen so that
+// the operators of opTab don't collide, collisions are still handled
+// (by linear probing) should an operator be added.
+#define opHashBits 8
+#define opHashSize (1 << opHashBits)
+#define opHashMul 0x8091713fU
+
+// Returns 0 for names with more than 3 characters, no operator has one.
+static inline Guint packOpName(const char *name) {
+  Guint key;
+  int i;
+
+  key = 0;
+  for (i = 0; i < 3 && name[i]; ++i) {
+    key |= (Guint)(Guchar)name[i] << (8 * i);
+  }
+  return name[i] ? 0 : key;
+}
+
+static inline int opHash(Guint key) {
+  return (Guint)(key * opHashMul) >> (32 - opHashBits);
+}
+
+namespace {
+
+struct OpHashTable {
+  OpHashTable(const Operator *ops, int nOps) {
+    int i, h;
+
+    for (h = 0; h < opHashSize; ++h) {
+      keys[h] = 0;
+      idx[h] = -1;
+    }
+    for (i = 0; i < nOps; ++i) {
+      Guint key = packOpName(ops[i].name);
+      for (h = opHash(key); idx[h] >= 0; h = (h + 1) & (opHashSize - 1)) ;
+      keys[h] = key;
+      idx[h] = i;
+    }
+  }
+
+  Guint keys[opHashSize];
+  int idx[opHashSize];		// index in opTab, -1 for an empty slot
+};
+
+}
+
 static inline GBool isSameGfxColor(const GfxColor &colorA, const GfxColor &colorB, Guint nComps, double delta) {
   for (Guint k = 0; k < nComps; ++k) {
     if (abs(colorA.c[k] - colorB.c[k]) > delta) {
@@ -691,7 +740,7 @@ Gfx::~Gfx() {
   }
 }
 
-void Gfx::display(Object *obj, GBool topLevel) {
+GBool Gfx::checkContents(Object *obj) {
   int i;
 
   if (obj->isArray()) {
@@ -699,11 +748,18 @@ void Gfx::display(Object *obj, GBool topLevel) {
       Object obj2 = obj->arrayGet(i);
       if (!obj2.isStream()) {
 	error(errSyntaxError, -1, "Weird page contents");
-	return;
+	return gFalse;
       }
     }
   } else if (!obj->isStream()) {
     error(errSyntaxError, -1, "Weird page contents");
+    return gFalse;
+  }
+  return gTrue;
+}
+
+void Gfx::display(Object *obj, GBool topLevel) {
+  if (!checkContents(obj)) {
     return;
   }
   parser = new Parser(xref, new Lexer(xref, obj), gFalse);
@@ -712,11 +768,41 @@ void Gfx::display(Object *obj, GBool topLevel) {
   parser = nullptr;
 }
 
+void Gfx::display(Object *obj, Object *ref, GBool topLevel) {
+  DisplayList *list;
+
+  if (!checkContents(obj)) {
+    return;
+  }
+  // the cache is for the document's own xref
+  list = nullptr;
+  if (doc && xref == doc->getXRef()) {
+    list = doc->getDisplayListCache()->getDisplayList(xref, ref, obj);
+  }
+  if (list) {
+    display(list, topLevel);
+    list->decRefCnt();
+  } else {
+    display(obj, topLevel);
+  }
+}
+
+void Gfx::display(DisplayList *list, GBool topLevel) {
+  Parser *oldParser;
+
+  // errors are reported without a position, there is no parser
+  oldParser = parser;
+  parser = nullptr;
+  go(list, topLevel);
+  parser = oldParser;
+}
+
 void Gfx::go(GBool topLevel) {
   Object obj;
   Object args[maxArgs];
   int numArgs, i;
   int lastAbortCheck;
+  GBool done;
 
   // scan a sequence of objects
   pushStateGuard();
@@ -729,72 +815,15 @@ void Gfx::go(GBool topLevel) {
 
     // got a command - execute it
     if (obj.isCmd()) {
-      if (printCommands) {
-	obj.print(stdout);
-	for (i = 0; i < numArgs; ++i) {
-	  printf(" ");
-	  args[i].print(stdout);
-	}
-	printf("\n");
-	fflush(stdout);
-      }
-      GooTimer *timer = nullptr;
-
-      if (unlikely(profileCommands)) {
-          timer = new GooTimer();
-      }
-
-      // Run the operation
-      execOp(&obj, args, numArgs);
-
-      // Update the profile information
-      if (unlikely(profileCommands)) {
-	GooHash *hash;
-
-	hash = out->getProfileHash ();
-	if (hash) {
-	  GooString *cmd_g;
-	  ProfileData *data_p;
-
-	  cmd_g = new GooString (obj.getCmd());
-	  data_p = (ProfileData *)hash->lookup (cmd_g);
-	  if (data_p == nullptr) {
-	    data_p = new ProfileData();
-	    hash->add (cmd_g, data_p);
-	  }
-	  
-	  data_p->addElement(timer->getElapsed ());
-	}
-	delete timer;
-      }
+      done = !doCommand(obj.getCmd(), findOp(obj.getCmd()), args, numArgs,
+			&lastAbortCheck);
       for (i = 0; i < numArgs; ++i)
 	args[i].setToNull(); // Free memory early
       numArgs = 0;
-
-      // periodically update display
-      if (++updateLevel >= 20000) {
-	out->dump();
-	updateLevel = 0;
-      }
-
-      // did the command throw an exception
-      if (commandAborted) {
-	// don't propogate; recursive drawing comes from Form XObjects which
-	// should probably be drawn in a separate context anyway for caching
-	commandAborted = gFalse;
+      if (done) {
 	break;
       }
 
-      // check for an abort
-      if (abortCheckCbk) {
-	if (updateLevel - lastAbortCheck > 10) {
-	  if ((*abortCheckCbk)(abortCheckCbkData)) {
-	    break;
-	  }
-	  lastAbortCheck = updateLevel;
-	}
-      }
-
     // got an argument - save it
     } else if (numArgs < maxArgs) {
       args[numArgs++] = std::move(obj);
@@ -835,15 +864,108 @@ void Gfx::go(GBool topLevel) {
   }
 }
 
-void Gfx::execOp(Object *cmd, Object args[], int numArgs) {
-  Operator *op;
-  char *name;
+void Gfx::go(DisplayList *list, GBool topLevel) {
+  Object args[maxArgs];
+  int lastAbortCheck;
+  int i;
+
+  pushStateGuard();
+  updateLevel = 1; // make sure even empty pages trigger a call to dump()
+  lastAbortCheck = 0;
+  for (i = 0; i < list->getNumCmds(); ++i) {
+    commandAborted = gFalse;
+    if (!doCommand(list->getOpName(i), list->getOp(i),
+		   list->getArgs(i, args), list->getNumArgs(i), &lastAbortCheck)) {
+      break;
+    }
+  }
+
+  popStateGuard();
+
+  // update display
+  if (topLevel && updateLevel > 0) {
+    out->dump();
+  }
+}
+
+// Runs a command and does the bookkeeping around it, returns gFalse if
+// the drawing has to stop
+GBool Gfx::doCommand(const char *name, Operator *op, Object args[], int numArgs,
+		     int *lastAbortCheck) {
+  int i;
+
+  if (printCommands) {
+    printf("%s", name);
+    for (i = 0; i < numArgs; ++i) {
+      printf(" ");
+      args[i].print(stdout);
+    }
+    printf("\n");
+    fflush(stdout);
+  }
+  GooTimer *timer = nullptr;
+
+  if (unlikely(profileCommands)) {
+      timer = new GooTimer();
+  }
+
+  // Run the operation
+  execOp(name, op, args, numArgs);
+
+  // Update the profile information
+  if (unlikely(profileCommands)) {
+    GooHash *hash;
+
+    hash = out->getProfileHash ();
+    if (hash) {
+      GooString *cmd_g;
+      ProfileData *data_p;
+
+      cmd_g = new GooString (name);
+      data_p = (ProfileData *)hash->lookup (cmd_g);
+      if (data_p == nullptr) {
+	data_p = new ProfileData();
+	hash->add (cmd_g, data_p);
+      }
+
+      data_p->addElement(timer->getElapsed ());
+    }
+    delete timer;
+  }
+
+  // periodically update display
+  if (++updateLevel >= 20000) {
+    out->dump();
+    updateLevel = 0;
+  }
+
+  // did the command throw an exception
+  if (commandAborted) {
+    // don't propogate; recursive drawing comes from Form XObjects which
+    // should probably be drawn in a separate context anyway for caching
+    commandAborted = gFalse;
+    return gFalse;
+  }
+
+  // check for an abort
+  if (abortCheckCbk) {
+    if (updateLevel - *lastAbortCheck > 10) {
+      if ((*abortCheckCbk)(abortCheckCbkData)) {
+	return gFalse;
+      }
+      *lastAbortCheck = updateLevel;
+    }
+  }
+
+  return gTrue;
+}
+
+void Gfx::execOp(const char *name, Operator *op, Object args[], int numArgs) {
   Object *argPtr;
   int i;
 
-  // find operator
-  name = cmd->getCmd();
-  if (!(op = findOp(name))) {
+  // unknown operator
+  if (!op) {
     if (ignoreUndef == 0)
       error(errSyntaxError, getPos(), "Unknown operator '{0:s}'", name);
     return;
@@ -884,26 +1006,21 @@ void Gfx::execOp(Object *cmd, Object args[], int numArgs) {
   (this->*op->func)(argPtr, numArgs);
 }
 
-Operator *Gfx::findOp(char *name) {
-  int a, b, m, cmp;
-
-  a = -1;
-  b = numOps;
-  cmp = 0; // make gcc happy
-  // invariant: opTab[a] < name < opTab[b]
-  while (b - a > 1) {
-    m = (a + b) / 2;
-    cmp = strcmp(opTab[m].name, name);
-    if (cmp < 0)
-      a = m;
-    else if (cmp > 0)
-      b = m;
-    else
-      a = b = m;
-  }
-  if (cmp != 0)
+Operator *Gfx::findOp(const char *name) {
+  static const OpHashTable opHashTab(opTab, numOps);
+  Guint key;
+  int h;
+
+  key = packOpName(name);
+  if (!key) {
     return nullptr;
-  return &opTab[a];
+  }
+  for (h = opHash(key); opHashTab.idx[h] >= 0; h = (h + 1) & (opHashSize - 1)) {
+    if (opHashTab.keys[h] == key) {
+      return &opTab[opHashTab.idx[h]];
+    }
+  }
+  return nullptr;
 }
 
 GBool Gfx::checkArg(Object *arg, TchkType type) {
@@ -4186,7 +4303,7 @@ void Gfx::opXObject(Object args[], int numArgs) {
       if (out->useDrawForm() && refObj.isRef()) {
 	out->drawForm(refObj.getRef());
       } else {
-	doForm(&obj1);
+	doForm(&refObj, &obj1);
       }
     }
     if (refObj.isRef() && shouldDoForm) {
@@ -4673,7 +4790,7 @@ GBool Gfx::checkTransparencyGroup(Dict *resDict) {
   return transpGroup;
 }
 
-void Gfx::doForm(Object *str) {
+void Gfx::doForm(Object *ref, Object *str) {
   Dict *dict;
   GBool transpGroup, isolated, knockout;
   GfxColorSpace *blendingColorSpace;
@@ -4769,7 +4886,8 @@ void Gfx::doForm(Object *str) {
   // draw it
   ++formDepth;
   drawForm(str, resDict, m, bbox,
-	  transpGroup, gFalse, blendingColorSpace, isolated, knockout);
+	  transpGroup, gFalse, blendingColorSpace, isolated, knockout,
+	  gFalse, nullptr, nullptr, ref);
   --formDepth;
 
   if (blendingColorSpace) {
@@ -4784,7 +4902,7 @@ void Gfx::drawForm(Object *str, Dict *resDict, double *matrix, double *bbox,
 		  GfxColorSpace *blendingColorSpace,
 		  GBool isolated, GBool knockout,
 		  GBool alpha, Function *transferFunc,
-		  GfxColor *backdropColor) {
+		  GfxColor *backdropColor, Object *ref) {
   Parser *oldParser;
   GfxState *savedState;
   double oldBaseMatrix[6];
@@ -4845,7 +4963,7 @@ void Gfx::drawForm(Object *str, Dict *resDict, double *matrix, double *bbox,
   GfxState *stateBefore = state;
 
   // draw the form
-  display(str, gFalse);
+  display(str, ref, gFalse);
   
   if (stateBefore != state) {
     if (state->isParentState(stateBefore)) {
@@ -74,6 +74,7 @@ class PDFRectangle;
 class AnnotBorder;
 class AnnotColor;
 class Catalog;
+class DisplayList;
 struct MarkedContentStack;
 
 //------------------------------------------------------------------------
@@ -175,6 +176,14 @@ public:
   // Interpret a stream or array of streams.
   void display(Object *obj, GBool topLevel = gTrue);
 
+  // Interpret a stream or array of streams, <ref> being the reference
+  // of the page or form they belong to.  They are split in commands only
+  // the first time, see DisplayListCache.
+  void display(Object *obj, Object *ref, GBool topLevel = gTrue);
+
+  // Interpret a stream already split in commands.
+  void display(DisplayList *list, GBool topLevel = gTrue);
+
   // Display an annotation, given its appearance (a Form XObject),
   // border style, and bounding box (in default user space).
   void drawAnnot(Object *str, AnnotBorder *border, AnnotColor *aColor,
@@ -202,13 +211,15 @@ public:
 	       GfxColorSpace *blendingColorSpace = NULL,
 	       GBool isolated = gFalse, GBool knockout = gFalse,
 	       GBool alpha = gFalse, Function *transferFunc = NULL,
-	       GfxColor *backdropColor = NULL);
+	       GfxColor *backdropColor = NULL, Object *ref = NULL);
 
   void pushResources(Dict *resDict);
   void popResources();
 
 private:
 
+  friend class DisplayList;
+
   PDFDoc *doc;
   XRef *xref;			// the xref table for this PDF file
   Catalog *catalog;		// the Catalog for this PDF file  
@@ -246,8 +257,12 @@ private:
   static Operator opTab[];	// table of operators
 
   void go(GBool topLevel);
-  void execOp(Object *cmd, Object args[], int numArgs);
-  Operator *findOp(char *name);
+  void go(DisplayList *list, GBool topLevel);
+  GBool checkContents(Object *obj);
+  GBool doCommand(const char *name, Operator *op, Object args[], int numArgs,
+		  int *lastAbortCheck);
+  void execOp(const char *name, Operator *op, Object args[], int numArgs);
+  static Operator *findOp(const char *name);
   GBool checkArg(Object *arg, TchkType type);
   Goffset getPos();
 
@@ -367,7 +382,7 @@ private:
   // XObject operators
   void opXObject(Object args[], int numArgs);
   void doImage(Object *ref, Stream *str, GBool inlineImg);
-  void doForm(Object *str);
+  void doForm(Object *ref, Object *str);
 
   // in-line image operators
   void opBeginImage(Object args[], int numArgs);
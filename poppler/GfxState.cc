@@ -1771,6 +1771,11 @@ class GfxICCBasedColorSpaceKey : public PopplerCacheKey
       const GfxICCBasedColorSpaceKey *k = static_cast<const GfxICCBasedColorSpaceKey*>(&key);
       return k->num == num && k->gen == gen;
     }
+
+    size_t hash() const override
+    {
+      return ((size_t)num << 8) ^ gen;
+    }
     
     int num, gen;
 };
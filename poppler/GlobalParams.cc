@@ -594,6 +594,7 @@ GlobalParams::GlobalParams(const char *customPopplerDataDir)
   textPageBreaks = gTrue;
   enableFreeType = gTrue;
   overprintPreview = gFalse;
+  imageDecodeThreads = 0;
   printCommands = gFalse;
   profileCommands = gFalse;
   errQuiet = gFalse;
@@ -1383,6 +1384,15 @@ GBool GlobalParams::getPSShrinkLarger() {
   return f;
 }
 
+int GlobalParams::getImageDecodeThreads() {
+  int threads;
+
+  lockGlobalParams;
+  threads = imageDecodeThreads;
+  unlockGlobalParams;
+  return threads;
+}
+
 PSLevel GlobalParams::getPSLevel() {
   PSLevel level;
 
@@ -1612,6 +1622,12 @@ void GlobalParams::setOverprintPreview(GBool overprintPreviewA) {
   unlockGlobalParams;
 }
 
+void GlobalParams::setImageDecodeThreads(int imageDecodeThreadsA) {
+  lockGlobalParams;
+  imageDecodeThreads = imageDecodeThreadsA;
+  unlockGlobalParams;
+}
+
 void GlobalParams::setPrintCommands(GBool printCommandsA) {
   lockGlobalParams;
   printCommands = printCommandsA;
@@ -142,6 +142,7 @@ public:
   GBool getTextPageBreaks();
   GBool getEnableFreeType();
   GBool getOverprintPreview() { return overprintPreview; }
+  int getImageDecodeThreads();
   GBool getPrintCommands();
   GBool getProfileCommands();
   GBool getErrQuiet();
@@ -167,6 +168,7 @@ public:
   void setTextPageBreaks(GBool pageBreaks);
   GBool setEnableFreeType(char *s);
   void setOverprintPreview(GBool overprintPreviewA);
+  void setImageDecodeThreads(int imageDecodeThreadsA);
   void setPrintCommands(GBool printCommandsA);
   void setProfileCommands(GBool profileCommandsA);
   void setErrQuiet(GBool errQuietA);
@@ -228,6 +230,8 @@ private:
   GBool textPageBreaks;		// insert end-of-page markers?
   GBool enableFreeType;		// FreeType enable flag
   GBool overprintPreview;	// enable overprint preview
+  int imageDecodeThreads;	// threads a large image may be decoded
+				//   with, 0 for one per CPU
   GBool printCommands;		// print the drawing commands
   GBool profileCommands;	// profile the drawing commands
   GBool errQuiet;		// suppress error messages?
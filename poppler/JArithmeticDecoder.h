@@ -126,4 +126,70 @@ private:
   GBool limitStream;
 };
 
+// decodeBit() runs once per pixel of the JBIG2 and JPEG 2000 bitmaps,
+// so it is inlined in their decoding loops.
+inline int JArithmeticDecoder::decodeBit(Guint context,
+					  JArithmeticDecoderStats *stats) {
+  int bit;
+  Guint qe;
+  int iCX, mpsCX;
+
+  iCX = stats->cxTab[context] >> 1;
+  mpsCX = stats->cxTab[context] & 1;
+  qe = qeTab[iCX];
+  a -= qe;
+  if (c < a) {
+    if (a & 0x80000000) {
+      bit = mpsCX;
+    } else {
+      // MPS_EXCHANGE
+      if (a < qe) {
+	bit = 1 - mpsCX;
+	if (switchTab[iCX]) {
+	  stats->cxTab[context] = (nlpsTab[iCX] << 1) | (1 - mpsCX);
+	} else {
+	  stats->cxTab[context] = (nlpsTab[iCX] << 1) | mpsCX;
+	}
+      } else {
+	bit = mpsCX;
+	stats->cxTab[context] = (nmpsTab[iCX] << 1) | mpsCX;
+      }
+      // RENORMD
+      do {
+	if (ct == 0) {
+	  byteIn();
+	}
+	a <<= 1;
+	c <<= 1;
+	--ct;
+      } while (!(a & 0x80000000));
+    }
+  } else {
+    c -= a;
+    // LPS_EXCHANGE
+    if (a < qe) {
+      bit = mpsCX;
+      stats->cxTab[context] = (nmpsTab[iCX] << 1) | mpsCX;
+    } else {
+      bit = 1 - mpsCX;
+      if (switchTab[iCX]) {
+	stats->cxTab[context] = (nlpsTab[iCX] << 1) | (1 - mpsCX);
+      } else {
+	stats->cxTab[context] = (nlpsTab[iCX] << 1) | mpsCX;
+      }
+    }
+    a = qe;
+    // RENORMD
+    do {
+      if (ct == 0) {
+	byteIn();
+      }
+      a <<= 1;
+      c <<= 1;
+      --ct;
+    } while (!(a & 0x80000000));
+  }
+  return bit;
+}
+
 #endif
@@ -37,7 +37,12 @@
 
 #include <stdlib.h>
 #include <limits.h>
+#ifdef MULTITHREADED
+#include <algorithm>
+#include <thread>
+#endif
 #include "goo/GooList.h"
+#include "goo/GooString.h"
 #include "Error.h"
 #include "JArithmeticDecoder.h"
 #include "JBIG2Stream.h"
@@ -1414,6 +1419,12 @@ void JBIG2Stream::readSegments() {
       goto syntaxError;
     }
 
+    // the regions decoded in the background go into the page before
+    // anything else
+    if (segType != 38 && segType != 39) {
+      finishGenericRegions();
+    }
+
     // read the segment data
     switch (segType) {
     case 0:
@@ -1533,16 +1544,19 @@ void JBIG2Stream::readSegments() {
     gfree(refSegs);
   }
 
+  finishGenericRegions();
   return;
 
  syntaxError:
   gfree(refSegs);
+  finishGenericRegions();
   return;
 
  eofError2:
   gfree(refSegs);
  eofError1:
   error(errSyntaxError, curStr->getPos(), "Unexpected EOF in JBIG2 stream");
+  finishGenericRegions();
 }
 
 GBool JBIG2Stream::readSymbolDictSeg(Guint segNum, Guint length,
@@ -2814,12 +2828,106 @@ void JBIG2Stream::readHalftoneRegionSeg(Guint segNum, GBool imm,
   error(errSyntaxError, curStr->getPos(), "Unexpected EOF in JBIG2 stream");
 }
 
+#ifdef MULTITHREADED
+
+//------------------------------------------------------------------------
+// JBIG2PendingRegion
+//------------------------------------------------------------------------
+
+// at most this many immediate generic regions are decoded at once
+#define jbig2MaxPendingRegions 8
+
+// An immediate generic region decoded in the background.  Arithmetic
+// coded regions restart the decoder and their statistics, so they
+// depend on nothing but their own data.
+class JBIG2PendingRegion {
+public:
+
+  JBIG2PendingRegion(JBIG2Bitmap *bitmapA, Guint xA, Guint yA,
+		     Guint combOpA, int templA, GBool tpgdOnA,
+		     int *atxA, int *atyA, GooString *dataA);
+  ~JBIG2PendingRegion();
+
+  JBIG2Bitmap *bitmap;
+  Guint x, y, combOp;
+  int templ;
+  GBool tpgdOn;
+  int atx[4], aty[4];
+  GooString *data;		// the segment data after the header
+  MemStream *str;
+  JArithmeticDecoder decoder;
+  JArithmeticDecoderStats stats;
+  std::thread thread;
+};
+
+JBIG2PendingRegion::JBIG2PendingRegion(JBIG2Bitmap *bitmapA,
+				       Guint xA, Guint yA, Guint combOpA,
+				       int templA, GBool tpgdOnA,
+				       int *atxA, int *atyA,
+				       GooString *dataA):
+  stats(1 << contextSize[templA])
+{
+  bitmap = bitmapA;
+  x = xA;
+  y = yA;
+  combOp = combOpA;
+  templ = templA;
+  tpgdOn = tpgdOnA;
+  for (int i = 0; i < (templ == 0 ? 4 : 1); ++i) {
+    atx[i] = atxA[i];
+    aty[i] = atyA[i];
+  }
+  data = dataA;
+  str = new MemStream(data->getCString(), 0, data->getLength(),
+		      Object(objNull));
+  decoder.setStream(str);
+}
+
+JBIG2PendingRegion::~JBIG2PendingRegion() {
+  delete bitmap;
+  delete str;
+  delete data;
+}
+
+// The number of regions decoded at once.
+static size_t maxPendingRegions() {
+  static const size_t n = std::min(std::thread::hardware_concurrency(),
+				   (unsigned int)jbig2MaxPendingRegions);
+  return n;
+}
+
+#endif
+
+void JBIG2Stream::finishGenericRegions() {
+#ifdef MULTITHREADED
+  for (JBIG2PendingRegion *region : pendingRegions) {
+    region->thread.join();
+    if (pageH == 0xffffffff &&
+	region->y + region->bitmap->getHeight() > curPageH) {
+      pageBitmap->expand(region->y + region->bitmap->getHeight(),
+			 pageDefPixel);
+    }
+    pageBitmap->combine(region->bitmap, region->x, region->y,
+			region->combOp);
+    delete region;
+  }
+  pendingRegions.clear();
+#endif
+}
+
 void JBIG2Stream::readGenericRegionSeg(Guint segNum, GBool imm,
 				       GBool lossless, Guint length) {
   JBIG2Bitmap *bitmap;
   Guint w, h, x, y, segInfoFlags, extCombOp, rowCount;
   Guint flags, mmr, templ, tpgdOn;
   int atx[4], aty[4];
+#ifdef MULTITHREADED
+  JBIG2PendingRegion *region;
+  GooString *data;
+  Guint headerLength, dataLength;
+  char buf[4096];
+  int n;
+#endif
 
   // region segment info field
   if (!readULong(&w) || !readULong(&h) ||
@@ -2858,6 +2966,47 @@ void JBIG2Stream::readGenericRegionSeg(Guint segNum, GBool imm,
     }
   }
 
+#ifdef MULTITHREADED
+  // decode the immediate arithmetic coded regions of known length in
+  // the background, while the next segments are read
+  headerLength = templ == 0 ? 26 : 20;
+  if (imm && !mmr && length != 0xffffffff && length >= headerLength &&
+      maxPendingRegions() > 1) {
+    if (pendingRegions.size() >= maxPendingRegions()) {
+      finishGenericRegions();
+    }
+    bitmap = new JBIG2Bitmap(0, w, h);
+    if (!bitmap->isOk()) {
+      delete bitmap;
+      return;
+    }
+    bitmap->clearToZero();
+    data = new GooString();
+    for (dataLength = length - headerLength; dataLength > 0;
+	 dataLength -= n) {
+      n = curStr->doGetChars(std::min(dataLength, (Guint)sizeof(buf)),
+			     (Guchar *)buf);
+      if (n <= 0) {
+	break;
+      }
+      data->append(buf, n);
+    }
+    region = new JBIG2PendingRegion(bitmap, x, y, extCombOp, templ, tpgdOn,
+				    atx, aty, data);
+    region->thread = std::thread([region]() {
+      region->decoder.start();
+      decodeGenericBitmap(region->bitmap, region->templ, region->tpgdOn,
+			  gFalse, nullptr, region->atx, region->aty,
+			  &region->decoder, &region->stats);
+    });
+    pendingRegions.push_back(region);
+    return;
+  }
+#endif
+
+  // the page gets the regions in segment order
+  finishGenericRegions();
+
   // set up the arithmetic decoder
   if (!mmr) {
     resetGenericStats(templ, nullptr);
@@ -2939,17 +3088,9 @@ JBIG2Bitmap *JBIG2Stream::readGenericBitmap(GBool mmr, int w, int h,
 					    int *atx, int *aty,
 					    int mmrDataLength) {
   JBIG2Bitmap *bitmap;
-  GBool ltp;
-  Guint ltpCX, cx, cx0, cx1, cx2;
   int *refLine, *codingLine;
   int code1, code2, code3;
-  Guchar *p0, *p1, *p2, *pp;
-  Guchar *atP0, *atP1, *atP2, *atP3;
-  Guint buf0, buf1, buf2;
-  Guint atBuf0, atBuf1, atBuf2, atBuf3;
-  int atShift0, atShift1, atShift2, atShift3;
-  Guchar mask;
-  int x, y, x0, x1, a0i, b1i, blackPixels, pix, i;
+  int x, y, a0i, b1i, blackPixels, i;
 
   bitmap = new JBIG2Bitmap(0, w, h);
   if (!bitmap->isOk()) {
@@ -3176,547 +3317,677 @@ JBIG2Bitmap *JBIG2Stream::readGenericBitmap(GBool mmr, int w, int h,
   //----- arithmetic decode
 
   } else {
-    // set up the typical row context
-    ltpCX = 0; // make gcc happy
+    decodeGenericBitmap(bitmap, templ, tpgdOn, useSkip, skip, atx, aty,
+			arithDecoder, genericRegionStats);
+  }
+
+  return bitmap;
+}
+
+// Context of the pixel at x in a generic region with template <templ>
+// and nominal AT pixels.  <line2>, <line1> and <line0> are windows on
+// the rows y-2, y-1 and y, holding pixel x at bit 16, x-k at bit 16+k
+// and x+k at bit 16-k.  The bits are laid out as in the general case
+// in decodeGenericBitmap, which shares the statistics.
+template<int templ>
+static inline Guint genericContext(Guint line2, Guint line1, Guint line0) {
+  switch (templ) {
+  case 0:
+    return ((line2 >> 2) & 0xe000) |	// y-2: x-1 .. x+1
+	   ((line1 >> 6) & 0x1f00) |	// y-1: x-2 .. x+2
+	   ((line0 >> 13) & 0x00f0) |	// y:   x-4 .. x-1
+	   ((line1 >> 10) & 0x0008) |	// AT1: x+3, y-1
+	   ((line1 >> 17) & 0x0004) |	// AT2: x-3, y-1
+	   ((line2 >> 13) & 0x0002) |	// AT3: x+2, y-2
+	   ((line2 >> 18) & 0x0001);	// AT4: x-2, y-2
+  case 1:
+    return ((line2 >> 5) & 0x1e00) |	// y-2: x-1 .. x+2
+	   ((line1 >> 10) & 0x01f0) |	// y-1: x-2 .. x+2
+	   ((line0 >> 16) & 0x000e) |	// y:   x-3 .. x-1
+	   ((line1 >> 13) & 0x0001);	// AT1: x+3, y-1
+  case 2:
+    return ((line2 >> 8) & 0x0380) |	// y-2: x-1 .. x+1
+	   ((line1 >> 12) & 0x0078) |	// y-1: x-2 .. x+1
+	   ((line0 >> 16) & 0x0006) |	// y:   x-2 .. x-1
+	   ((line1 >> 14) & 0x0001);	// AT1: x+2, y-1
+  default:
+    return ((line1 >> 10) & 0x03e0) |	// y-1: x-3 .. x+1
+	   ((line0 >> 16) & 0x001e) |	// y:   x-4 .. x-1
+	   ((line1 >> 14) & 0x0001);	// AT1: x+2, y-1
+  }
+}
+
+// Decodes row <y> of a generic region bitmap with template <templ>,
+// nominal AT pixels and no skipped pixels.  The windows the context is
+// taken from are refilled a byte at a time, and the decoded pixels are
+// stored a byte at a time.
+template<int templ>
+static void decodeGenericRow(JBIG2Bitmap *bitmap, int y,
+			     JArithmeticDecoder *decoder,
+			     JArithmeticDecoderStats *stats) {
+  Guchar *line, *line1, *line2;
+  Guint buf2, buf1, buf0, bits;
+  int w, lineSize, bx, x, n, i, pix;
+
+  w = bitmap->getWidth();
+  lineSize = bitmap->getLineSize();
+  line = bitmap->getDataPtr() + y * lineSize;
+  line1 = y >= 1 ? line - lineSize : nullptr;
+  line2 = y >= 2 ? line - 2 * lineSize : nullptr;
+  buf2 = line2 ? (Guint)line2[0] << 9 : 0;
+  buf1 = line1 ? (Guint)line1[0] << 9 : 0;
+  buf0 = 0;
+
+  for (bx = 0, x = 0; x < w; ++bx, x += n) {
+    if (bx + 1 < lineSize) {
+      if (line2) {
+	buf2 |= (Guint)line2[bx + 1] << 1;
+      }
+      if (line1) {
+	buf1 |= (Guint)line1[bx + 1] << 1;
+      }
+    }
+    n = w - x < 8 ? w - x : 8;
+    bits = 0;
+    for (i = 0; i < n; ++i) {
+      pix = decoder->decodeBit(genericContext<templ>(buf2, buf1, buf0), stats);
+      bits = (bits << 1) | pix;
+      buf2 <<= 1;
+      buf1 <<= 1;
+      buf0 = (buf0 | (pix << 16)) << 1;
+    }
+    line[bx] = (Guchar)(bits << (8 - n));
+  }
+}
+
+void JBIG2Stream::decodeGenericBitmap(JBIG2Bitmap *bitmap,
+				      int templ, GBool tpgdOn,
+				      GBool useSkip, JBIG2Bitmap *skip,
+				      int *atx, int *aty,
+				      JArithmeticDecoder *decoder,
+				      JArithmeticDecoderStats *stats) {
+  GBool ltp;
+  Guint ltpCX, cx, cx0, cx1, cx2;
+  Guchar *p0, *p1, *p2, *pp;
+  Guchar *atP0, *atP1, *atP2, *atP3;
+  Guint buf0, buf1, buf2;
+  Guint atBuf0, atBuf1, atBuf2, atBuf3;
+  int atShift0, atShift1, atShift2, atShift3;
+  Guchar mask;
+  int w, h, x, y, x0, x1, pix;
+  GBool nominal;
+
+  w = bitmap->getWidth();
+  h = bitmap->getHeight();
+
+  // the AT pixels of nearly all the bitmaps are at their nominal
+  // positions
+  if (templ == 0) {
+    nominal = atx[0] == 3 && aty[0] == -1 && atx[1] == -3 && aty[1] == -1 &&
+	      atx[2] == 2 && aty[2] == -2 && atx[3] == -2 && aty[3] == -2;
+  } else if (templ == 1) {
+    nominal = atx[0] == 3 && aty[0] == -1;
+  } else {
+    nominal = atx[0] == 2 && aty[0] == -1;
+  }
+  nominal = nominal && !useSkip;
+
+  // set up the typical row context
+  ltpCX = 0; // make gcc happy
+  if (tpgdOn) {
+    switch (templ) {
+    case 0:
+      ltpCX = 0x3953; // 001 11001 0101 0011
+      break;
+    case 1:
+      ltpCX = 0x079a; // 0011 11001 101 0
+      break;
+    case 2:
+      ltpCX = 0x0e3; // 001 1100 01 1
+      break;
+    case 3:
+      ltpCX = 0x18a; // 01100 0101 1
+      break;
+    }
+  }
+
+  ltp = 0;
+  cx = cx0 = cx1 = cx2 = 0; // make gcc happy
+  for (y = 0; y < h; ++y) {
+
+    // check for a "typical" (duplicate) row
     if (tpgdOn) {
+      if (decoder->decodeBit(ltpCX, stats)) {
+	ltp = !ltp;
+      }
+      if (ltp) {
+	if (y > 0) {
+	  bitmap->duplicateRow(y, y-1);
+	}
+	continue;
+      }
+    }
+
+    if (nominal) {
       switch (templ) {
       case 0:
-	ltpCX = 0x3953; // 001 11001 0101 0011
+	decodeGenericRow<0>(bitmap, y, decoder, stats);
 	break;
       case 1:
-	ltpCX = 0x079a; // 0011 11001 101 0
+	decodeGenericRow<1>(bitmap, y, decoder, stats);
 	break;
       case 2:
-	ltpCX = 0x0e3; // 001 1100 01 1
+	decodeGenericRow<2>(bitmap, y, decoder, stats);
 	break;
       case 3:
-	ltpCX = 0x18a; // 01100 0101 1
+	decodeGenericRow<3>(bitmap, y, decoder, stats);
 	break;
       }
+      continue;
     }
 
-    ltp = 0;
-    cx = cx0 = cx1 = cx2 = 0; // make gcc happy
-    for (y = 0; y < h; ++y) {
+    switch (templ) {
+    case 0:
 
-      // check for a "typical" (duplicate) row
-      if (tpgdOn) {
-	if (arithDecoder->decodeBit(ltpCX, genericRegionStats)) {
-	  ltp = !ltp;
-	}
-	if (ltp) {
-	  if (y > 0) {
-	    bitmap->duplicateRow(y, y-1);
-	  }
-	  continue;
+      // set up the context
+      p2 = pp = bitmap->getDataPtr() + y * bitmap->getLineSize();
+      buf2 = *p2++ << 8;
+      if (y >= 1) {
+	p1 = bitmap->getDataPtr() + (y - 1) * bitmap->getLineSize();
+	buf1 = *p1++ << 8;
+	if (y >= 2) {
+	  p0 = bitmap->getDataPtr() + (y - 2) * bitmap->getLineSize();
+	  buf0 = *p0++ << 8;
+	} else {
+	  p0 = nullptr;
+	  buf0 = 0;
 	}
+      } else {
+	p1 = p0 = nullptr;
+	buf1 = buf0 = 0;
       }
 
-      switch (templ) {
-      case 0:
-
-	// set up the context
-	p2 = pp = bitmap->getDataPtr() + y * bitmap->getLineSize();
-	buf2 = *p2++ << 8;
-	if (y >= 1) {
-	  p1 = bitmap->getDataPtr() + (y - 1) * bitmap->getLineSize();
-	  buf1 = *p1++ << 8;
-	  if (y >= 2) {
-	    p0 = bitmap->getDataPtr() + (y - 2) * bitmap->getLineSize();
-	    buf0 = *p0++ << 8;
-	  } else {
-	    p0 = nullptr;
-	    buf0 = 0;
-	  }
+      if (atx[0] >= -8 && atx[0] <= 8 &&
+	  atx[1] >= -8 && atx[1] <= 8 &&
+	  atx[2] >= -8 && atx[2] <= 8 &&
+	  atx[3] >= -8 && atx[3] <= 8) {
+	// set up the adaptive context
+	if (y + aty[0] >= 0 && y + aty[0] < bitmap->getHeight()) {
+	  atP0 = bitmap->getDataPtr() + (y + aty[0]) * bitmap->getLineSize();
+	  atBuf0 = *atP0++ << 8;
 	} else {
-	  p1 = p0 = nullptr;
-	  buf1 = buf0 = 0;
+	  atP0 = nullptr;
+	  atBuf0 = 0;
 	}
+	atShift0 = 15 - atx[0];
+	if (y + aty[1] >= 0 && y + aty[1] < bitmap->getHeight()) {
+	  atP1 = bitmap->getDataPtr() + (y + aty[1]) * bitmap->getLineSize();
+	  atBuf1 = *atP1++ << 8;
+	} else {
+	  atP1 = nullptr;
+	  atBuf1 = 0;
+	}
+	atShift1 = 15 - atx[1];
+	if (y + aty[2] >= 0 && y + aty[2] < bitmap->getHeight()) {
+	  atP2 = bitmap->getDataPtr() + (y + aty[2]) * bitmap->getLineSize();
+	  atBuf2 = *atP2++ << 8;
+	} else {
+	  atP2 = nullptr;
+	  atBuf2 = 0;
+	}
+	atShift2 = 15 - atx[2];
+	if (y + aty[3] >= 0 && y + aty[3] < bitmap->getHeight()) {
+	  atP3 = bitmap->getDataPtr() + (y + aty[3]) * bitmap->getLineSize();
+	  atBuf3 = *atP3++ << 8;
+	} else {
+	  atP3 = nullptr;
+	  atBuf3 = 0;
+	}
+	atShift3 = 15 - atx[3];
 
-	if (atx[0] >= -8 && atx[0] <= 8 &&
-	    atx[1] >= -8 && atx[1] <= 8 &&
-	    atx[2] >= -8 && atx[2] <= 8 &&
-	    atx[3] >= -8 && atx[3] <= 8) {
-	  // set up the adaptive context
-	  if (y + aty[0] >= 0 && y + aty[0] < bitmap->getHeight()) {
-	    atP0 = bitmap->getDataPtr() + (y + aty[0]) * bitmap->getLineSize();
-	    atBuf0 = *atP0++ << 8;
-	  } else {
-	    atP0 = nullptr;
-	    atBuf0 = 0;
-	  }
-	  atShift0 = 15 - atx[0];
-	  if (y + aty[1] >= 0 && y + aty[1] < bitmap->getHeight()) {
-	    atP1 = bitmap->getDataPtr() + (y + aty[1]) * bitmap->getLineSize();
-	    atBuf1 = *atP1++ << 8;
-	  } else {
-	    atP1 = nullptr;
-	    atBuf1 = 0;
-	  }
-	  atShift1 = 15 - atx[1];
-	  if (y + aty[2] >= 0 && y + aty[2] < bitmap->getHeight()) {
-	    atP2 = bitmap->getDataPtr() + (y + aty[2]) * bitmap->getLineSize();
-	    atBuf2 = *atP2++ << 8;
-	  } else {
-	    atP2 = nullptr;
-	    atBuf2 = 0;
-	  }
-	  atShift2 = 15 - atx[2];
-	  if (y + aty[3] >= 0 && y + aty[3] < bitmap->getHeight()) {
-	    atP3 = bitmap->getDataPtr() + (y + aty[3]) * bitmap->getLineSize();
-	    atBuf3 = *atP3++ << 8;
-	  } else {
-	    atP3 = nullptr;
-	    atBuf3 = 0;
-	  }
-	  atShift3 = 15 - atx[3];
-
-	  // decode the row
-	  for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
-	    if (x0 + 8 < w) {
-	      if (p0) {
-		buf0 |= *p0++;
-	      }
-	      if (p1) {
-		buf1 |= *p1++;
-	      }
-	      buf2 |= *p2++;
-	      if (atP0) {
-		atBuf0 |= *atP0++;
-	      }
-	      if (atP1) {
-		atBuf1 |= *atP1++;
-	      }
-	      if (atP2) {
-		atBuf2 |= *atP2++;
-	      }
-	      if (atP3) {
-		atBuf3 |= *atP3++;
-	      }
+	// decode the row
+	for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
+	  if (x0 + 8 < w) {
+	    if (p0) {
+	      buf0 |= *p0++;
+	    }
+	    if (p1) {
+	      buf1 |= *p1++;
+	    }
+	    buf2 |= *p2++;
+	    if (atP0) {
+	      atBuf0 |= *atP0++;
+	    }
+	    if (atP1) {
+	      atBuf1 |= *atP1++;
 	    }
-	    for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
-
-	      // build the context
-	      cx0 = (buf0 >> 14) & 0x07;
-	      cx1 = (buf1 >> 13) & 0x1f;
-	      cx2 = (buf2 >> 16) & 0x0f;
-	      cx = (cx0 << 13) | (cx1 << 8) | (cx2 << 4) |
-		   (((atBuf0 >> atShift0) & 1) << 3) |
-		   (((atBuf1 >> atShift1) & 1) << 2) |
-		   (((atBuf2 >> atShift2) & 1) << 1) |
-		   ((atBuf3 >> atShift3) & 1);
-
-	      // check for a skipped pixel
-	      if (!(useSkip && skip->getPixel(x, y))) {
-
-		// decode the pixel
-		if ((pix = arithDecoder->decodeBit(cx, genericRegionStats))) {
-		  *pp |= mask;
-		  buf2 |= 0x8000;
-		  if (aty[0] == 0) {
-		    atBuf0 |= 0x8000;
-		  }
-		  if (aty[1] == 0) {
-		    atBuf1 |= 0x8000;
-		  }
-		  if (aty[2] == 0) {
-		    atBuf2 |= 0x8000;
-		  }
-		  if (aty[3] == 0) {
-		    atBuf3 |= 0x8000;
-		  }
+	    if (atP2) {
+	      atBuf2 |= *atP2++;
+	    }
+	    if (atP3) {
+	      atBuf3 |= *atP3++;
+	    }
+	  }
+	  for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
+
+	    // build the context
+	    cx0 = (buf0 >> 14) & 0x07;
+	    cx1 = (buf1 >> 13) & 0x1f;
+	    cx2 = (buf2 >> 16) & 0x0f;
+	    cx = (cx0 << 13) | (cx1 << 8) | (cx2 << 4) |
+		 (((atBuf0 >> atShift0) & 1) << 3) |
+		 (((atBuf1 >> atShift1) & 1) << 2) |
+		 (((atBuf2 >> atShift2) & 1) << 1) |
+		 ((atBuf3 >> atShift3) & 1);
+
+	    // check for a skipped pixel
+	    if (!(useSkip && skip->getPixel(x, y))) {
+
+	      // decode the pixel
+	      if ((pix = decoder->decodeBit(cx, stats))) {
+		*pp |= mask;
+		buf2 |= 0x8000;
+		if (aty[0] == 0) {
+		  atBuf0 |= 0x8000;
+		}
+		if (aty[1] == 0) {
+		  atBuf1 |= 0x8000;
+		}
+		if (aty[2] == 0) {
+		  atBuf2 |= 0x8000;
+		}
+		if (aty[3] == 0) {
+		  atBuf3 |= 0x8000;
 		}
 	      }
-
-	      // update the context
-	      buf0 <<= 1;
-	      buf1 <<= 1;
-	      buf2 <<= 1;
-	      atBuf0 <<= 1;
-	      atBuf1 <<= 1;
-	      atBuf2 <<= 1;
-	      atBuf3 <<= 1;
 	    }
+
+	    // update the context
+	    buf0 <<= 1;
+	    buf1 <<= 1;
+	    buf2 <<= 1;
+	    atBuf0 <<= 1;
+	    atBuf1 <<= 1;
+	    atBuf2 <<= 1;
+	    atBuf3 <<= 1;
 	  }
+	}
 
-	} else {
-	  // decode the row
-	  for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
-	    if (x0 + 8 < w) {
-	      if (p0) {
-		buf0 |= *p0++;
-	      }
-	      if (p1) {
-		buf1 |= *p1++;
-	      }
-	      buf2 |= *p2++;
+      } else {
+	// decode the row
+	for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
+	  if (x0 + 8 < w) {
+	    if (p0) {
+	      buf0 |= *p0++;
 	    }
-	    for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
-
-	      // build the context
-	      cx0 = (buf0 >> 14) & 0x07;
-	      cx1 = (buf1 >> 13) & 0x1f;
-	      cx2 = (buf2 >> 16) & 0x0f;
-	      cx = (cx0 << 13) | (cx1 << 8) | (cx2 << 4) |
-		   (bitmap->getPixel(x + atx[0], y + aty[0]) << 3) |
-		   (bitmap->getPixel(x + atx[1], y + aty[1]) << 2) |
-		   (bitmap->getPixel(x + atx[2], y + aty[2]) << 1) |
-		   bitmap->getPixel(x + atx[3], y + aty[3]);
-
-	      // check for a skipped pixel
-	      if (!(useSkip && skip->getPixel(x, y))) {
-
-		// decode the pixel
-		if ((pix = arithDecoder->decodeBit(cx, genericRegionStats))) {
-		  *pp |= mask;
-		  buf2 |= 0x8000;
-		}
+	    if (p1) {
+	      buf1 |= *p1++;
+	    }
+	    buf2 |= *p2++;
+	  }
+	  for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
+
+	    // build the context
+	    cx0 = (buf0 >> 14) & 0x07;
+	    cx1 = (buf1 >> 13) & 0x1f;
+	    cx2 = (buf2 >> 16) & 0x0f;
+	    cx = (cx0 << 13) | (cx1 << 8) | (cx2 << 4) |
+		 (bitmap->getPixel(x + atx[0], y + aty[0]) << 3) |
+		 (bitmap->getPixel(x + atx[1], y + aty[1]) << 2) |
+		 (bitmap->getPixel(x + atx[2], y + aty[2]) << 1) |
+		 bitmap->getPixel(x + atx[3], y + aty[3]);
+
+	    // check for a skipped pixel
+	    if (!(useSkip && skip->getPixel(x, y))) {
+
+	      // decode the pixel
+	      if ((pix = decoder->decodeBit(cx, stats))) {
+		*pp |= mask;
+		buf2 |= 0x8000;
 	      }
-
-	      // update the context
-	      buf0 <<= 1;
-	      buf1 <<= 1;
-	      buf2 <<= 1;
 	    }
+
+	    // update the context
+	    buf0 <<= 1;
+	    buf1 <<= 1;
+	    buf2 <<= 1;
 	  }
 	}
-	break;
+      }
+      break;
 
-      case 1:
+    case 1:
 
-	// set up the context
-	p2 = pp = bitmap->getDataPtr() + y * bitmap->getLineSize();
-	buf2 = *p2++ << 8;
-	if (y >= 1) {
-	  p1 = bitmap->getDataPtr() + (y - 1) * bitmap->getLineSize();
-	  buf1 = *p1++ << 8;
-	  if (y >= 2) {
-	    p0 = bitmap->getDataPtr() + (y - 2) * bitmap->getLineSize();
-	    buf0 = *p0++ << 8;
-	  } else {
-	    p0 = nullptr;
-	    buf0 = 0;
-	  }
+      // set up the context
+      p2 = pp = bitmap->getDataPtr() + y * bitmap->getLineSize();
+      buf2 = *p2++ << 8;
+      if (y >= 1) {
+	p1 = bitmap->getDataPtr() + (y - 1) * bitmap->getLineSize();
+	buf1 = *p1++ << 8;
+	if (y >= 2) {
+	  p0 = bitmap->getDataPtr() + (y - 2) * bitmap->getLineSize();
+	  buf0 = *p0++ << 8;
 	} else {
-	  p1 = p0 = nullptr;
-	  buf1 = buf0 = 0;
+	  p0 = nullptr;
+	  buf0 = 0;
 	}
+      } else {
+	p1 = p0 = nullptr;
+	buf1 = buf0 = 0;
+      }
 
-	if (atx[0] >= -8 && atx[0] <= 8) {
-	  // set up the adaptive context
-	  const int atY = y + aty[0];
-	  if ((atY >= 0) && (atY < bitmap->getHeight())) {
-	    atP0 = bitmap->getDataPtr() + atY * bitmap->getLineSize();
-	    atBuf0 = *atP0++ << 8;
-	  } else {
-	    atP0 = nullptr;
-	    atBuf0 = 0;
-	  }
-	  atShift0 = 15 - atx[0];
+      if (atx[0] >= -8 && atx[0] <= 8) {
+	// set up the adaptive context
+	const int atY = y + aty[0];
+	if ((atY >= 0) && (atY < bitmap->getHeight())) {
+	  atP0 = bitmap->getDataPtr() + atY * bitmap->getLineSize();
+	  atBuf0 = *atP0++ << 8;
+	} else {
+	  atP0 = nullptr;
+	  atBuf0 = 0;
+	}
+	atShift0 = 15 - atx[0];
 
-	  // decode the row
-	  for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
-	    if (x0 + 8 < w) {
-	      if (p0) {
-		buf0 |= *p0++;
-	      }
-	      if (p1) {
-		buf1 |= *p1++;
-	      }
-	      buf2 |= *p2++;
-	      if (atP0) {
-		atBuf0 |= *atP0++;
-	      }
+	// decode the row
+	for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
+	  if (x0 + 8 < w) {
+	    if (p0) {
+	      buf0 |= *p0++;
 	    }
-	    for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
-
-	      // build the context
-	      cx0 = (buf0 >> 13) & 0x0f;
-	      cx1 = (buf1 >> 13) & 0x1f;
-	      cx2 = (buf2 >> 16) & 0x07;
-	      cx = (cx0 << 9) | (cx1 << 4) | (cx2 << 1) |
-		   ((atBuf0 >> atShift0) & 1);
-
-	      // check for a skipped pixel
-	      if (!(useSkip && skip->getPixel(x, y))) {
-
-		// decode the pixel
-		if ((pix = arithDecoder->decodeBit(cx, genericRegionStats))) {
-		  *pp |= mask;
-		  buf2 |= 0x8000;
-		  if (aty[0] == 0) {
-		    atBuf0 |= 0x8000;
-		  }
+	    if (p1) {
+	      buf1 |= *p1++;
+	    }
+	    buf2 |= *p2++;
+	    if (atP0) {
+	      atBuf0 |= *atP0++;
+	    }
+	  }
+	  for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
+
+	    // build the context
+	    cx0 = (buf0 >> 13) & 0x0f;
+	    cx1 = (buf1 >> 13) & 0x1f;
+	    cx2 = (buf2 >> 16) & 0x07;
+	    cx = (cx0 << 9) | (cx1 << 4) | (cx2 << 1) |
+		 ((atBuf0 >> atShift0) & 1);
+
+	    // check for a skipped pixel
+	    if (!(useSkip && skip->getPixel(x, y))) {
+
+	      // decode the pixel
+	      if ((pix = decoder->decodeBit(cx, stats))) {
+		*pp |= mask;
+		buf2 |= 0x8000;
+		if (aty[0] == 0) {
+		  atBuf0 |= 0x8000;
 		}
 	      }
-
-	      // update the context
-	      buf0 <<= 1;
-	      buf1 <<= 1;
-	      buf2 <<= 1;
-	      atBuf0 <<= 1;
 	    }
+
+	    // update the context
+	    buf0 <<= 1;
+	    buf1 <<= 1;
+	    buf2 <<= 1;
+	    atBuf0 <<= 1;
 	  }
+	}
 
-	} else {
-	  // decode the row
-	  for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
-	    if (x0 + 8 < w) {
-	      if (p0) {
-		buf0 |= *p0++;
-	      }
-	      if (p1) {
-		buf1 |= *p1++;
-	      }
-	      buf2 |= *p2++;
+      } else {
+	// decode the row
+	for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
+	  if (x0 + 8 < w) {
+	    if (p0) {
+	      buf0 |= *p0++;
 	    }
-	    for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
-
-	      // build the context
-	      cx0 = (buf0 >> 13) & 0x0f;
-	      cx1 = (buf1 >> 13) & 0x1f;
-	      cx2 = (buf2 >> 16) & 0x07;
-	      cx = (cx0 << 9) | (cx1 << 4) | (cx2 << 1) |
-		   bitmap->getPixel(x + atx[0], y + aty[0]);
-
-	      // check for a skipped pixel
-	      if (!(useSkip && skip->getPixel(x, y))) {
-
-		// decode the pixel
-		if ((pix = arithDecoder->decodeBit(cx, genericRegionStats))) {
-		  *pp |= mask;
-		  buf2 |= 0x8000;
-		}
+	    if (p1) {
+	      buf1 |= *p1++;
+	    }
+	    buf2 |= *p2++;
+	  }
+	  for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
+
+	    // build the context
+	    cx0 = (buf0 >> 13) & 0x0f;
+	    cx1 = (buf1 >> 13) & 0x1f;
+	    cx2 = (buf2 >> 16) & 0x07;
+	    cx = (cx0 << 9) | (cx1 << 4) | (cx2 << 1) |
+		 bitmap->getPixel(x + atx[0], y + aty[0]);
+
+	    // check for a skipped pixel
+	    if (!(useSkip && skip->getPixel(x, y))) {
+
+	      // decode the pixel
+	      if ((pix = decoder->decodeBit(cx, stats))) {
+		*pp |= mask;
+		buf2 |= 0x8000;
 	      }
-
-	      // update the context
-	      buf0 <<= 1;
-	      buf1 <<= 1;
-	      buf2 <<= 1;
 	    }
+
+	    // update the context
+	    buf0 <<= 1;
+	    buf1 <<= 1;
+	    buf2 <<= 1;
 	  }
 	}
-	break;
+      }
+      break;
 
-      case 2:
+    case 2:
 
-	// set up the context
-	p2 = pp = bitmap->getDataPtr() + y * bitmap->getLineSize();
-	buf2 = *p2++ << 8;
-	if (y >= 1) {
-	  p1 = bitmap->getDataPtr() + (y - 1) * bitmap->getLineSize();
-	  buf1 = *p1++ << 8;
-	  if (y >= 2) {
-	    p0 = bitmap->getDataPtr() + (y - 2) * bitmap->getLineSize();
-	    buf0 = *p0++ << 8;
-	  } else {
-	    p0 = nullptr;
-	    buf0 = 0;
-	  }
+      // set up the context
+      p2 = pp = bitmap->getDataPtr() + y * bitmap->getLineSize();
+      buf2 = *p2++ << 8;
+      if (y >= 1) {
+	p1 = bitmap->getDataPtr() + (y - 1) * bitmap->getLineSize();
+	buf1 = *p1++ << 8;
+	if (y >= 2) {
+	  p0 = bitmap->getDataPtr() + (y - 2) * bitmap->getLineSize();
+	  buf0 = *p0++ << 8;
 	} else {
-	  p1 = p0 = nullptr;
-	  buf1 = buf0 = 0;
+	  p0 = nullptr;
+	  buf0 = 0;
 	}
+      } else {
+	p1 = p0 = nullptr;
+	buf1 = buf0 = 0;
+      }
 
-	if (atx[0] >= -8 && atx[0] <= 8) {
-	  // set up the adaptive context
-	  const int atY = y + aty[0];
-	  if ((atY >= 0) && (atY < bitmap->getHeight())) {
-	    atP0 = bitmap->getDataPtr() + atY * bitmap->getLineSize();
-	    atBuf0 = *atP0++ << 8;
-	  } else {
-	    atP0 = nullptr;
-	    atBuf0 = 0;
-	  }
-	  atShift0 = 15 - atx[0];
+      if (atx[0] >= -8 && atx[0] <= 8) {
+	// set up the adaptive context
+	const int atY = y + aty[0];
+	if ((atY >= 0) && (atY < bitmap->getHeight())) {
+	  atP0 = bitmap->getDataPtr() + atY * bitmap->getLineSize();
+	  atBuf0 = *atP0++ << 8;
+	} else {
+	  atP0 = nullptr;
+	  atBuf0 = 0;
+	}
+	atShift0 = 15 - atx[0];
 
-	  // decode the row
-	  for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
-	    if (x0 + 8 < w) {
-	      if (p0) {
-		buf0 |= *p0++;
-	      }
-	      if (p1) {
-		buf1 |= *p1++;
-	      }
-	      buf2 |= *p2++;
-	      if (atP0) {
-		atBuf0 |= *atP0++;
-	      }
+	// decode the row
+	for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
+	  if (x0 + 8 < w) {
+	    if (p0) {
+	      buf0 |= *p0++;
+	    }
+	    if (p1) {
+	      buf1 |= *p1++;
 	    }
-	    for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
-
-	      // build the context
-	      cx0 = (buf0 >> 14) & 0x07;
-	      cx1 = (buf1 >> 14) & 0x0f;
-	      cx2 = (buf2 >> 16) & 0x03;
-	      cx = (cx0 << 7) | (cx1 << 3) | (cx2 << 1) |
-		   ((atBuf0 >> atShift0) & 1);
-
-	      // check for a skipped pixel
-	      if (!(useSkip && skip->getPixel(x, y))) {
-
-		// decode the pixel
-		if ((pix = arithDecoder->decodeBit(cx, genericRegionStats))) {
-		  *pp |= mask;
-		  buf2 |= 0x8000;
-		  if (aty[0] == 0) {
-		    atBuf0 |= 0x8000;
-		  }
+	    buf2 |= *p2++;
+	    if (atP0) {
+	      atBuf0 |= *atP0++;
+	    }
+	  }
+	  for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
+
+	    // build the context
+	    cx0 = (buf0 >> 14) & 0x07;
+	    cx1 = (buf1 >> 14) & 0x0f;
+	    cx2 = (buf2 >> 16) & 0x03;
+	    cx = (cx0 << 7) | (cx1 << 3) | (cx2 << 1) |
+		 ((atBuf0 >> atShift0) & 1);
+
+	    // check for a skipped pixel
+	    if (!(useSkip && skip->getPixel(x, y))) {
+
+	      // decode the pixel
+	      if ((pix = decoder->decodeBit(cx, stats))) {
+		*pp |= mask;
+		buf2 |= 0x8000;
+		if (aty[0] == 0) {
+		  atBuf0 |= 0x8000;
 		}
 	      }
-
-	      // update the context
-	      buf0 <<= 1;
-	      buf1 <<= 1;
-	      buf2 <<= 1;
-	      atBuf0 <<= 1;
 	    }
+
+	    // update the context
+	    buf0 <<= 1;
+	    buf1 <<= 1;
+	    buf2 <<= 1;
+	    atBuf0 <<= 1;
 	  }
+	}
 
-	} else {
-	  // decode the row
-	  for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
-	    if (x0 + 8 < w) {
-	      if (p0) {
-		buf0 |= *p0++;
-	      }
-	      if (p1) {
-		buf1 |= *p1++;
-	      }
-	      buf2 |= *p2++;
+      } else {
+	// decode the row
+	for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
+	  if (x0 + 8 < w) {
+	    if (p0) {
+	      buf0 |= *p0++;
 	    }
-	    for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
-
-	      // build the context
-	      cx0 = (buf0 >> 14) & 0x07;
-	      cx1 = (buf1 >> 14) & 0x0f;
-	      cx2 = (buf2 >> 16) & 0x03;
-	      cx = (cx0 << 7) | (cx1 << 3) | (cx2 << 1) |
-		   bitmap->getPixel(x + atx[0], y + aty[0]);
-
-	      // check for a skipped pixel
-	      if (!(useSkip && skip->getPixel(x, y))) {
-
-		// decode the pixel
-		if ((pix = arithDecoder->decodeBit(cx, genericRegionStats))) {
-		  *pp |= mask;
-		  buf2 |= 0x8000;
-		}
+	    if (p1) {
+	      buf1 |= *p1++;
+	    }
+	    buf2 |= *p2++;
+	  }
+	  for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
+
+	    // build the context
+	    cx0 = (buf0 >> 14) & 0x07;
+	    cx1 = (buf1 >> 14) & 0x0f;
+	    cx2 = (buf2 >> 16) & 0x03;
+	    cx = (cx0 << 7) | (cx1 << 3) | (cx2 << 1) |
+		 bitmap->getPixel(x + atx[0], y + aty[0]);
+
+	    // check for a skipped pixel
+	    if (!(useSkip && skip->getPixel(x, y))) {
+
+	      // decode the pixel
+	      if ((pix = decoder->decodeBit(cx, stats))) {
+		*pp |= mask;
+		buf2 |= 0x8000;
 	      }
-
-	      // update the context
-	      buf0 <<= 1;
-	      buf1 <<= 1;
-	      buf2 <<= 1;
 	    }
+
+	    // update the context
+	    buf0 <<= 1;
+	    buf1 <<= 1;
+	    buf2 <<= 1;
 	  }
 	}
-	break;
+      }
+      break;
 
-      case 3:
+    case 3:
 
-	// set up the context
-	p2 = pp = bitmap->getDataPtr() + y * bitmap->getLineSize();
-	buf2 = *p2++ << 8;
-	if (y >= 1) {
-	  p1 = bitmap->getDataPtr() + (y - 1) * bitmap->getLineSize();
-	  buf1 = *p1++ << 8;
+      // set up the context
+      p2 = pp = bitmap->getDataPtr() + y * bitmap->getLineSize();
+      buf2 = *p2++ << 8;
+      if (y >= 1) {
+	p1 = bitmap->getDataPtr() + (y - 1) * bitmap->getLineSize();
+	buf1 = *p1++ << 8;
+      } else {
+	p1 = nullptr;
+	buf1 = 0;
+      }
+
+      if (atx[0] >= -8 && atx[0] <= 8) {
+	// set up the adaptive context
+	const int atY = y + aty[0];
+	if ((atY >= 0) && (atY < bitmap->getHeight())) {
+	  atP0 = bitmap->getDataPtr() + atY * bitmap->getLineSize();
+	  atBuf0 = *atP0++ << 8;
 	} else {
-	  p1 = nullptr;
-	  buf1 = 0;
+	  atP0 = nullptr;
+	  atBuf0 = 0;
 	}
+	atShift0 = 15 - atx[0];
 
-	if (atx[0] >= -8 && atx[0] <= 8) {
-	  // set up the adaptive context
-	  const int atY = y + aty[0];
-	  if ((atY >= 0) && (atY < bitmap->getHeight())) {
-	    atP0 = bitmap->getDataPtr() + atY * bitmap->getLineSize();
-	    atBuf0 = *atP0++ << 8;
-	  } else {
-	    atP0 = nullptr;
-	    atBuf0 = 0;
-	  }
-	  atShift0 = 15 - atx[0];
-
-	  // decode the row
-	  for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
-	    if (x0 + 8 < w) {
-	      if (p1) {
-		buf1 |= *p1++;
-	      }
-	      buf2 |= *p2++;
-	      if (atP0) {
-		atBuf0 |= *atP0++;
-	      }
+	// decode the row
+	for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
+	  if (x0 + 8 < w) {
+	    if (p1) {
+	      buf1 |= *p1++;
+	    }
+	    buf2 |= *p2++;
+	    if (atP0) {
+	      atBuf0 |= *atP0++;
 	    }
-	    for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
-
-	      // build the context
-	      cx1 = (buf1 >> 14) & 0x1f;
-	      cx2 = (buf2 >> 16) & 0x0f;
-	      cx = (cx1 << 5) | (cx2 << 1) |
-		   ((atBuf0 >> atShift0) & 1);
-
-	      // check for a skipped pixel
-	      if (!(useSkip && skip->getPixel(x, y))) {
-
-		// decode the pixel
-		if ((pix = arithDecoder->decodeBit(cx, genericRegionStats))) {
-		  *pp |= mask;
-		  buf2 |= 0x8000;
-		  if (aty[0] == 0) {
-		    atBuf0 |= 0x8000;
-		  }
+	  }
+	  for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
+
+	    // build the context
+	    cx1 = (buf1 >> 14) & 0x1f;
+	    cx2 = (buf2 >> 16) & 0x0f;
+	    cx = (cx1 << 5) | (cx2 << 1) |
+		 ((atBuf0 >> atShift0) & 1);
+
+	    // check for a skipped pixel
+	    if (!(useSkip && skip->getPixel(x, y))) {
+
+	      // decode the pixel
+	      if ((pix = decoder->decodeBit(cx, stats))) {
+		*pp |= mask;
+		buf2 |= 0x8000;
+		if (aty[0] == 0) {
+		  atBuf0 |= 0x8000;
 		}
 	      }
-
-	      // update the context
-	      buf1 <<= 1;
-	      buf2 <<= 1;
-	      atBuf0 <<= 1;
 	    }
+
+	    // update the context
+	    buf1 <<= 1;
+	    buf2 <<= 1;
+	    atBuf0 <<= 1;
 	  }
+	}
 
-	} else {
-	  // decode the row
-	  for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
-	    if (x0 + 8 < w) {
-	      if (p1) {
-		buf1 |= *p1++;
-	      }
-	      buf2 |= *p2++;
+      } else {
+	// decode the row
+	for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
+	  if (x0 + 8 < w) {
+	    if (p1) {
+	      buf1 |= *p1++;
 	    }
-	    for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
+	    buf2 |= *p2++;
+	  }
+	  for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
 
-	      // build the context
-	      cx1 = (buf1 >> 14) & 0x1f;
-	      cx2 = (buf2 >> 16) & 0x0f;
-	      cx = (cx1 << 5) | (cx2 << 1) |
-		   bitmap->getPixel(x + atx[0], y + aty[0]);
+	    // build the context
+	    cx1 = (buf1 >> 14) & 0x1f;
+	    cx2 = (buf2 >> 16) & 0x0f;
+	    cx = (cx1 << 5) | (cx2 << 1) |
+		 bitmap->getPixel(x + atx[0], y + aty[0]);
 
-	      // check for a skipped pixel
-	      if (!(useSkip && skip->getPixel(x, y))) {
+	    // check for a skipped pixel
+	    if (!(useSkip && skip->getPixel(x, y))) {
 
-		// decode the pixel
-		if ((pix = arithDecoder->decodeBit(cx, genericRegionStats))) {
-		  *pp |= mask;
-		  buf2 |= 0x8000;
-		}
+	      // decode the pixel
+	      if ((pix = decoder->decodeBit(cx, stats))) {
+		*pp |= mask;
+		buf2 |= 0x8000;
 	      }
-
-	      // update the context
-	      buf1 <<= 1;
-	      buf2 <<= 1;
 	    }
+
+	    // update the context
+	    buf1 <<= 1;
+	    buf2 <<= 1;
 	  }
 	}
-	break;
       }
+      break;
     }
   }
-
-  return bitmap;
 }
 
 void JBIG2Stream::readGenericRefinementRegionSeg(Guint segNum, GBool imm,
@@ -33,6 +33,10 @@
 #include "Object.h"
 #include "Stream.h"
 
+#ifdef MULTITHREADED
+#include <vector>
+#endif
+
 class GooList;
 class JBIG2Segment;
 class JBIG2Bitmap;
@@ -41,6 +45,7 @@ class JArithmeticDecoderStats;
 class JBIG2HuffmanDecoder;
 struct JBIG2HuffmanTable;
 class JBIG2MMRDecoder;
+class JBIG2PendingRegion;
 
 //------------------------------------------------------------------------
 
@@ -97,6 +102,7 @@ private:
 			     Guint *refSegs, Guint nRefSegs);
   void readGenericRegionSeg(Guint segNum, GBool imm,
 			    GBool lossless, Guint length);
+  void finishGenericRegions();
   void mmrAddPixels(int a1, int blackPixels,
 		    int *codingLine, int *a0i, int w);
   void mmrAddPixelsNeg(int a1, int blackPixels,
@@ -106,6 +112,12 @@ private:
 				 GBool useSkip, JBIG2Bitmap *skip,
 				 int *atx, int *aty,
 				 int mmrDataLength);
+  static void decodeGenericBitmap(JBIG2Bitmap *bitmap,
+				  int templ, GBool tpgdOn,
+				  GBool useSkip, JBIG2Bitmap *skip,
+				  int *atx, int *aty,
+				  JArithmeticDecoder *decoder,
+				  JArithmeticDecoderStats *stats);
   void readGenericRefinementRegionSeg(Guint segNum, GBool imm,
 				      GBool lossless, Guint length,
 				      Guint *refSegs,
@@ -164,6 +176,11 @@ private:
   JArithmeticDecoderStats *iaidStats;
   JBIG2HuffmanDecoder *huffDecoder;
   JBIG2MMRDecoder *mmrDecoder;
+#ifdef MULTITHREADED
+  // immediate generic regions being decoded in the background, in
+  // segment order
+  std::vector<JBIG2PendingRegion *> pendingRegions;
+#endif
 };
 
 #endif
@@ -17,6 +17,7 @@
 
 #include "config.h"
 #include "JPEG2000Stream.h"
+#include "GlobalParams.h"
 #include <openjpeg.h>
 
 #define OPENJPEG_VERSION_ENCODE(major, minor, micro) (	\
@@ -35,6 +36,13 @@
 #endif
 #endif
 
+// the largest resolution reduction asked from OpenJPEG, 1/32 of the size
+#define jpxMaxReduce 5
+
+// smaller images are decoded on one thread, starting more would take
+// longer than what they save
+#define jpxMinThreadedPixels (1024 * 1024)
+
 struct JPXStreamPrivate {
   opj_image_t *image;
   int counter;
@@ -43,8 +51,18 @@ struct JPXStreamPrivate {
   int ncomps;
   GBool inited;
   int smaskInData;
+  unsigned char *data;		// the JPX data, read before the image is
+  int length;			//   decoded to look at its header
+  int width, height;		// the size of the image in its dictionary
+  int minWidth, minHeight;	// the hints of setMinImageSize() and
+  int areaX0, areaY0,		//   setImageArea(), given for the next
+      areaX1, areaY1;		//   decoding
+  GBool reduced;		// was only part of the image, or the image
+  int x0, y0, x1, y1;		//   at a reduced size, decoded?
+  int maxThreads;		// the hint of setMaxDecodeThreads()
 #ifdef USE_OPENJPEG2
-  void init2(OPJ_CODEC_FORMAT format, unsigned char *data, int length, GBool indexed);
+  void init2(OPJ_CODEC_FORMAT format, unsigned char *data, int length, GBool indexed, GBool headerOnly);
+  void setReduction(opj_codec_t *decoder, GBool indexed);
 #endif
 };
 
@@ -84,11 +102,20 @@ JPXStream::JPXStream(Stream *strA) : FilterStream(strA) {
   priv->image = nullptr;
   priv->npixels = 0;
   priv->ncomps = 0;
+  priv->data = nullptr;
+  priv->length = 0;
+  priv->width = priv->height = 0;
+  priv->minWidth = priv->minHeight = 0;
+  priv->areaX0 = priv->areaY0 = priv->areaX1 = priv->areaY1 = 0;
+  priv->reduced = gFalse;
+  priv->x0 = priv->y0 = priv->x1 = priv->y1 = 0;
+  priv->maxThreads = 0;
 }
 
 JPXStream::~JPXStream() {
   delete str;
   close();
+  gfree(priv->data);
   delete priv;
 }
 
@@ -141,13 +168,31 @@ GBool JPXStream::isBinary(GBool last) {
 }
 
 void JPXStream::getImageParams(int *bitsPerComponent, StreamColorSpaceMode *csMode) {
-  if (unlikely(priv->inited == gFalse)) { init(); }
+  opj_image_t *image;
+
+  // with a ColorSpace in the dictionary the components of the image
+  // don't matter much, they are taken from its header, so that it is
+  // only decoded once the hints for the size it is drawn at are known
+  image = nullptr;
+  if (unlikely(priv->inited == gFalse)) {
+    if (getDict() && !getDict()->lookup("ColorSpace").isNull()) {
+      readData();
+      priv->init2(OPJ_CODEC_JP2, priv->data, priv->length, gFalse, gTrue);
+      image = priv->image;
+      priv->image = nullptr;
+    } else {
+      init();
+    }
+  }
+  if (!image) {
+    image = priv->image;
+  }
 
   *bitsPerComponent = 8;
-  int numComps = (priv->image) ? priv->image->numcomps : 1;
-  if (priv->image) {
-    if (priv->image->color_space == OPJ_CLRSPC_SRGB && numComps == 4) { numComps = 3; }
-    else if (priv->image->color_space == OPJ_CLRSPC_SYCC && numComps == 4) { numComps = 3; }
+  int numComps = (image) ? image->numcomps : 1;
+  if (image) {
+    if (image->color_space == OPJ_CLRSPC_SRGB && numComps == 4) { numComps = 3; }
+    else if (image->color_space == OPJ_CLRSPC_SYCC && numComps == 4) { numComps = 3; }
     else if (numComps == 2) { numComps = 1; }
     else if (numComps > 4) { numComps = 4; }
   }
@@ -157,6 +202,49 @@ void JPXStream::getImageParams(int *bitsPerComponent, StreamColorSpaceMode *csMo
     *csMode = streamCSDeviceCMYK;
   else
     *csMode = streamCSDeviceGray;
+  if (image && image != priv->image) {
+    opj_image_destroy(image);
+  }
+}
+
+void JPXStream::setMinImageSize(int minWidthA, int minHeightA) {
+  priv->minWidth = minWidthA;
+  priv->minHeight = minHeightA;
+}
+
+GBool JPXStream::getReducedImageSize(int *widthA, int *heightA) {
+  if (unlikely(priv->inited == gFalse)) { init(); }
+
+  if (!priv->image || !priv->reduced) {
+    return gFalse;
+  }
+  *widthA = priv->image->comps[0].w;
+  *heightA = priv->image->comps[0].h;
+  return gTrue;
+}
+
+void JPXStream::setImageArea(int x0, int y0, int x1, int y1) {
+  priv->areaX0 = x0;
+  priv->areaY0 = y0;
+  priv->areaX1 = x1;
+  priv->areaY1 = y1;
+}
+
+void JPXStream::setMaxDecodeThreads(int maxThreads) {
+  priv->maxThreads = maxThreads;
+}
+
+GBool JPXStream::getImageArea(int *x0, int *y0, int *x1, int *y1) {
+  if (unlikely(priv->inited == gFalse)) { init(); }
+
+  if (!priv->image || !priv->reduced) {
+    return gFalse;
+  }
+  *x0 = priv->x0;
+  *y0 = priv->y0;
+  *x1 = priv->x1;
+  *y1 = priv->y1;
+  return gTrue;
 }
 
 
@@ -214,18 +302,36 @@ static OPJ_BOOL jpxSeek_callback(OPJ_OFF_T seek_pos, void * p_user_data)
   return OPJ_TRUE;
 }
 
-void JPXStream::init()
+void JPXStream::readData()
 {
-  Object oLen, cspace, smaskInData;
+  if (priv->data) {
+    return;
+  }
+
+  Object oLen;
   if (getDict()) {
     oLen = getDict()->lookup("Length");
-    cspace = getDict()->lookup("ColorSpace");
-    smaskInData = getDict()->lookup("SMaskInData");
   }
 
   int bufSize = BUFFER_INITIAL_SIZE;
   if (oLen.isInt()) bufSize = oLen.getInt();
 
+  priv->data = str->toUnsignedChars(&priv->length, bufSize);
+}
+
+void JPXStream::init()
+{
+  Object cspace, smaskInData, width, height;
+  if (getDict()) {
+    cspace = getDict()->lookup("ColorSpace");
+    smaskInData = getDict()->lookup("SMaskInData");
+    width = getDict()->lookup("Width");
+    height = getDict()->lookup("Height");
+  }
+
+  priv->width = width.isInt() ? width.getInt() : 0;
+  priv->height = height.isInt() ? height.getInt() : 0;
+
   GBool indexed = gFalse;
   if (cspace.isArray() && cspace.arrayGetLength() > 0) {
     const Object cstype = cspace.arrayGet(0);
@@ -235,10 +341,13 @@ void JPXStream::init()
   priv->smaskInData = 0;
   if (smaskInData.isInt()) priv->smaskInData = smaskInData.getInt();
 
-  int length = 0;
-  unsigned char *buf = str->toUnsignedChars(&length, bufSize);
-  priv->init2(OPJ_CODEC_JP2, buf, length, indexed);
-  gfree(buf);
+  readData();
+  priv->reduced = gFalse;
+  priv->init2(OPJ_CODEC_JP2, priv->data, priv->length, indexed, gFalse);
+  gfree(priv->data);
+  priv->data = nullptr;
+  priv->minWidth = priv->minHeight = 0;
+  priv->areaX0 = priv->areaY0 = priv->areaX1 = priv->areaY1 = 0;
 
   if (priv->image) {
     int numComps = (priv->image) ? priv->image->numcomps : 1;
@@ -280,7 +389,75 @@ void JPXStream::init()
   priv->inited = gTrue;
 }
 
-void JPXStreamPrivate::init2(OPJ_CODEC_FORMAT format, unsigned char *buf, int length, GBool indexed)
+// Decodes the image at a reduced resolution and only the area of it
+// asked with setMinImageSize() and setImageArea().  Only done for images
+// whose header matches their dictionary, to be sure of what is drawn.
+void JPXStreamPrivate::setReduction(opj_codec_t *decoder, GBool indexed)
+{
+  opj_codestream_info_v2_t *info;
+  int imgWidth, imgHeight, reduce, maxReduce, scale, i;
+
+  imgWidth = image->x1 - image->x0;
+  imgHeight = image->y1 - image->y0;
+  if (imgWidth != width || imgHeight != height || image->numcomps < 1) {
+    return;
+  }
+  for (i = 0; i < (int)image->numcomps; ++i) {
+    if (image->comps[i].dx != 1 || image->comps[i].dy != 1) {
+      return;
+    }
+  }
+
+  // the palette indexes of an indexed image can't be averaged
+  reduce = 0;
+  if (!indexed && minWidth > 0 && minHeight > 0) {
+    maxReduce = jpxMaxReduce;
+    info = opj_get_cstr_info(decoder);
+    if (info) {
+      for (i = 0; i < (int)info->nbcomps; ++i) {
+	if ((int)info->m_default_tile_info.tccp_info[i].numresolutions - 1
+	      < maxReduce) {
+	  maxReduce = info->m_default_tile_info.tccp_info[i].numresolutions - 1;
+	}
+      }
+      opj_destroy_cstr_info(&info);
+    } else {
+      maxReduce = 0;
+    }
+    while (reduce < maxReduce &&
+	   (imgWidth + (2 << reduce) - 1) >> (reduce + 1) >= minWidth &&
+	   (imgHeight + (2 << reduce) - 1) >> (reduce + 1) >= minHeight) {
+      ++reduce;
+    }
+    // a tile may have fewer resolutions than the main header says
+    while (reduce > 0 && !opj_set_decoded_resolution_factor(decoder, reduce)) {
+      --reduce;
+    }
+    if (reduce == 0) {
+      opj_set_decoded_resolution_factor(decoder, 0);
+    }
+  }
+
+  // the area is aligned on the pixels of the reduced image
+  scale = 1 << reduce;
+  x0 = y0 = 0;
+  x1 = imgWidth;
+  y1 = imgHeight;
+  if (areaX0 < areaX1 && areaY0 < areaY1) {
+    x0 = areaX0 < 0 ? 0 : (areaX0 / scale) * scale;
+    y0 = areaY0 < 0 ? 0 : (areaY0 / scale) * scale;
+    x1 = areaX1 > imgWidth - scale ? imgWidth : ((areaX1 + scale - 1) / scale) * scale;
+    y1 = areaY1 > imgHeight - scale ? imgHeight : ((areaY1 + scale - 1) / scale) * scale;
+    if (x0 >= x1 || y0 >= y1) {
+      x0 = y0 = 0;
+      x1 = imgWidth;
+      y1 = imgHeight;
+    }
+  }
+  reduced = reduce > 0 || x0 > 0 || y0 > 0 || x1 < imgWidth || y1 < imgHeight;
+}
+
+void JPXStreamPrivate::init2(OPJ_CODEC_FORMAT format, unsigned char *buf, int length, GBool indexed, GBool headerOnly)
 {
   JPXData jpxData;
 
@@ -329,6 +506,23 @@ void JPXStreamPrivate::init2(OPJ_CODEC_FORMAT format, unsigned char *buf, int le
     goto error;
   }
 
+#if OPENJPEG_VERSION >= OPENJPEG_VERSION_ENCODE(2, 2, 0)
+  /* Decode the code-blocks of large images on several threads */
+  if (opj_has_thread_support() && !headerOnly &&
+      (double)width * height >= jpxMinThreadedPixels) {
+    int nThreads = globalParams->getImageDecodeThreads();
+    if (nThreads <= 0) {
+      nThreads = opj_get_num_cpus();
+    }
+    if (maxThreads > 0 && nThreads > maxThreads) {
+      nThreads = maxThreads;
+    }
+    if (nThreads > 1) {
+      opj_codec_set_threads(decoder, nThreads);
+    }
+  }
+#endif
+
   /* Decode the stream and fill the image structure */
   image = nullptr;
   if (!opj_read_header(stream, decoder, &image)) {
@@ -336,7 +530,20 @@ void JPXStreamPrivate::init2(OPJ_CODEC_FORMAT format, unsigned char *buf, int le
     goto error;
   }
 
-  /* Optional if you want decode the entire image */
+  if (headerOnly) {
+    opj_destroy_codec(decoder);
+    opj_stream_destroy(stream);
+    return;
+  }
+
+  /* Decode the whole image unless told it is drawn small or partly */
+  setReduction(decoder, indexed);
+  if (reduced) {
+    parameters.DA_x0 = image->x0 + x0;
+    parameters.DA_y0 = image->y0 + y0;
+    parameters.DA_x1 = image->x0 + x1;
+    parameters.DA_y1 = image->y0 + y1;
+  }
   if (!opj_set_decode_area(decoder, image, parameters.DA_x0,
                            parameters.DA_y0, parameters.DA_x1, parameters.DA_y1)){
     error(errSyntaxWarning, -1, "X2");
@@ -358,12 +565,17 @@ void JPXStreamPrivate::init2(OPJ_CODEC_FORMAT format, unsigned char *buf, int le
 error:
   opj_stream_destroy(stream);
   opj_destroy_codec(decoder);
+  if (image != nullptr) {
+    opj_image_destroy(image);
+    image = nullptr;
+  }
+  reduced = gFalse;
   if (format == OPJ_CODEC_JP2) {
     error(errSyntaxWarning, -1, "Did no succeed opening JPX Stream as JP2, trying as J2K.");
-    init2(OPJ_CODEC_J2K, buf, length, indexed);
+    init2(OPJ_CODEC_J2K, buf, length, indexed, headerOnly);
   } else if (format == OPJ_CODEC_J2K) {
     error(errSyntaxWarning, -1, "Did no succeed opening JPX Stream as J2K, trying as JPT.");
-    init2(OPJ_CODEC_JPT, buf, length, indexed);
+    init2(OPJ_CODEC_JPT, buf, length, indexed, headerOnly);
   } else {
     error(errSyntaxError, -1, "Did no succeed opening JPX Stream.");
   }
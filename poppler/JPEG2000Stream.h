@@ -38,6 +38,12 @@ public:
   GooString *getPSFilter(int psLevel, const char *indent) override;
   GBool isBinary(GBool last = gTrue) override;
   void getImageParams(int *bitsPerComponent, StreamColorSpaceMode *csMode) override;
+  GBool usesImageHints() override { return gTrue; }
+  void setMinImageSize(int minWidthA, int minHeightA) override;
+  GBool getReducedImageSize(int *widthA, int *heightA) override;
+  void setImageArea(int x0, int y0, int x1, int y1) override;
+  GBool getImageArea(int *x0, int *y0, int *x1, int *y1) override;
+  void setMaxDecodeThreads(int maxThreads) override;
 
   int readStream(int nChars, Guchar *buffer) {
     return str->doGetChars(nChars, buffer);
@@ -48,6 +54,7 @@ private:
   JPXStreamPrivate *priv;
 
   void init();
+  void readData();
   GBool hasGetChars() override { return true; }
   int getChars(int nChars, Guchar *buffer) override;
 };
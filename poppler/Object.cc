@@ -35,6 +35,138 @@
 #include "Stream.h"
 #include "XRef.h"
 
+//------------------------------------------------------------------------
+// interned names
+//------------------------------------------------------------------------
+
+// The content stream operators, the other PDF keywords and the most
+// common dictionary keys and values, one after the other.
+static const char internedNamePool[] =
+  "\"\0" "'\0" "B\0" "B*\0" "BDC\0" "BI\0" "BMC\0" "BT\0" "BX\0" "CS\0"
+  "DP\0" "Do\0" "EI\0" "EMC\0" "ET\0" "EX\0" "F\0" "G\0" "ID\0" "J\0" "K\0"
+  "M\0" "MP\0" "Q\0" "RG\0" "S\0" "SC\0" "SCN\0" "T*\0" "TD\0" "TJ\0" "TL\0"
+  "Tc\0" "Td\0" "Tf\0" "Tj\0" "Tm\0" "Tr\0" "Ts\0" "Tw\0" "Tz\0" "W\0" "W*\0"
+  "b\0" "b*\0" "c\0" "cm\0" "cs\0" "d\0" "d0\0" "d1\0" "f\0" "f*\0" "g\0"
+  "gs\0" "h\0" "i\0" "j\0" "k\0" "l\0" "m\0" "n\0" "q\0" "re\0" "rg\0" "ri\0"
+  "s\0" "sc\0" "scn\0" "sh\0" "v\0" "w\0" "y\0" "[\0" "]\0" "<<\0" ">>\0"
+  "{\0" "}\0" "R\0" "obj\0" "endobj\0" "stream\0" "endstream\0" "xref\0"
+  "trailer\0" "startxref\0" "Type\0" "Subtype\0" "Length\0" "Filter\0"
+  "DecodeParms\0" "Parent\0" "Kids\0" "Count\0" "First\0" "Last\0" "Prev\0"
+  "Next\0" "Root\0" "Info\0" "Size\0" "Index\0" "XRefStm\0" "Encrypt\0" "N\0"
+  "Extends\0" "Catalog\0" "Pages\0" "Page\0" "Resources\0" "Contents\0"
+  "MediaBox\0" "CropBox\0" "BleedBox\0" "TrimBox\0" "ArtBox\0" "Rotate\0"
+  "UserUnit\0" "Annots\0" "Font\0" "XObject\0" "ExtGState\0" "ColorSpace\0"
+  "Pattern\0" "Shading\0" "Properties\0" "ProcSet\0" "PDF\0" "Text\0"
+  "ImageB\0" "ImageC\0" "ImageI\0" "Image\0" "Form\0" "BBox\0" "Matrix\0"
+  "Group\0" "Transparency\0" "Width\0" "Height\0" "BitsPerComponent\0"
+  "ImageMask\0" "Mask\0" "SMask\0" "Decode\0" "Interpolate\0" "DeviceGray\0"
+  "DeviceRGB\0" "DeviceCMYK\0" "CalRGB\0" "CalGray\0" "Lab\0" "ICCBased\0"
+  "Indexed\0" "Separation\0" "DeviceN\0" "Alternate\0" "Range\0"
+  "FlateDecode\0" "LZWDecode\0" "DCTDecode\0" "JPXDecode\0"
+  "CCITTFaxDecode\0" "JBIG2Decode\0" "ASCIIHexDecode\0" "ASCII85Decode\0"
+  "RunLengthDecode\0" "Predictor\0" "Colors\0" "Columns\0" "EarlyChange\0"
+  "BlackIs1\0" "EncodedByteAlign\0" "Rows\0" "Type0\0" "Type1\0" "Type3\0"
+  "TrueType\0" "MMType1\0" "CIDFontType0\0" "CIDFontType2\0"
+  "CIDFontType0C\0" "OpenType\0" "BaseFont\0" "FirstChar\0" "LastChar\0"
+  "Widths\0" "FontDescriptor\0" "Encoding\0" "ToUnicode\0"
+  "DescendantFonts\0" "CIDSystemInfo\0" "CIDToGIDMap\0" "DW\0" "W2\0"
+  "Registry\0" "Ordering\0" "Supplement\0" "Identity\0" "Identity-H\0"
+  "Identity-V\0" "WinAnsiEncoding\0" "MacRomanEncoding\0"
+  "StandardEncoding\0" "Differences\0" "BaseEncoding\0" "FontName\0"
+  "FontFamily\0" "Flags\0" "FontBBox\0" "ItalicAngle\0" "Ascent\0"
+  "Descent\0" "Leading\0" "CapHeight\0" "XHeight\0" "StemV\0" "StemH\0"
+  "AvgWidth\0" "MaxWidth\0" "MissingWidth\0" "FontFile\0" "FontFile2\0"
+  "FontFile3\0" "CharSet\0" "CharProcs\0" "FontMatrix\0" "LW\0" "LC\0" "LJ\0"
+  "ML\0" "D\0" "RI\0" "OP\0" "op\0" "OPM\0" "CA\0" "ca\0" "BM\0" "AIS\0"
+  "TK\0" "SA\0" "Normal\0" "Multiply\0" "Screen\0" "Annot\0" "Link\0"
+  "Widget\0" "Rect\0" "Border\0" "C\0" "A\0" "Dest\0" "URI\0" "Action\0"
+  "P\0" "T\0" "V\0" "DA\0" "DR\0" "AP\0" "AS\0" "MK\0" "H\0" "Ff\0" "FT\0"
+  "Fields\0" "AcroForm\0" "Outlines\0" "Title\0" "Dests\0" "Names\0"
+  "StructTreeRoot\0" "StructParents\0" "StructParent\0" "MarkInfo\0"
+  "Marked\0" "Metadata\0" "XML\0" "Lang\0" "MCID\0" "Pg\0" "Obj\0" "OC\0"
+  "OCProperties\0" "Artifact\0" "Span\0" "ActualText\0" "Alt\0" "E\0"
+  "Sect\0" "Div\0" "Art\0" "Part\0" "H1\0" "H2\0" "H3\0" "H4\0" "H5\0" "H6\0"
+  "L\0" "LI\0" "Lbl\0" "LBody\0" "Table\0" "TR\0" "TH\0" "Figure\0"
+  "Formula\0" "Caption\0" "Note\0" "Reference\0" "BibEntry\0" "Code\0"
+  "NonStruct\0" "Document\0" "ObjStm\0" "XRef\0" "Producer\0" "Creator\0"
+  "CreationDate\0" "ModDate\0" "Author\0" "Subject\0" "Keywords\0"
+  "Function\0" "FunctionType\0" "Domain\0" "C0\0" "C1\0" "Bounds\0"
+  "Coords\0" "ShadingType\0" "Background\0" "AntiAlias\0";
+
+#define internedNameHashBits 10
+#define internedNameHashSize (1 << internedNameHashBits)
+// longer names are never interned
+#define internedNameMaxLength 24
+
+// Returns -1 for names too long to be interned.
+static inline int internedNameHash(const char *name) {
+  Guint h;
+  int i;
+
+  // FNV-1a
+  h = 2166136261U;
+  for (i = 0; name[i]; ++i) {
+    if (i == internedNameMaxLength) {
+      return -1;
+    }
+    h = (h ^ (Guchar)name[i]) * 16777619U;
+  }
+  return h & (internedNameHashSize - 1);
+}
+
+namespace {
+
+struct InternedNameTable {
+  InternedNameTable() {
+    const char *p;
+    int h;
+
+    for (h = 0; h < internedNameHashSize; ++h) {
+      offsets[h] = -1;
+    }
+    for (p = internedNamePool; p < internedNamePool + sizeof(internedNamePool) - 1;
+	 p += strlen(p) + 1) {
+      for (h = internedNameHash(p); offsets[h] >= 0;
+	   h = (h + 1) & (internedNameHashSize - 1)) ;
+      offsets[h] = p - internedNamePool;
+    }
+  }
+
+  short offsets[internedNameHashSize];	// offset in internedNamePool,
+					//   -1 for an empty slot
+};
+
+}
+
+char *internName(const char *name) {
+  static const InternedNameTable table;
+  const char *p;
+  int h, offset;
+
+  h = internedNameHash(name);
+  if (h >= 0) {
+    for (; (offset = table.offsets[h]) >= 0;
+	 h = (h + 1) & (internedNameHashSize - 1)) {
+      p = internedNamePool + offset;
+      if (!strcmp(p, name)) {
+	return const_cast<char *>(p);
+      }
+    }
+  }
+  return copyString(name);
+}
+
+GBool isInternedName(const char *name) {
+  return name >= internedNamePool &&
+         name < internedNamePool + sizeof(internedNamePool);
+}
+
+void freeName(char *name) {
+  if (!isInternedName(name)) {
+    gfree(name);
+  }
+}
+
 //------------------------------------------------------------------------
 // Object
 //------------------------------------------------------------------------
@@ -95,7 +227,7 @@ Object Object::copy() const {
     obj.string = string->copy();
     break;
   case objName:
-    obj.cString = copyString(cString);
+    obj.cString = isInternedName(cString) ? cString : copyString(cString);
     break;
   case objArray:
     array->incRef();
@@ -107,7 +239,7 @@ Object Object::copy() const {
     stream->incRef();
     break;
   case objCmd:
-    obj.cString = copyString(cString);
+    obj.cString = isInternedName(cString) ? cString : copyString(cString);
     break;
   default:
     break;
@@ -118,6 +250,19 @@ Object Object::copy() const {
   return obj;
 }
 
+Object Object::deepCopy() const {
+  CHECK_NOT_DEAD;
+
+  switch (type) {
+  case objArray:
+    return Object(array->deepCopy());
+  case objDict:
+    return Object(dict->deepCopy());
+  default:
+    return copy();
+  }
+}
+
 Object Object::fetch(XRef *xref, int recursion) const {
   CHECK_NOT_DEAD;
 
@@ -131,7 +276,7 @@ void Object::free() {
     delete string;
     break;
   case objName:
-    gfree(cString);
+    freeName(cString);
     break;
   case objArray:
     if (!array->decRef()) {
@@ -149,7 +294,7 @@ void Object::free() {
     }
     break;
   case objCmd:
-    gfree(cString);
+    freeName(cString);
     break;
   default:
     break;
@@ -95,6 +95,25 @@ struct RefCompare {
   }
 };
 
+//------------------------------------------------------------------------
+// interned names
+//
+// The names and operators that show up all the time (Type, Length, cm,
+// Tf, ...) are shared by all the objects using them, so that parsing
+// doesn't malloc and free a copy of each one.  The shared strings must
+// never be modified or freed.
+//------------------------------------------------------------------------
+
+// Returns the shared copy of <name> if it is interned, otherwise a copy
+// made with copyString().
+char *internName(const char *name);
+
+// Returns true if <name> is a shared copy returned by internName().
+GBool isInternedName(const char *name);
+
+// Frees a string returned by internName().
+void freeName(char *name);
+
 //------------------------------------------------------------------------
 // object types
 //------------------------------------------------------------------------
@@ -164,7 +183,7 @@ public:
   explicit Object(GooString *stringA)
     { constructObj(objString); string = stringA; }
   Object(ObjType typeA, const char *stringA)
-    { constructObj(typeA); cString = copyString(stringA); }
+    { constructObj(typeA); cString = internName(stringA); }
   explicit Object(long long int64gA)
     { constructObj(objInt64); int64g = int64gA; }
   explicit Object(Array *arrayA)
@@ -189,6 +208,10 @@ public:
   // Copy this to obj
   Object copy() const;
 
+  // Same as copy() but arrays and dictionaries are copied too, recursively,
+  // instead of being shared.
+  Object deepCopy() const;
+
   // If object is a Ref, fetch and return the referenced object.
   // Otherwise, return a copy of the object.
   Object fetch(XRef *xref, int recursion = 0) const;
@@ -243,6 +266,9 @@ public:
   GooString *takeString() {
     OBJECT_TYPE_CHECK(objString); GooString *s = string; string = NULL; return s; }
   const char *getName() const { OBJECT_TYPE_CHECK(objName); return cString; }
+  // Same as takeString(), the name must be freed with freeName().
+  char *takeName() {
+    OBJECT_TYPE_CHECK(objName); char *s = cString; cString = NULL; return s; }
   Array *getArray() const { OBJECT_TYPE_CHECK(objArray); return array; }
   Dict *getDict() const { OBJECT_TYPE_CHECK(objDict); return dict; }
   Stream *getStream() const { OBJECT_TYPE_CHECK(objStream); return stream; }
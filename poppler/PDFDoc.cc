@@ -87,6 +87,8 @@
 #endif
 #include "PDFDoc.h"
 #include "Hints.h"
+#include "DecodedImageCache.h"
+#include "DisplayList.h"
 
 #ifdef MULTITHREADED
 #  define pdfdocLocker()   MutexLocker locker(&mutex)
@@ -107,6 +109,12 @@
 #define xrefSearchSize 1024	// read this many bytes at end of file
 				//   to look for 'startxref'
 
+#define decodedImageCacheCost (64 * 1024 * 1024) // bytes of decoded image
+						 //   data to keep
+
+#define displayListCacheCost (32 * 1024 * 1024) // bytes of page and form
+						// display lists to keep
+
 //------------------------------------------------------------------------
 // PDFDoc
 //------------------------------------------------------------------------
@@ -131,6 +139,8 @@ void PDFDoc::init()
   startXRefPos = -1;
   secHdlr = nullptr;
   pageCache = nullptr;
+  decodedImageCache = new DecodedImageCache(decodedImageCacheCost);
+  displayListCache = new DisplayListCache(displayListCacheCost);
 }
 
 PDFDoc::PDFDoc()
@@ -169,8 +179,10 @@ PDFDoc::PDFDoc(GooString *fileNameA, GooString *ownerPassword,
     return;
   }
 
-  // create stream
-  str = new FileStream(file, 0, gFalse, file->size(), Object(objNull));
+  // create stream, reading the file through a mapping is cheaper
+  if (!(str = MmapStream::open(file))) {
+    str = new FileStream(file, 0, gFalse, file->size(), Object(objNull));
+  }
 
   ok = setup(ownerPassword, userPassword);
 }
@@ -209,8 +221,10 @@ PDFDoc::PDFDoc(wchar_t *fileNameA, int fileNameLen, GooString *ownerPassword,
     return;
   }
 
-  // create stream
-  str = new FileStream(file, 0, gFalse, file->size(), Object(objNull));
+  // create stream, reading the file through a mapping is cheaper
+  if (!(str = MmapStream::open(file))) {
+    str = new FileStream(file, 0, gFalse, file->size(), Object(objNull));
+  }
 
   ok = setup(ownerPassword, userPassword);
 }
@@ -324,6 +338,8 @@ PDFDoc::~PDFDoc() {
     }
     gfree(pageCache);
   }
+  delete displayListCache;
+  delete decodedImageCache;
   delete secHdlr;
 #ifndef DISABLE_OUTLINE
   if (outline) {
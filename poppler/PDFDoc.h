@@ -66,6 +66,8 @@ class Outline;
 class Linearization;
 class SecurityHandler;
 class Hints;
+class DecodedImageCache;
+class DisplayListCache;
 class StructTreeRoot;
 
 enum PDFWriteMode {
@@ -130,6 +132,12 @@ public:
   // Get base stream.
   BaseStream *getBaseStream() { return str; }
 
+  // Get the cache of decoded image data shared by the output devices.
+  DecodedImageCache *getDecodedImageCache() { return decodedImageCache; }
+
+  // Get the cache of the display lists of the pages and forms drawn by Gfx.
+  DisplayListCache *getDisplayListCache() { return displayListCache; }
+
   // Get page parameters.
   double getPageMediaWidth(int page)
     { return getPage(page) ? getPage(page)->getMediaWidth() : 0.0 ; }
@@ -378,6 +386,8 @@ private:
   Outline *outline;
 #endif
   Page **pageCache;
+  DecodedImageCache *decodedImageCache;
+  DisplayListCache *displayListCache;
 
   GBool ok;
   int errCode;
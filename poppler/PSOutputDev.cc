@@ -1087,6 +1087,18 @@ static void outputToFile(void *stream, const char *data, int len) {
   fwrite(data, 1, len, (FILE *)stream);
 }
 
+// Reads <str> till its end, returns the number of bytes read
+static int streamLength(Stream *str) {
+  Guchar buf[4096];
+  int len, n;
+
+  len = 0;
+  while ((n = str->doGetChars(sizeof(buf), buf)) > 0) {
+    len += n;
+  }
+  return len;
+}
+
 PSOutputDev::PSOutputDev(const char *fileName, PDFDoc *doc,
 			 char *psTitleA,
 			 const std::vector<int> &pages, PSOutMode modeA,
@@ -3240,7 +3252,7 @@ GBool PSOutputDev::checkPageSlice(Page *page, double /*hDPI*/, double /*vDPI*/,
   double hDPI2, vDPI2;
   double m0, m1, m2, m3, m4, m5;
   int nStripes, stripeH, stripeY;
-  int c, w, h, x, y, comp, i;
+  int w, h, x, y, comp, i;
   int numComps, initialNumComps;
   char hexBuf[32*2 + 2];	// 32 values X 2 chars/value + line ending + null
   Guchar digit;
@@ -3661,17 +3673,12 @@ GBool PSOutputDev::checkPageSlice(Page *page, double /*hDPI*/, double /*vDPI*/,
       str->reset();
       if (useBinary) {
 	// Count the bytes to write a document comment
-	int len = 0;
-	while (str->getChar() != EOF) {
-	  len++;
-	}
+	int len = streamLength(str);
 	str->reset();
 	writePSFmt("%%BeginData: {0:d} Binary Bytes\n", len+6+1);
       }
       writePS("image\n");
-      while ((c = str->getChar()) != EOF) {
-	writePSChar(c);
-      }
+      writePSStream(str);
       str->close();
       delete str;
       delete str0;
@@ -5688,7 +5695,6 @@ void PSOutputDev::doImageL2(Object *ref, GfxImageColorMap *colorMap,
   GfxCMYK cmyk;
   int c;
   int col, i, j, x0, x1, y;
-  char dataBuf[4096];
   
   rectsOutLen = 0;
 
@@ -6084,10 +6090,7 @@ void PSOutputDev::doImageL2(Object *ref, GfxImageColorMap *colorMap,
 	// need to read the stream to count characters -- the length
 	// is data-dependent (because of ASCII and LZW/RLE filters)
 	str->reset();
-	n = 0;
-	while ((c = str->getChar()) != EOF) {
-	  ++n;
-	}
+	n = streamLength(str);
 	str->close();
       }
       // +6/7 for "pdfIm\n" / "pdfImM\n"
@@ -6111,17 +6114,7 @@ void PSOutputDev::doImageL2(Object *ref, GfxImageColorMap *colorMap,
 
     // copy the stream data
     str->reset();
-    i = 0;
-    while ((c = str->getChar()) != EOF) {
-      dataBuf[i++] = c;
-      if (i >= (int)sizeof(dataBuf)) {
-	writePSBuf(dataBuf, i);
-	i = 0;
-      }
-    }
-    if (i > 0) {
-      writePSBuf(dataBuf, i);
-    }
+    writePSStream(str);
     str->close();
 
     // add newline and trailer to the end
@@ -6540,9 +6533,7 @@ void PSOutputDev::doImageL3(Object *ref, GfxImageColorMap *colorMap,
 
     // copy the stream data
     str->reset();
-    while ((c = str->getChar()) != EOF) {
-      writePSChar(c);
-    }
+    writePSStream(str);
     str->close();
 
     // add newline and trailer to the end
@@ -7185,7 +7176,6 @@ void PSOutputDev::drawForm(Ref id) {
 
 void PSOutputDev::psXObject(Stream *psStream, Stream *level1Stream) {
   Stream *str;
-  int c;
 
   if ((level == psLevel1 || level == psLevel1Sep) && level1Stream) {
     str = level1Stream;
@@ -7193,9 +7183,7 @@ void PSOutputDev::psXObject(Stream *psStream, Stream *level1Stream) {
     str = psStream;
   }
   str->reset();
-  while ((c = str->getChar()) != EOF) {
-    writePSChar(c);
-  }
+  writePSStream(str);
   str->close();
 }
 
@@ -7419,6 +7407,15 @@ void PSOutputDev::writePSBuf(const char *s, int len) {
   }
 }
 
+void PSOutputDev::writePSStream(Stream *str) {
+  char buf[4096];
+  int n;
+
+  while ((n = str->doGetChars(sizeof(buf), (Guchar *)buf)) > 0) {
+    writePSBuf(buf, n);
+  }
+}
+
 void PSOutputDev::writePSFmt(const char *fmt, ...) {
   va_list args;
   GooString *buf;
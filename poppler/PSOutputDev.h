@@ -431,6 +431,7 @@ private:
   void writePSChar(char c);
   void writePS(const char *s);
   void writePSBuf(const char *s, int len);
+  void writePSStream(Stream *str);
   void writePSFmt(const char *fmt, ...);
   void writePSString(const GooString *s);
   void writePSName(const char *s);
@@ -543,7 +543,17 @@ void Page::displaySlice(OutputDev *out, double hDPI, double vDPI,
 			   annotDisplayDecideCbk, annotDisplayDecideCbkData)) {
     return;
   }
-  pageLocker();
+  // several threads may draw the same page at once, e.g. in bands,
+  // except when one of them draws with a copied xref: it replaces the
+  // page's one, and the objects read from it, for the whole drawing
+#ifdef MULTITHREADED
+  if (copyXRef) {
+    drawMutex.lock();
+    gLockMutex(&mutex);
+  } else {
+    drawMutex.lock_shared();
+  }
+#endif
   XRef *localXRef = (copyXRef) ? xref->copy() : xref;
   if (copyXRef) {
     replaceXRef(localXRef);
@@ -556,8 +566,9 @@ void Page::displaySlice(OutputDev *out, double hDPI, double vDPI,
 
   Object obj = contents.fetch(localXRef);
   if (!obj.isNull()) {
+    Object refObj(pageRef.num, pageRef.gen);
     gfx->saveState();
-    gfx->display(&obj);
+    gfx->display(&obj, &refObj);
     gfx->restoreState();
   } else {
     // empty pages need to call dump to do any setup required by the
@@ -566,7 +577,10 @@ void Page::displaySlice(OutputDev *out, double hDPI, double vDPI,
   }
 
   // draw annotations
-  annotList = getAnnots();
+  {
+    pageLocker();
+    annotList = getAnnots();
+  }
 
   if (annotList->getNumAnnots() > 0) {
     if (globalParams->getPrintCommands()) {
@@ -588,13 +602,22 @@ void Page::displaySlice(OutputDev *out, double hDPI, double vDPI,
     replaceXRef(doc->getXRef());
     delete localXRef;
   }
+#ifdef MULTITHREADED
+  if (copyXRef) {
+    gUnlockMutex(&mutex);
+    drawMutex.unlock();
+  } else {
+    drawMutex.unlock_shared();
+  }
+#endif
 }
 
 void Page::display(Gfx *gfx) {
   Object obj = contents.fetch(xref);
   if (!obj.isNull()) {
+    Object refObj(pageRef.num, pageRef.gen);
     gfx->saveState();
-    gfx->display(&obj);
+    gfx->display(&obj, &refObj);
     gfx->restoreState();
   }
 }
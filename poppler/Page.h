@@ -39,6 +39,9 @@
 #include "poppler-config.h"
 #include "Object.h"
 #include "goo/GooMutex.h"
+#ifdef MULTITHREADED
+#include <shared_mutex>
+#endif
 
 class Dict;
 class PDFDoc;
@@ -287,6 +290,8 @@ private:
   GBool ok;			// true if page is valid
 #ifdef MULTITHREADED
   GooMutex mutex;
+  std::shared_mutex drawMutex;	// shared by the threads drawing the page,
+				//   exclusive when drawing with a copied xref
 #endif
 };
 
@@ -90,11 +90,13 @@ Object Parser::getObj(GBool simpleOnly,
   // array
   if (!simpleOnly && buf1.isCmd("[")) {
     shift();
-    obj = Object(new Array(xref));
+    const size_t base = elems.size();
     while (!buf1.isCmd("]") && !buf1.isEOF() && recursion + 1 < recursionLimit) {
-      Object obj2 = getObj(gFalse, fileKey, encAlgorithm, keyLength, objNum, objGen, recursion + 1);
-      obj.arrayAdd(std::move(obj2));
+      elems.push_back(getObj(gFalse, fileKey, encAlgorithm, keyLength, objNum, objGen, recursion + 1));
     }
+    const int n = (int)(elems.size() - base);
+    obj = Object(new (n) Array(xref, elems.data() + base, n));
+    elems.resize(base);
     if (recursion + 1 >= recursionLimit && strict) goto err;
     if (buf1.isEOF()) {
       error(errSyntaxError, getPos(), "End of file inside array");
@@ -105,29 +107,40 @@ Object Parser::getObj(GBool simpleOnly,
   // dictionary or stream
   } else if (!simpleOnly && buf1.isCmd("<<")) {
     shift(objNum);
-    obj = Object(new Dict(xref));
+    const size_t base = elems.size();
+    const size_t keyBase = keys.size();
+    GBool bad = gFalse;
     while (!buf1.isCmd(">>") && !buf1.isEOF()) {
       if (!buf1.isName()) {
 	error(errSyntaxError, getPos(), "Dictionary key must be a name object");
-	if (strict) goto err;
+	if (strict) {
+	  bad = gTrue;
+	  break;
+	}
 	shift();
       } else {
-	// buf1 might go away in shift(), so construct the key
-	char *key = copyString(buf1.getName());
+	// buf1 goes away in shift(), so take its name
+	char *key = buf1.takeName();
 	shift();
 	if (buf1.isEOF() || buf1.isError()) {
-	  gfree(key);
-	  if (strict && buf1.isError()) goto err;
+	  freeName(key);
+	  bad = strict && buf1.isError();
 	  break;
 	}
 	Object obj2 = getObj(gFalse, fileKey, encAlgorithm, keyLength, objNum, objGen, recursion + 1);
 	if (unlikely(obj2.isError() && recursion + 1 >= recursionLimit)) {
-	  gfree(key);
+	  freeName(key);
 	  break;
 	}
-	obj.dictAdd(key, std::move(obj2));
+	keys.push_back(key);
+	elems.push_back(std::move(obj2));
       }
     }
+    const int n = (int)(elems.size() - base);
+    obj = Object(new (n) Dict(xref, keys.data() + keyBase, elems.data() + base, n));
+    keys.resize(keyBase);
+    elems.resize(base);
+    if (bad) goto err;
     if (buf1.isEOF()) {
       error(errSyntaxError, getPos(), "End of file inside dictionary");
       if (strict) goto err;
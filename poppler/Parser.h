@@ -30,6 +30,7 @@
 #pragma interface
 #endif
 
+#include <vector>
 #include "Lexer.h"
 
 //------------------------------------------------------------------------
@@ -73,6 +74,9 @@ private:
   GBool allowStreams;		// parse stream objects?
   Object buf1, buf2;		// next two tokens
   int inlineImg;		// set when inline image data is encountered
+  std::vector<Object> elems;	// elements of the arrays and dicts being
+				//   parsed, so that they're made full size
+  std::vector<char *> keys;	// keys of the dicts being parsed
 
   Stream *makeStream(Object &&dict, Guchar *fileKey,
 		     CryptAlgorithm encAlgorithm, int keyLength,
@@ -14,6 +14,8 @@
 
 #include "XRef.h"
 
+#include <iterator>
+
 PopplerCacheKey::~PopplerCacheKey()
 {
 }
@@ -22,66 +24,131 @@ PopplerCacheItem::~PopplerCacheItem()
 {
 }
 
-PopplerCache::PopplerCache(int cacheSizeA)
+namespace {
+
+class PopplerCacheLocker {
+  public:
+    PopplerCacheLocker(PopplerCache *cacheA) : cache(cacheA) { cache->lock(); }
+    ~PopplerCacheLocker() { cache->unlock(); }
+
+    PopplerCacheLocker(const PopplerCacheLocker &) = delete;
+    PopplerCacheLocker& operator=(const PopplerCacheLocker &other) = delete;
+
+  private:
+    PopplerCache *cache;
+};
+
+}
+
+PopplerCache::PopplerCache(int cacheSizeA, size_t maxCostA, bool threadSafeA)
 {
   cacheSize = cacheSizeA;
-  keys = new PopplerCacheKey*[cacheSize];
-  items = new PopplerCacheItem*[cacheSize];
-  lastValidCacheIndex = -1;
+  maxCostValue = maxCostA;
+  totalCostValue = 0;
+  hits = 0;
+  misses = 0;
+  threadSafe = threadSafeA;
+  index.reserve(cacheSize);
+#ifdef MULTITHREADED
+  gInitMutex(&mutex);
+#endif
 }
 
 PopplerCache::~PopplerCache()
 {
-  for (int i = 0; i <= lastValidCacheIndex; ++i) {
-    delete keys[i];
-    delete items[i];
+  clear();
+#ifdef MULTITHREADED
+  gDestroyMutex(&mutex);
+#endif
+}
+
+void PopplerCache::lock()
+{
+#ifdef MULTITHREADED
+  if (threadSafe) {
+    gLockMutex(&mutex);
   }
-  delete[] keys;
-  delete[] items;
+#endif
+}
+
+void PopplerCache::unlock()
+{
+#ifdef MULTITHREADED
+  if (threadSafe) {
+    gUnlockMutex(&mutex);
+  }
+#endif
 }
 
 PopplerCacheItem *PopplerCache::lookup(const PopplerCacheKey &key)
 {
-  if (lastValidCacheIndex < 0)
+  PopplerCacheLocker locker(this);
+
+  auto hit = index.find(&key);
+  if (hit == index.end()) {
+    ++misses;
     return nullptr;
+  }
 
-  if (*keys[0] == key) {
-    return items[0];
+  ++hits;
+  if (hit->second != entries.begin()) {
+    entries.splice(entries.begin(), entries, hit->second);
   }
-  for (int i = 1; i <= lastValidCacheIndex; i++) {
-    if (*keys[i] == key) {
-      PopplerCacheKey *keyHit = keys[i];
-      PopplerCacheItem *itemHit = items[i];
-
-      for (int j = i; j > 0; j--) {
-        keys[j] = keys[j - 1];
-        items[j] = items[j - 1];
-      }
-      
-      keys[0] = keyHit;
-      items[0] = itemHit;
-      return itemHit;
-    }
+  return hit->second->item;
+}
+
+void PopplerCache::evict(EntryList::iterator it)
+{
+  index.erase(it->key);
+  totalCostValue -= it->cost;
+  delete it->key;
+  delete it->item;
+  entries.erase(it);
+}
+
+void PopplerCache::put(PopplerCacheKey *key, PopplerCacheItem *item, size_t cost)
+{
+  PopplerCacheLocker locker(this);
+
+  auto old = index.find(key);
+  if (old != index.end()) {
+    evict(old->second);
+  }
+
+  entries.push_front(Entry{key, item, cost});
+  index.emplace(key, entries.begin());
+  totalCostValue += cost;
+
+  while (entries.size() > 1 &&
+	 ((int)entries.size() > cacheSize ||
+	  (maxCostValue > 0 && totalCostValue > maxCostValue))) {
+    evict(std::prev(entries.end()));
   }
-  return nullptr;
 }
 
-void PopplerCache::put(PopplerCacheKey *key, PopplerCacheItem *item)
+bool PopplerCache::remove(const PopplerCacheKey &key)
 {
-  int movingStartIndex = lastValidCacheIndex + 1;
-  if (lastValidCacheIndex == cacheSize - 1) {
-    delete keys[lastValidCacheIndex];
-    delete items[lastValidCacheIndex];
-    movingStartIndex = cacheSize - 1;
-  } else {
-    lastValidCacheIndex++;
+  PopplerCacheLocker locker(this);
+
+  auto it = index.find(&key);
+  if (it == index.end()) {
+    return false;
   }
-  for (int i = movingStartIndex; i > 0; i--) {
-    keys[i] = keys[i - 1];
-    items[i] = items[i - 1];
+  evict(it->second);
+  return true;
+}
+
+void PopplerCache::clear()
+{
+  PopplerCacheLocker locker(this);
+
+  for (Entry &entry : entries) {
+    delete entry.key;
+    delete entry.item;
   }
-  keys[0] = key;
-  items[0] = item;
+  entries.clear();
+  index.clear();
+  totalCostValue = 0;
 }
 
 int PopplerCache::size()
@@ -91,17 +158,47 @@ int PopplerCache::size()
 
 int PopplerCache::numberOfItems()
 {
-  return lastValidCacheIndex + 1;
+  PopplerCacheLocker locker(this);
+  return entries.size();
+}
+
+size_t PopplerCache::maxCost()
+{
+  return maxCostValue;
+}
+
+size_t PopplerCache::totalCost()
+{
+  PopplerCacheLocker locker(this);
+  return totalCostValue;
+}
+
+unsigned long PopplerCache::numberOfHits()
+{
+  PopplerCacheLocker locker(this);
+  return hits;
+}
+
+unsigned long PopplerCache::numberOfMisses()
+{
+  PopplerCacheLocker locker(this);
+  return misses;
 }
     
-PopplerCacheItem *PopplerCache::item(int index)
+PopplerCacheItem *PopplerCache::item(int i)
 {
-  return items[index];
+  PopplerCacheLocker locker(this);
+  auto it = entries.begin();
+  std::advance(it, i);
+  return it->item;
 }
     
-PopplerCacheKey *PopplerCache::key(int index)
+PopplerCacheKey *PopplerCache::key(int i)
 {
-  return keys[index];
+  PopplerCacheLocker locker(this);
+  auto it = entries.begin();
+  std::advance(it, i);
+  return it->key;
 }
 
 class ObjectKey : public PopplerCacheKey {
@@ -116,6 +213,11 @@ class ObjectKey : public PopplerCacheKey {
       return k->num == num && k->gen == gen;
     }
 
+    size_t hash() const override
+    {
+      return ((size_t)num << 8) ^ gen;
+    }
+
     int num, gen;
 };
 
@@ -13,7 +13,12 @@
 #ifndef POPPLER_CACHE_H
 #define POPPLER_CACHE_H
 
+#include <stddef.h>
+#include <list>
+#include <unordered_map>
+
 #include "Object.h"
+#include "goo/GooMutex.h"
 
 class PopplerCacheItem
 {
@@ -31,6 +36,8 @@ class PopplerCacheKey
     PopplerCacheKey() = default;
     virtual ~PopplerCacheKey();
     virtual bool operator==(const PopplerCacheKey &key) const = 0;
+    // Keys that compare equal must have the same hash
+    virtual size_t hash() const = 0;
 
     PopplerCacheKey(const PopplerCacheKey &) = delete;
     PopplerCacheKey& operator=(const PopplerCacheKey &other) = delete;
@@ -39,7 +46,10 @@ class PopplerCacheKey
 class PopplerCache
 {
   public:
-    PopplerCache(int cacheSizeA);
+    /* Keeps at most cacheSizeA items and, if maxCostA is not 0, at most
+       maxCostA worth of item costs (e.g. bytes). With threadSafeA every
+       call is serialized, see lock() */
+    PopplerCache(int cacheSizeA, size_t maxCostA = 0, bool threadSafeA = false);
     ~PopplerCache();
     
     PopplerCache(const PopplerCache &) = delete;
@@ -48,26 +58,76 @@ class PopplerCache
     /* The item returned is owned by the cache */
     PopplerCacheItem *lookup(const PopplerCacheKey &key);
     
-    /* The key and item pointers ownership is taken by the cache */
-    void put(PopplerCacheKey *key, PopplerCacheItem *item);
+    /* The key and item pointers ownership is taken by the cache.
+       An item already cached under an equal key is replaced. Least
+       recently used items are evicted to make room, but the item just
+       put is always kept */
+    void put(PopplerCacheKey *key, PopplerCacheItem *item, size_t cost = 0);
+
+    /* Deletes the item cached under key, returns whether there was one */
+    bool remove(const PopplerCacheKey &key);
+
+    /* Deletes all the items */
+    void clear();
     
     /* The max size of the cache */
     int size();
     
     /* The number of items in the cache */
     int numberOfItems();
+
+    /* The max cost of the cache, 0 if unbounded */
+    size_t maxCost();
+
+    /* The sum of the costs of the items in the cache */
+    size_t totalCost();
+
+    /* The number of lookups that found / didn't find an item */
+    unsigned long numberOfHits();
+    unsigned long numberOfMisses();
     
-    /* The n-th item in the cache */
+    /* The n-th item in the cache, most recently used first */
     PopplerCacheItem *item(int index);
     
-    /* The n-th key in the cache */
+    /* The n-th key in the cache, most recently used first */
     PopplerCacheKey *key(int index);
+
+    /* On a thread safe cache another thread can evict the item returned
+       by lookup() at any time, hold the lock while using it. The lock is
+       recursive and does nothing if the cache isn't thread safe */
+    void lock();
+    void unlock();
   
   private:
-    PopplerCacheKey **keys;
-    PopplerCacheItem **items;
-    int lastValidCacheIndex;
+    struct Entry {
+      PopplerCacheKey *key;
+      PopplerCacheItem *item;
+      size_t cost;
+    };
+
+    struct KeyHash {
+      size_t operator()(const PopplerCacheKey *key) const { return key->hash(); }
+    };
+
+    struct KeyEqual {
+      bool operator()(const PopplerCacheKey *a, const PopplerCacheKey *b) const { return *a == *b; }
+    };
+
+    typedef std::list<Entry> EntryList;
+
+    void evict(EntryList::iterator it);
+
+    EntryList entries;		// most recently used first
+    std::unordered_map<const PopplerCacheKey *, EntryList::iterator, KeyHash, KeyEqual> index;
     int cacheSize;
+    size_t maxCostValue;
+    size_t totalCostValue;
+    unsigned long hits;
+    unsigned long misses;
+    bool threadSafe;
+#ifdef MULTITHREADED
+    GooMutex mutex;
+#endif
 };
 
 class PopplerObjectCache
@@ -61,6 +61,7 @@
 #include "GfxFont.h"
 #include "Page.h"
 #include "PDFDoc.h"
+#include "DecodedImageCache.h"
 #include "Link.h"
 #include "FontEncodingTables.h"
 #include "fofi/FoFiTrueType.h"
@@ -69,6 +70,7 @@
 #include "splash/SplashPattern.h"
 #include "splash/SplashScreen.h"
 #include "splash/SplashPath.h"
+#include "splash/SplashClip.h"
 #include "splash/SplashState.h"
 #include "splash/SplashErrorCodes.h"
 #include "splash/SplashFontEngine.h"
@@ -78,6 +80,8 @@
 #include "splash/Splash.h"
 #include "SplashOutputDev.h"
 #include <algorithm>
+#include <thread>
+#include <vector>
 
 #ifdef VMS
 #if (__VMS_VER < 70000000)
@@ -87,6 +91,25 @@ extern "C" int unlink(char *filename);
 
 static const double s_minLineWidth = 0.0;
 
+// displayPageBands() bands start on multiples of this many rows, the
+// biggest halftone screen size, so that dithering lines up across them
+#define splashOutBandRowAlign 64
+
+// Shadings are drawn from tables of device colors when the fill is big
+// enough for them to pay off: univariate shadings get between
+// splashOutShadingLUTMin and splashOutShadingLUTMax entries, about one
+// per device pixel along the shading, and function shadings a grid
+// sample every splashOutShadingGridStep device pixels, up to
+// splashOutShadingGridMax samples a side.  The interpolated colors are
+// checked against the exact ones in the middle of each interval, cell
+// and cell edge; intervals and cells more than splashOutShadingMaxError
+// levels off there are computed exactly.
+#define splashOutShadingLUTMin 256
+#define splashOutShadingLUTMax 4096
+#define splashOutShadingGridStep 4
+#define splashOutShadingGridMax 256
+#define splashOutShadingMaxError 1
+
 static inline void convertGfxColor(SplashColorPtr dest,
                                    SplashColorMode colorMode,
                                    GfxColorSpace *colorSpace,
@@ -263,17 +286,154 @@ SplashFunctionPattern::SplashFunctionPattern(SplashColorMode colorModeA, GfxStat
   shadingA->getColorSpace()->getDefaultColor(&srcColor);
   shadingA->getDomain(&xMin, &yMin, &xMax, &yMax);
   convertGfxColor(defaultColor, colorModeA, shadingA->getColorSpace(), &srcColor);
+  nComps = splashColorModeNComps[colorMode];
+
+  // size a grid for the part of the domain inside the clip bbox
+  gridW = gridH = 0;
+  grid = gridExact = nullptr;
+  double dxMin, dyMin, dxMax, dyMax, x[4], y[4];
+  state->getClipBBox(&dxMin, &dyMin, &dxMax, &dyMax);
+  ictm.transform(dxMin, dyMin, &x[0], &y[0]);
+  ictm.transform(dxMax, dyMin, &x[1], &y[1]);
+  ictm.transform(dxMin, dyMax, &x[2], &y[2]);
+  ictm.transform(dxMax, dyMax, &x[3], &y[3]);
+  double gx0 = x[0], gy0 = y[0], gx1 = x[0], gy1 = y[0];
+  for (int i = 1; i < 4; ++i) {
+    gx0 = std::min<double>(gx0, x[i]);
+    gy0 = std::min<double>(gy0, y[i]);
+    gx1 = std::max<double>(gx1, x[i]);
+    gy1 = std::max<double>(gy1, y[i]);
+  }
+  gx0 = std::max<double>(gx0, xMin);
+  gy0 = std::max<double>(gy0, yMin);
+  gx1 = std::min<double>(gx1, xMax);
+  gy1 = std::min<double>(gy1, yMax);
+  if (gx0 < gx1 && gy0 < gy1) {
+    double w = (gx1 - gx0) * sqrt(ctm.m[0] * ctm.m[0] + ctm.m[1] * ctm.m[1]);
+    double h = (gy1 - gy0) * sqrt(ctm.m[2] * ctm.m[2] + ctm.m[3] * ctm.m[3]);
+    int nx = (int)std::min<double>(ceil(w / splashOutShadingGridStep),
+				   splashOutShadingGridMax - 1) + 1;
+    int ny = (int)std::min<double>(ceil(h / splashOutShadingGridStep),
+				   splashOutShadingGridMax - 1) + 1;
+    // building the grid takes four shading evaluations per sample
+    if (nx >= 2 && ny >= 2 &&
+	8.0 * nx * ny <= (dxMax - dxMin) * (dyMax - dyMin)) {
+      gridW = nx;
+      gridH = ny;
+      gridX0 = gx0;
+      gridY0 = gy0;
+      gridSX = (gridW - 1) / (gx1 - gx0);
+      gridSY = (gridH - 1) / (gy1 - gy0);
+    }
+  }
 }
 
 SplashFunctionPattern::~SplashFunctionPattern() {
+  gfree(grid);
+  gfree(gridExact);
+}
+
+// Interpolates the color at <u>, <v> in grid coordinates.
+void SplashFunctionPattern::interpolateGrid(double u, double v,
+					    SplashColorPtr c) {
+  Guchar *p, *q;
+  int i, j, k, fx, fy;
+
+  i = std::min<int>((int)u, gridW - 2);
+  j = std::min<int>((int)v, gridH - 2);
+  fx = (int)((u - i) * 256);
+  fy = (int)((v - j) * 256);
+  p = grid + (j * gridW + i) * nComps;
+  q = p + gridW * nComps;
+  for (k = 0; k < nComps; ++k) {
+    c[k] = (Guchar)(((p[k] * (256 - fx) + p[k + nComps] * fx) * (256 - fy) +
+		     (q[k] * (256 - fx) + q[k + nComps] * fx) * fy +
+		     0x8000) >> 16);
+  }
+}
+
+// Returns true if the interpolated color at <u>, <v> in grid
+// coordinates is too far from the exact one.
+GBool SplashFunctionPattern::isGridError(double u, double v) {
+  GfxColor gfxColor;
+  SplashColor color, interp;
+  int k;
+
+  shading->getColor(gridX0 + u / gridSX, gridY0 + v / gridSY, &gfxColor);
+  convertGfxColor(color, colorMode, shading->getColorSpace(), &gfxColor);
+  interpolateGrid(u, v, interp);
+  for (k = 0; k < nComps; ++k) {
+    if (abs(interp[k] - color[k]) > splashOutShadingMaxError) {
+      return gTrue;
+    }
+  }
+  return gFalse;
+}
+
+void SplashFunctionPattern::buildGrid() {
+  GfxColor gfxColor;
+  SplashColor color;
+  Guchar *hErr, *vErr;
+  int i, j;
+
+  grid = (Guchar *)gmallocn3(gridH, gridW, nComps);
+  for (j = 0; j < gridH; ++j) {
+    for (i = 0; i < gridW; ++i) {
+      shading->getColor(gridX0 + i / gridSX, gridY0 + j / gridSY, &gfxColor);
+      convertGfxColor(color, colorMode, shading->getColorSpace(), &gfxColor);
+      memcpy(grid + (j * gridW + i) * nComps, color, nComps);
+    }
+  }
+
+  // the interpolation is least accurate in the middle of the cells and
+  // of their edges, which are shared with the neighbouring cells
+  hErr = (Guchar *)gmallocn(gridH, gridW - 1);
+  for (j = 0; j < gridH; ++j) {
+    for (i = 0; i < gridW - 1; ++i) {
+      hErr[j * (gridW - 1) + i] = isGridError(i + 0.5, j);
+    }
+  }
+  vErr = (Guchar *)gmallocn(gridH - 1, gridW);
+  for (j = 0; j < gridH - 1; ++j) {
+    for (i = 0; i < gridW; ++i) {
+      vErr[j * gridW + i] = isGridError(i, j + 0.5);
+    }
+  }
+  gridExact = (Guchar *)gmallocn(gridH - 1, gridW - 1);
+  for (j = 0; j < gridH - 1; ++j) {
+    for (i = 0; i < gridW - 1; ++i) {
+      gridExact[j * (gridW - 1) + i] =
+	  hErr[j * (gridW - 1) + i] || hErr[(j + 1) * (gridW - 1) + i] ||
+	  vErr[j * gridW + i] || vErr[j * gridW + i + 1] ||
+	  isGridError(i + 0.5, j + 0.5);
+    }
+  }
+  gfree(hErr);
+  gfree(vErr);
 }
 
 GBool SplashFunctionPattern::getColor(int x, int y, SplashColorPtr c) {
   GfxColor gfxColor;
-  double xc, yc;
+  double xc, yc, u, v;
+  int i, j;
 
   ictm.transform(x, y, &xc, &yc);
   if (xc < xMin || xc > xMax || yc < yMin || yc > yMax) return gFalse;
+  if (gridW > 0) {
+    if (!grid) {
+      buildGrid();
+    }
+    u = (xc - gridX0) * gridSX;
+    v = (yc - gridY0) * gridSY;
+    if (u >= 0 && u <= gridW - 1 && v >= 0 && v <= gridH - 1) {
+      i = std::min<int>((int)u, gridW - 2);
+      j = std::min<int>((int)v, gridH - 2);
+      if (!gridExact[j * (gridW - 1) + i]) {
+	interpolateGrid(u, v, c);
+	return gTrue;
+      }
+    }
+  }
   shading->getColor(xc, yc, &gfxColor);
   convertGfxColor(c, colorMode, shading->getColorSpace(), &gfxColor);
   return gTrue;
@@ -302,19 +462,106 @@ SplashUnivariatePattern::SplashUnivariatePattern(SplashColorMode colorModeA, Gfx
   stateA->getUserClipBBox(&xMin, &yMin, &xMax, &yMax);
   shadingA->setupCache(&ctm, xMin, yMin, xMax, yMax);
   gfxMode = shadingA->getColorSpace()->getMode();
+  nComps = splashColorModeNComps[colorMode];
+
+  // size a color table for the visible t range, with about one entry
+  // per device pixel along the shading
+  double sMin, sMax, dxMin, dyMin, dxMax, dyMax;
+  shadingA->getParameterRange(&sMin, &sMax, xMin, yMin, xMax, yMax);
+  // the extended parts of the shading are clamped to t0 and t1
+  sMin = std::min<double>(std::max<double>(sMin, 0), 1);
+  sMax = std::min<double>(std::max<double>(sMax, 0), 1);
+  lutTMin = t0 + std::min<double>(sMin * dt, sMax * dt);
+  lutTMax = t0 + std::max<double>(sMin * dt, sMax * dt);
+  lutSize = 0;
+  lut = lutExact = nullptr;
+  if (lutTMin < lutTMax) {
+    double n = ceil(ctm.norm() * shadingA->getDistance(sMin, sMax)) + 1;
+    n = std::max<double>(n, splashOutShadingLUTMin);
+    n = std::min<double>(n, splashOutShadingLUTMax);
+    // building the table takes two shading evaluations per entry
+    state->getClipBBox(&dxMin, &dyMin, &dxMax, &dyMax);
+    if (4 * n <= (dxMax - dxMin) * (dyMax - dyMin)) {
+      lutSize = (int)n;
+    }
+  }
 }
 
 SplashUnivariatePattern::~SplashUnivariatePattern() {
+  gfree(lut);
+  gfree(lutExact);
+}
+
+void SplashUnivariatePattern::buildLUT() {
+  GfxColor gfxColor;
+  SplashColor color;
+  Guchar *p;
+  int nExact, i, k;
+
+  lutExact = nullptr;
+  while (1) {
+    lutScale = (lutSize - 1) / (lutTMax - lutTMin);
+    lut = (Guchar *)greallocn(lut, lutSize, nComps);
+    for (i = 0; i < lutSize; ++i) {
+      shading->getColor(i == lutSize - 1 ? lutTMax : lutTMin + i / lutScale,
+			&gfxColor);
+      convertGfxColor(color, colorMode, shading->getColorSpace(), &gfxColor);
+      memcpy(lut + i * nComps, color, nComps);
+    }
+
+    // the middle of an interval is where the linear interpolation is
+    // least accurate
+    lutExact = (Guchar *)grealloc(lutExact, lutSize - 1);
+    nExact = 0;
+    for (i = 0; i < lutSize - 1; ++i) {
+      shading->getColor(lutTMin + (i + 0.5) / lutScale, &gfxColor);
+      convertGfxColor(color, colorMode, shading->getColorSpace(), &gfxColor);
+      p = lut + i * nComps;
+      lutExact[i] = gFalse;
+      for (k = 0; k < nComps; ++k) {
+	if (abs(((p[k] + p[k + nComps] + 1) >> 1) - color[k]) >
+	    splashOutShadingMaxError) {
+	  lutExact[i] = gTrue;
+	  ++nExact;
+	  break;
+	}
+      }
+    }
+
+    // a few bad intervals are discontinuities, which a finer table
+    // wouldn't fix; many of them mean it is too coarse
+    if (nExact * 16 <= lutSize - 1 || lutSize * 2 - 1 > splashOutShadingLUTMax) {
+      break;
+    }
+    lutSize = lutSize * 2 - 1;
+  }
 }
 
 GBool SplashUnivariatePattern::getColor(int x, int y, SplashColorPtr c) {
   GfxColor gfxColor;
-  double xc, yc, t;
+  double xc, yc, t, u;
+  Guchar *p;
+  int i, k, f;
 
   ictm.transform(x, y, &xc, &yc);
   if (! getParameter (xc, yc, &t))
       return gFalse;
 
+  if (lutSize > 0 && t >= lutTMin && t <= lutTMax) {
+    if (!lut) {
+      buildLUT();
+    }
+    u = (t - lutTMin) * lutScale;
+    i = std::min<int>((int)u, lutSize - 2);
+    if (!lutExact[i]) {
+      f = (int)((u - i) * 256);
+      p = lut + i * nComps;
+      for (k = 0; k < nComps; ++k) {
+	c[k] = (Guchar)((p[k] * (256 - f) + p[k + nComps] * f + 0x80) >> 8);
+      }
+      return gTrue;
+    }
+  }
   shading->getColor(t, &gfxColor);
   convertGfxColor(c, colorMode, shading->getColorSpace(), &gfxColor);
   return gTrue;
@@ -1369,6 +1616,7 @@ SplashOutputDev::SplashOutputDev(SplashColorMode colorModeA,
   bitmapUpsideDown = gFalse;
   fontAntialias = gTrue;
   vectorAntialias = gTrue;
+  aaQuality = splashAAQualityNormal;
   overprintPreview = overprintPreviewA;
   enableFreeTypeHinting = gFalse;
   enableSlightHinting = gFalse;
@@ -1390,6 +1638,7 @@ SplashOutputDev::SplashOutputDev(SplashColorMode colorModeA,
   splash = new Splash(bitmap, vectorAntialias, &screenParams);
   splash->setMinLineWidth(s_minLineWidth);
   splash->setThinLineMode(thinLineMode);
+  splash->setAAQuality(aaQuality);
   splash->clear(paperColor, 0);
 
   fontEngine = nullptr;
@@ -1403,6 +1652,12 @@ SplashOutputDev::SplashOutputDev(SplashColorMode colorModeA,
   transpGroupStack = nullptr;
   nestCount = 0;
   xref = nullptr;
+
+  bandDevs = nullptr;
+  nBandDevs = 0;
+  bandY = 0;
+  bandHeight = 0;
+  pageBitmap = nullptr;
 }
 
 void SplashOutputDev::setupScreenParams(double hDPI, double vDPI) {
@@ -1445,12 +1700,22 @@ SplashOutputDev::~SplashOutputDev() {
   if (bitmap) {
     delete bitmap;
   }
+  for (i = 0; i < nBandDevs; ++i) {
+    delete bandDevs[i];
+  }
+  gfree(bandDevs);
 }
 
 void SplashOutputDev::startDoc(PDFDoc *docA) {
   int i;
 
   doc = docA;
+  // the band devices are set up for the new document, and with the
+  // current settings, when displayPageBands() needs them
+  for (i = 0; i < nBandDevs; ++i) {
+    delete bandDevs[i];
+  }
+  nBandDevs = 0;
   if (fontEngine) {
     delete fontEngine;
   }
@@ -1466,6 +1731,153 @@ void SplashOutputDev::startDoc(PDFDoc *docA) {
   nT3Fonts = 0;
 }
 
+void SplashOutputDev::displayPageBands(int pg, double hDPI, double vDPI,
+				       int rotate, GBool useMediaBox,
+				       GBool crop, GBool printing,
+				       int nBands) {
+  Page *page;
+  SplashOutputDev *dev;
+  SplashThinLineMode thinLineMode;
+  std::vector<std::thread> threads;
+  int pageRotate, w, h, bandH, i;
+
+  if (!doc || !(page = doc->getPage(pg))) {
+    return;
+  }
+
+  // the size of the page in pixels, as startPage() gets it from Gfx
+  pageRotate = rotate + page->getRotate();
+  if (pageRotate >= 360) {
+    pageRotate -= 360;
+  } else if (pageRotate < 0) {
+    pageRotate += 360;
+  }
+  GfxState state(hDPI, vDPI,
+		 useMediaBox ? page->getMediaBox() : page->getCropBox(),
+		 pageRotate, upsideDown());
+  w = (int)(state.getPageWidth() + 0.5);
+  if (w <= 0) {
+    w = 1;
+  }
+  h = (int)(state.getPageHeight() + 0.5);
+  if (h <= 0) {
+    h = 1;
+  }
+
+  if (nBands <= 0) {
+    nBands = (int)std::thread::hardware_concurrency();
+  }
+#ifdef SPLASH_CMYK
+  // the separations of the page are collected in its bitmap as it is
+  // drawn
+  if (colorMode == splashModeDeviceN8) {
+    nBands = 1;
+  }
+#endif
+  if (nBands <= 0) {
+    nBands = 1;
+  }
+  bandH = (h + nBands - 1) / nBands;
+  bandH = (bandH + splashOutBandRowAlign - 1) / splashOutBandRowAlign
+          * splashOutBandRowAlign;
+  nBands = (h + bandH - 1) / bandH;
+  if (nBands <= 1) {
+    doc->displayPage(this, pg, hDPI, vDPI, rotate, useMediaBox, crop,
+		     printing);
+    return;
+  }
+
+  // set up and clear the page's bitmap, as startPage() does
+  thinLineMode = splash->getThinLineMode();
+  setupScreenParams(hDPI, vDPI);
+  delete splash;
+  splash = nullptr;
+  if (!bitmap || w != bitmap->getWidth() || h != bitmap->getHeight()) {
+    delete bitmap;
+    bitmap = new SplashBitmap(w, h, bitmapRowPad, colorMode,
+			      colorMode != splashModeMono1, bitmapTopDown);
+    if (!bitmap->getDataPtr()) {
+      delete bitmap;
+      bitmap = new SplashBitmap(1, 1, bitmapRowPad, colorMode,
+				colorMode != splashModeMono1, bitmapTopDown);
+    }
+  }
+  splash = new Splash(bitmap, vectorAntialias, &screenParams);
+  splash->setThinLineMode(thinLineMode);
+  splash->setAAQuality(aaQuality);
+  splash->setMinLineWidth(s_minLineWidth);
+  if (bitmap->getWidth() != w || bitmap->getHeight() != h) {
+    return;
+  }
+  splash->clear(paperColor, 0);
+
+  if (nBandDevs < nBands) {
+    bandDevs = (SplashOutputDev **)greallocn(bandDevs, nBands,
+					     sizeof(SplashOutputDev *));
+    for (i = nBandDevs; i < nBands; ++i) {
+      bandDevs[i] = new SplashOutputDev(colorMode, bitmapRowPad, reverseVideo,
+					keepAlphaChannel ? nullptr : paperColor,
+					bitmapTopDown, thinLineMode,
+					overprintPreview);
+      bandDevs[i]->setFontAntialias(fontAntialias);
+      bandDevs[i]->setFreeTypeHinting(enableFreeTypeHinting,
+				      enableSlightHinting);
+      bandDevs[i]->startDoc(doc);
+    }
+    nBandDevs = nBands;
+  }
+  for (i = 0; i < nBands; ++i) {
+    dev = bandDevs[i];
+    // the font engine is built from these by startDoc()
+    if (dev->fontAntialias != fontAntialias ||
+	dev->enableFreeTypeHinting != enableFreeTypeHinting ||
+	dev->enableSlightHinting != enableSlightHinting) {
+      dev->setFontAntialias(fontAntialias);
+      dev->setFreeTypeHinting(enableFreeTypeHinting, enableSlightHinting);
+      dev->startDoc(doc);
+    }
+    dev->vectorAntialias = vectorAntialias;
+    dev->setReverseVideo(reverseVideo);
+    if (!keepAlphaChannel) {
+      dev->setPaperColor(paperColor);
+    }
+    dev->setSkipText(skipHorizText, skipRotatedText);
+    dev->setBitmapUpsideDown(bitmapUpsideDown);
+    dev->splash->setThinLineMode(thinLineMode);
+    dev->setAAQuality(aaQuality);
+    if (dev->bitmap != bitmap) {
+      delete dev->bitmap;
+    }
+    dev->bitmap = dev->pageBitmap = bitmap;
+    dev->bandY = i * bandH;
+    dev->bandHeight = std::min(bandH, h - i * bandH);
+  }
+
+  // the calling thread draws the first band; all of them run the same
+  // display list, and draw in this device's bitmap, each clipped to its
+  // rows
+  for (i = 1; i < nBands; ++i) {
+    threads.push_back(std::thread([=]() {
+      doc->displayPage(bandDevs[i], pg, hDPI, vDPI, rotate, useMediaBox,
+		       crop, printing);
+    }));
+  }
+  doc->displayPage(bandDevs[0], pg, hDPI, vDPI, rotate, useMediaBox,
+		   crop, printing);
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  // the bitmap is this device's; the band devices' splash is replaced
+  // by startPage() before they draw again
+  for (i = 0; i < nBands; ++i) {
+    bandDevs[i]->bitmap = bandDevs[i]->pageBitmap = nullptr;
+  }
+  if (colorMode != splashModeMono1 && !keepAlphaChannel) {
+    splash->compositeBackground(paperColor);
+  }
+}
+
 void SplashOutputDev::startPage(int pageNum, GfxState *state, XRef *xrefA) {
   int w, h;
   double *ctm;
@@ -1492,7 +1904,12 @@ void SplashOutputDev::startPage(int pageNum, GfxState *state, XRef *xrefA) {
     delete splash;
     splash = nullptr;
   }
-  if (!bitmap || w != bitmap->getWidth() || h != bitmap->getHeight()) {
+  if (bandHeight > 0) {
+    // band devices draw in the page's bitmap, which displayPageBands()
+    // has set up and cleared, at the same coordinates as on the whole
+    // page: only the clip keeps them to their rows
+    bitmap = pageBitmap;
+  } else if (!bitmap || w != bitmap->getWidth() || h != bitmap->getHeight()) {
     if (bitmap) {
       delete bitmap;
       bitmap = nullptr;
@@ -1508,6 +1925,7 @@ void SplashOutputDev::startPage(int pageNum, GfxState *state, XRef *xrefA) {
   }
   splash = new Splash(bitmap, vectorAntialias, &screenParams);
   splash->setThinLineMode(thinLineMode);
+  splash->setAAQuality(aaQuality);
   splash->setMinLineWidth(s_minLineWidth);
   if (state) {
     ctm = state->getCTM();
@@ -1551,11 +1969,17 @@ void SplashOutputDev::startPage(int pageNum, GfxState *state, XRef *xrefA) {
   // the SA parameter supposedly defaults to false, but Acrobat
   // apparently hardwires it to true
   splash->setStrokeAdjust(gTrue);
-  splash->clear(paperColor, 0);
+  if (bandHeight > 0) {
+    splash->clipToRect(0, bandY, w, bandY + bandHeight);
+  } else {
+    splash->clear(paperColor, 0);
+  }
 }
 
 void SplashOutputDev::endPage() {
-  if (colorMode != splashModeMono1 && !keepAlphaChannel) {
+  // displayPageBands() composites the whole page once the bands are done
+  if (colorMode != splashModeMono1 && !keepAlphaChannel &&
+      bandHeight == 0) {
     splash->compositeBackground(paperColor);
   }
 }
@@ -2799,6 +3223,7 @@ void SplashOutputDev::type3D1(GfxState *state, double wx, double wy,
 			      splashModeMono8, gFalse);
     splash = new Splash(bitmap, vectorAntialias,
 			t3GlyphStack->origSplash->getScreen());
+    splash->setAAQuality(aaQuality);
     color[0] = 0x00;
     splash->clear(color);
     color[0] = 0xff;
@@ -3481,6 +3906,59 @@ GBool SplashOutputDev::tilingBitmapSrc(void *data, SplashColorPtr colorLine,
   return gTrue;
 }
 
+Stream *SplashOutputDev::getImageDataStream(Object *ref, Stream *str,
+					    int width, int height,
+					    GfxImageColorMap *colorMap) {
+  // band devices already run on all the CPUs
+  str->setMaxDecodeThreads(bandHeight > 0 ? 1 : 0);
+  if (!doc) {
+    return str;
+  }
+  return doc->getDecodedImageCache()->getImageStream(doc->getXRef(), ref, str,
+						     width, height,
+						     colorMap->getNumPixelComps(),
+						     colorMap->getBits());
+}
+
+// Sets the part of a <width> x <height> image drawn with <mat> that is
+// inside the clip of <state>, with a margin of a couple of device pixels
+// for the interpolation.  Returns false if that is the whole image.
+// Unlike the clip of the Splash, that of the state is the same whether
+// the page is drawn whole or in bands.
+static GBool getClippedImageArea(GfxState *state, SplashCoord *mat,
+				 int width, int height,
+				 int *x0, int *y0, int *x1, int *y1) {
+  SplashCoord det, dx, dy, u, v, uMin, uMax, vMin, vMax, marginX, marginY;
+  double clipXMin, clipYMin, clipXMax, clipYMax;
+  int i;
+
+  det = mat[0] * mat[3] - mat[1] * mat[2];
+  if (fabs(det) < 0.000001) {
+    return gFalse;
+  }
+  state->getClipBBox(&clipXMin, &clipYMin, &clipXMax, &clipYMax);
+  uMin = vMin = 1;
+  uMax = vMax = 0;
+  for (i = 0; i < 4; ++i) {
+    dx = ((i & 1) ? clipXMax : clipXMin) - mat[4];
+    dy = ((i & 2) ? clipYMax : clipYMin) - mat[5];
+    u = (dx * mat[3] - dy * mat[2]) / det;
+    v = (dy * mat[0] - dx * mat[1]) / det;
+    uMin = u < uMin ? u : uMin;
+    uMax = u > uMax ? u : uMax;
+    vMin = v < vMin ? v : vMin;
+    vMax = v > vMax ? v : vMax;
+  }
+  marginX = 2 / sqrt(mat[0] * mat[0] + mat[1] * mat[1]) + 1.0 / width;
+  marginY = 2 / sqrt(mat[2] * mat[2] + mat[3] * mat[3]) + 1.0 / height;
+  *x0 = uMin - marginX <= 0 ? 0 : (int)floor((uMin - marginX) * width);
+  *x1 = uMax + marginX >= 1 ? width : (int)ceil((uMax + marginX) * width);
+  *y0 = vMin - marginY <= 0 ? 0 : (int)floor((vMin - marginY) * height);
+  *y1 = vMax + marginY >= 1 ? height : (int)ceil((vMax + marginY) * height);
+  return *x0 < *x1 && *y0 < *y1 &&
+         (*x0 > 0 || *y0 > 0 || *x1 < width || *y1 < height);
+}
+
 void SplashOutputDev::drawImage(GfxState *state, Object *ref, Stream *str,
 				int width, int height,
 				GfxImageColorMap *colorMap,
@@ -3492,6 +3970,7 @@ void SplashOutputDev::drawImage(GfxState *state, Object *ref, Stream *str,
   SplashColorMode srcMode;
   SplashImageSource src;
   SplashICCTransform tf;
+  Stream *imgDataStr;
   GfxGray gray;
   GfxRGB rgb;
 #ifdef SPLASH_CMYK
@@ -3500,6 +3979,8 @@ void SplashOutputDev::drawImage(GfxState *state, Object *ref, Stream *str,
   GfxColor deviceN;
 #endif
   Guchar pix;
+  int drawnWidth, drawnHeight, areaX0, areaY0, areaX1, areaY1;
+  GBool clipped, hinted;
   int n, i;
 
   ctm = state->getCTM();
@@ -3513,10 +3994,42 @@ void SplashOutputDev::drawImage(GfxState *state, Object *ref, Stream *str,
   mat[4] = ctm[2] + ctm[4];
   mat[5] = ctm[3] + ctm[5];
 
-  imgData.imgStr = new ImageStream(str, width,
+  // images drawn much smaller than they are, e.g. in thumbnails, can be
+  // decoded at a reduced size by some filters, and images mostly outside
+  // the clip, e.g. in tiles, only in part; those aren't cached, as the
+  // cache has the full image and the image must look the same whether
+  // it was cached yet or not
+  drawnWidth = (int)ceil(sqrt(mat[0] * mat[0] + mat[1] * mat[1]));
+  drawnHeight = (int)ceil(sqrt(mat[2] * mat[2] + mat[3] * mat[3]));
+  clipped = getClippedImageArea(state, mat, width, height,
+				&areaX0, &areaY0, &areaX1, &areaY1);
+  hinted = !inlineImg && !maskColors && str->usesImageHints() &&
+           (clipped || ((width + 1) / 2 >= drawnWidth &&
+			(height + 1) / 2 >= drawnHeight));
+  imgDataStr = getImageDataStream(hinted ? nullptr : ref, str,
+				  width, height, colorMap);
+  if (hinted) {
+    str->setMinImageSize(drawnWidth, drawnHeight);
+    if (clipped) {
+      str->setImageArea(areaX0, areaY0, areaX1, areaY1);
+    }
+  }
+  imgDataStr->reset();
+  if (imgDataStr == str) {
+    // draw the part of the image that was decoded where it belongs
+    if (str->getImageArea(&areaX0, &areaY0, &areaX1, &areaY1)) {
+      mat[4] += (mat[0] * areaX0) / width + (mat[2] * areaY0) / height;
+      mat[5] += (mat[1] * areaX0) / width + (mat[3] * areaY0) / height;
+      mat[0] *= (SplashCoord)(areaX1 - areaX0) / width;
+      mat[1] *= (SplashCoord)(areaX1 - areaX0) / width;
+      mat[2] *= (SplashCoord)(areaY1 - areaY0) / height;
+      mat[3] *= (SplashCoord)(areaY1 - areaY0) / height;
+    }
+    str->getReducedImageSize(&width, &height);
+  }
+  imgData.imgStr = new ImageStream(imgDataStr, width,
 				   colorMap->getNumPixelComps(),
 				   colorMap->getBits());
-  imgData.imgStr->reset();
   imgData.colorMap = colorMap;
   imgData.maskColors = maskColors;
   imgData.colorMode = colorMode;
@@ -3629,6 +4142,9 @@ void SplashOutputDev::drawImage(GfxState *state, Object *ref, Stream *str,
 
   gfree(imgData.lookup);
   delete imgData.imgStr;
+  if (imgDataStr != str) {
+    delete imgDataStr;
+  }
   str->close();
 }
 
@@ -3764,6 +4280,7 @@ void SplashOutputDev::drawMaskedImage(GfxState *state, Object *ref,
   SplashCoord mat[6];
   SplashOutMaskedImageData imgData;
   SplashOutImageMaskData imgMaskData;
+  Stream *imgDataStr;
   SplashColorMode srcMode;
   SplashBitmap *maskBitmap;
   Splash *maskSplash;
@@ -3843,7 +4360,8 @@ void SplashOutputDev::drawMaskedImage(GfxState *state, Object *ref,
     mat[4] = ctm[2] + ctm[4];
     mat[5] = ctm[3] + ctm[5];
 
-    imgData.imgStr = new ImageStream(str, width,
+    imgDataStr = getImageDataStream(ref, str, width, height, colorMap);
+    imgData.imgStr = new ImageStream(imgDataStr, width,
 				     colorMap->getNumPixelComps(),
 				     colorMap->getBits());
     imgData.imgStr->reset();
@@ -3926,6 +4444,9 @@ void SplashOutputDev::drawMaskedImage(GfxState *state, Object *ref,
     delete maskBitmap;
     gfree(imgData.lookup);
     delete imgData.imgStr;
+    if (imgDataStr != str) {
+      delete imgDataStr;
+    }
     str->close();
   }
 }
@@ -3942,6 +4463,7 @@ void SplashOutputDev::drawSoftMaskedImage(GfxState *state, Object *ref,
   SplashCoord mat[6];
   SplashOutImageData imgData;
   SplashOutImageData imgMaskData;
+  Stream *imgDataStr;
   SplashColorMode srcMode;
   SplashBitmap *maskBitmap;
   Splash *maskSplash;
@@ -4017,7 +4539,8 @@ void SplashOutputDev::drawSoftMaskedImage(GfxState *state, Object *ref,
 
   //----- draw the source image
 
-  imgData.imgStr = new ImageStream(str, width,
+  imgDataStr = getImageDataStream(ref, str, width, height, colorMap);
+  imgData.imgStr = new ImageStream(imgDataStr, width,
 				   colorMap->getNumPixelComps(),
 				   colorMap->getBits());
   imgData.imgStr->reset();
@@ -4110,6 +4633,9 @@ void SplashOutputDev::drawSoftMaskedImage(GfxState *state, Object *ref,
   gfree(imgData.lookup);
   delete imgData.maskStr;
   delete imgData.imgStr;
+  if (imgDataStr != str) {
+    delete imgDataStr;
+  }
   if (maskColorMap->getMatteColor() != nullptr) {
     maskStr->close();
     delete maskStr;
@@ -4128,6 +4654,62 @@ GBool SplashOutputDev::checkTransparencyGroup(GfxState *state, GBool knockout) {
   return transpGroupStack != nullptr && transpGroupStack->shape != nullptr;
 }
 
+// Finds the rows of the bitmap of <group> that rows <bandY> to
+// <bandY> + <bandHeight> - 1 of <pageBitmap> fall on: [*y0, *y1).
+// Returns false if the group isn't drawn on the page, e.g. it is in a
+// Type 3 glyph.
+static GBool getGroupBandRows(SplashTransparencyGroup *group,
+			      SplashBitmap *pageBitmap,
+			      int bandY, int bandHeight, int *y0, int *y1) {
+  SplashTransparencyGroup *g;
+  int y;
+
+  y = 0;
+  for (g = group; g; g = g->next) {
+    y += g->ty;
+    if (g->origBitmap == pageBitmap) {
+      *y0 = bandY - y;
+      *y1 = *y0 + bandHeight;
+      return gTrue;
+    }
+    if (!g->next || g->origBitmap != g->next->tBitmap) {
+      break;
+    }
+  }
+  return gFalse;
+}
+
+// Copies rows <y0> to <y1> - 1 of <src> into a new bitmap of the same
+// size, the other rows being cleared.
+static SplashBitmap *copyBitmapRows(SplashBitmap *src, int y0, int y1) {
+  SplashBitmap *dest;
+  int rowBytes, y;
+
+  dest = new SplashBitmap(src->getWidth(), src->getHeight(),
+			  src->getRowPad(), src->getMode(),
+			  src->getAlphaPtr() != nullptr,
+			  src->getRowSize() >= 0, src->getSeparationList());
+  rowBytes = abs(src->getRowSize());
+  for (y = 0; y < src->getHeight(); ++y) {
+    if (y >= y0 && y < y1) {
+      memcpy(dest->getDataPtr() + y * dest->getRowSize(),
+	     src->getDataPtr() + y * src->getRowSize(), rowBytes);
+    } else {
+      memset(dest->getDataPtr() + y * dest->getRowSize(), 0, rowBytes);
+    }
+    if (src->getAlphaPtr()) {
+      if (y >= y0 && y < y1) {
+	memcpy(dest->getAlphaPtr() + y * src->getWidth(),
+	       src->getAlphaPtr() + y * src->getWidth(), src->getWidth());
+      } else {
+	memset(dest->getAlphaPtr() + y * src->getWidth(), 0,
+	       src->getWidth());
+      }
+    }
+  }
+  return dest;
+}
+
 void SplashOutputDev::beginTransparencyGroup(GfxState *state, double *bbox,
 					     GfxColorSpace *blendingColorSpace,
 					     GBool isolated, GBool knockout,
@@ -4135,7 +4717,8 @@ void SplashOutputDev::beginTransparencyGroup(GfxState *state, double *bbox,
   SplashTransparencyGroup *transpGroup;
   SplashColor color;
   double xMin, yMin, xMax, yMax, x, y;
-  int tx, ty, w, h, i;
+  int tx, ty, w, h, bandY0, bandY1, y0, y1, i;
+  GBool bandRows;
 
   // transform the bbox
   state->transform(bbox[0], bbox[1], &x, &y);
@@ -4208,7 +4791,6 @@ void SplashOutputDev::beginTransparencyGroup(GfxState *state, double *bbox,
   transpGroup->ty = ty;
   transpGroup->blendingColorSpace = blendingColorSpace;
   transpGroup->isolated = isolated;
-  transpGroup->shape = (knockout && !isolated) ? SplashBitmap::copy(bitmap) : nullptr;
   transpGroup->knockout = (knockout && isolated);
   transpGroup->knockoutOpacity = 1.0;
   transpGroup->next = transpGroupStack;
@@ -4219,6 +4801,19 @@ void SplashOutputDev::beginTransparencyGroup(GfxState *state, double *bbox,
   transpGroup->origSplash = splash;
   transpGroup->fontAA = fontEngine->getAA();
 
+  // a band device draws only its rows of the group, and mustn't read
+  // the other rows of the page, the other bands are drawing them
+  bandRows = bandHeight > 0 &&
+             getGroupBandRows(transpGroup, pageBitmap, bandY, bandHeight,
+			      &bandY0, &bandY1);
+  if (knockout && !isolated) {
+    transpGroup->shape = bandRows ? copyBitmapRows(bitmap, bandY0 + ty,
+						   bandY1 + ty)
+                                  : SplashBitmap::copy(bitmap);
+  } else {
+    transpGroup->shape = nullptr;
+  }
+
   //~ this handles the blendingColorSpace arg for soft masks, but
   //~   not yet for transparency groups
 
@@ -4258,6 +4853,7 @@ void SplashOutputDev::beginTransparencyGroup(GfxState *state, double *bbox,
     fontEngine->setAA(gFalse);
   }
   splash->setThinLineMode(transpGroup->origSplash->getThinLineMode());
+  splash->setAAQuality(aaQuality);
   splash->setMinLineWidth(s_minLineWidth);
   //~ Acrobat apparently copies at least the fill and stroke colors, and
   //~ maybe other state(?) -- but not the clipping path (and not sure
@@ -4279,9 +4875,25 @@ void SplashOutputDev::beginTransparencyGroup(GfxState *state, double *bbox,
       (transpGroup->next != nullptr && transpGroup->next->shape != nullptr) ? transpGroup->next->tx + tx : tx;
     int shapeTy = (knockout) ? ty :
       (transpGroup->next != nullptr && transpGroup->next->shape != nullptr) ? transpGroup->next->ty + ty : ty;
-    splash->blitTransparent(transpGroup->origBitmap, tx, ty, 0, 0, w, h);
+    if (bandRows) {
+      for (i = 0; i < splashMaxColorComps; ++i) {
+	color[i] = 0;
+      }
+      splash->clear(color, 0);
+      y0 = std::max(bandY0, 0);
+      y1 = std::min(bandY1, h);
+      if (y0 < y1) {
+	splash->blitTransparent(transpGroup->origBitmap, tx, ty + y0,
+				0, y0, w, y1 - y0);
+      }
+    } else {
+      splash->blitTransparent(transpGroup->origBitmap, tx, ty, 0, 0, w, h);
+    }
     splash->setInNonIsolatedGroup(shape, shapeTx, shapeTy);
   }
+  if (bandRows) {
+    splash->clipToRect(0, bandY0, w, bandY1);
+  }
   transpGroup->tBitmap = bitmap;
   state->shiftCTMAndClip(-tx, -ty);
   updateCTM(state, 0, 0, 0, 0, 0, 0);
@@ -4523,6 +5135,11 @@ void SplashOutputDev::setVectorAntialias(GBool vaa) {
 }
 #endif
 
+void SplashOutputDev::setAAQuality(SplashAAQuality aaQualityA) {
+  aaQuality = aaQualityA;
+  splash->setAAQuality(aaQuality);
+}
+
 void SplashOutputDev::setFreeTypeHinting(GBool enable, GBool enableSlightHintingA)
 {
   enableFreeTypeHinting = enable;
@@ -4672,6 +5289,7 @@ GBool SplashOutputDev::tilingPatternFill(GfxState *state, Gfx *gfxA, Catalog *ca
     splash->clear(paperColor, 0);
   }
   splash->setThinLineMode(formerSplash->getThinLineMode());
+  splash->setAAQuality(aaQuality);
   splash->setMinLineWidth(s_minLineWidth);
 
   box.x1 = bbox[0]; box.y1 = bbox[1];
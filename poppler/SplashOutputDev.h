@@ -79,12 +79,25 @@ public:
   GBool isCMYK() override { return gfxMode == csDeviceCMYK; }
 
 protected:
+  void buildGrid();
+  void interpolateGrid(double u, double v, SplashColorPtr c);
+  GBool isGridError(double u, double v);
+
   Matrix ictm;
   double xMin, yMin, xMax, yMax;
   GfxFunctionShading *shading;
   GfxState *state;
   SplashColorMode colorMode;
   GfxColorSpaceMode gfxMode;
+  int nComps;
+
+  // device colors sampled over the visible part of the domain, built
+  // by the first getColor() and interpolated bilinearly
+  int gridW, gridH;		// samples along x and y, 0 if no grid
+  double gridX0, gridY0;	// shading space coords of the first sample
+  double gridSX, gridSY;	// shading space to grid scale factors
+  Guchar *grid;			// gridW x gridH colors of nComps bytes
+  Guchar *gridExact;		// cells which can't be interpolated
 };
 
 class SplashUnivariatePattern: public SplashPattern {
@@ -107,12 +120,23 @@ public:
   GBool isCMYK() override { return gfxMode == csDeviceCMYK; }
 
 protected:
+  void buildLUT();
+
   Matrix ictm;
   double t0, t1, dt;
   GfxUnivariateShading *shading;
   GfxState *state;
   SplashColorMode colorMode;
   GfxColorSpaceMode gfxMode;
+  int nComps;
+
+  // device colors at evenly spaced t values, built by the first
+  // getColor() and interpolated linearly
+  double lutTMin, lutTMax;	// t range of the table
+  double lutScale;		// t to table index scale factor
+  int lutSize;			// number of entries, 0 if no table
+  Guchar *lut;			// lutSize colors of nComps bytes
+  Guchar *lutExact;		// intervals which can't be interpolated
 };
 
 class SplashAxialPattern: public SplashUnivariatePattern {
@@ -347,6 +371,17 @@ public:
 
   // Called to indicate that a new PDF document has been loaded.
   void startDoc(PDFDoc *docA);
+
+  // Render page <pg> of the current document into this device's bitmap,
+  // like PDFDoc::displayPage() would, and with the same result, but split
+  // in <nBands> horizontal bands rasterized concurrently, each by a
+  // private output device with the same settings drawing its rows of the
+  // bitmap.  The bands run the page's cached display list and share the
+  // decoded image cache; only the rasterizing and the font caches are per
+  // band.  <nBands> = 0 picks one band per core.
+  void displayPageBands(int pg, double hDPI, double vDPI, int rotate,
+			GBool useMediaBox, GBool crop, GBool printing,
+			int nBands = 0);
  
   void setPaperColor(SplashColorPtr paperColorA);
 
@@ -392,6 +427,11 @@ public:
   GBool getFontAntialias() { return fontAntialias; }
   void setFontAntialias(GBool anti) { fontAntialias = anti; }
 
+  // Quality of the anti-aliasing of filled paths, see SplashAAQuality;
+  // splashAAQualityDraft is meant for thumbnails.
+  SplashAAQuality getAAQuality() { return aaQuality; }
+  void setAAQuality(SplashAAQuality aaQualityA);
+
   void setFreeTypeHinting(GBool enable, GBool enableSlightHinting);
 
 protected:
@@ -420,6 +460,8 @@ private:
   static GBool iccImageSrc(void *data, SplashColorPtr colorLine,
 			Guchar *alphaLine);
 #endif
+  Stream *getImageDataStream(Object *ref, Stream *str, int width, int height,
+			     GfxImageColorMap *colorMap);
   static GBool imageMaskSrc(void *data, SplashColorPtr line);
   static GBool imageSrc(void *data, SplashColorPtr colorLine,
 			Guchar *alphaLine);
@@ -438,6 +480,7 @@ private:
   GBool bitmapUpsideDown;
   GBool fontAntialias;
   GBool vectorAntialias;
+  SplashAAQuality aaQuality;
   GBool overprintPreview;
   GBool enableFreeTypeHinting;
   GBool enableSlightHinting;
@@ -454,6 +497,13 @@ private:
   Splash *splash;
   SplashFontEngine *fontEngine;
 
+  SplashOutputDev **bandDevs;	// devices rasterizing the bands of
+  int nBandDevs;		//   displayPageBands()
+  int bandY, bandHeight;	// rows of the page drawn by a band device,
+				//   bandHeight = 0 for the whole page
+  SplashBitmap *pageBitmap;	// the bitmap of the page a band device
+				//   draws in, shared with the other bands
+
   T3FontCache *			// Type 3 font cache
     t3FontCache[splashOutT3FontCacheSize];
   int nT3Fonts;			// number of valid entries in t3FontCache
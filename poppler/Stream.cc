@@ -82,6 +82,11 @@
 #include "JPXStream.h"
 #endif
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#define USE_SSE2_PREDICTORS 1
+#include <immintrin.h>
+#endif
+
 #ifdef __DJGPP__
 static GBool setDJSYSFLAGS = gFalse;
 #endif
@@ -99,6 +104,33 @@ static GBool setDJSYSFLAGS = gFalse;
 #else
 #  define streamLocker()
 #endif
+
+// Copies up to <nChars> bytes out of a stream's <bufPtr>..<bufEnd>
+// buffer, calling <fillBuf> to refill it (and reset both pointers)
+// whenever it runs dry.  Returns the number of bytes copied.
+template <typename FillBuf>
+static int getBufChars(char *&bufPtr, char *&bufEnd, FillBuf fillBuf,
+		       int nChars, Guchar *buffer) {
+  int n, m;
+
+  n = 0;
+  while (n < nChars) {
+    if (bufPtr >= bufEnd) {
+      if (!fillBuf()) {
+	break;
+      }
+    }
+    m = (int)(bufEnd - bufPtr);
+    if (m > nChars - n) {
+      m = nChars - n;
+    }
+    memcpy(buffer + n, bufPtr, m);
+    bufPtr += m;
+    n += m;
+  }
+  return n;
+}
+
 //------------------------------------------------------------------------
 // Stream (base class)
 //------------------------------------------------------------------------
@@ -141,8 +173,9 @@ int Stream::getChars(int nChars, Guchar *buffer) {
   return 0;
 }
 
-void Stream::getRawChars(int nChars, int *buffer) {
+int Stream::getRawChars(int nChars, Guchar *buffer) {
   error(errInternal, -1, "Internal: called getRawChars() on non-predictor stream");
+  return 0;
 }
 
 char *Stream::getLine(char *buf, int size) {
@@ -557,6 +590,293 @@ void ImageStream::skipLine() {
   str->doGetChars(inputLineSize, inputLine);
 }
 
+//------------------------------------------------------------------------
+// predictor row kernels
+//------------------------------------------------------------------------
+
+// The kernels undo the predictors for 8-bit data, <bpp> being the
+// number of bytes per pixel.  <out> points to the first pixel of the
+// line, the <bpp> bytes before it are those of the pixel on the left
+// (0 for the first pixel).  The SSE2 versions handle 1, 3 and 4 bytes per
+// pixel, by far the most common (gray, RGB, CMYK/RGBA), SSE2 being always
+// there on x86-64; AVX2 is checked at run time.
+
+// out[i] = out[i - bpp] + in[i], PNG Sub and 8-bit TIFF predictors; <in>
+// can be <out>
+static void predictLeftScalar(Guchar *out, const Guchar *in, int n, int bpp,
+			      int i) {
+  for (; i < n; ++i) {
+    out[i] = out[i - bpp] + in[i];
+  }
+}
+
+// out[i] += in[i], PNG Up predictor
+static void predictUpScalar(Guchar *out, const Guchar *in, int n, int i) {
+  for (; i < n; ++i) {
+    out[i] += in[i];
+  }
+}
+
+// out[i] = ((out[i - bpp] + up[i]) >> 1) + in[i], up being the previous
+// line, i.e. <out> itself before it's overwritten, PNG Average predictor
+static void predictAverageScalar(Guchar *out, const Guchar *in, int n,
+				 int bpp, int i) {
+  for (; i < n; ++i) {
+    out[i] = ((out[i - bpp] + out[i]) >> 1) + in[i];
+  }
+}
+
+// PNG Paeth predictor, <prev> is the previous line (with the same <bpp>
+// bytes before its start as <out>)
+static void predictPaethScalar(Guchar *out, const Guchar *prev,
+			       const Guchar *in, int n, int bpp, int i) {
+  int left, up, upLeft, p, pa, pb, pc;
+
+  for (; i < n; ++i) {
+    left = out[i - bpp];
+    up = prev[i];
+    upLeft = prev[i - bpp];
+    p = left + up - upLeft;
+    if ((pa = p - left) < 0)
+      pa = -pa;
+    if ((pb = p - up) < 0)
+      pb = -pb;
+    if ((pc = p - upLeft) < 0)
+      pc = -pc;
+    if (pa <= pb && pa <= pc)
+      out[i] = left + in[i];
+    else if (pb <= pc)
+      out[i] = up + in[i];
+    else
+      out[i] = upLeft + in[i];
+  }
+}
+
+#ifdef USE_SSE2_PREDICTORS
+
+// the bytes of a pixel, 3 or 4 of them, in the low lane
+template <int bpp>
+static inline __m128i loadPixel(const Guchar *p) {
+  Guint x;
+
+  if (bpp == 4) {
+    memcpy(&x, p, 4);
+  } else {
+    x = p[0] | (p[1] << 8) | (p[2] << 16);
+  }
+  return _mm_cvtsi32_si128((int)x);
+}
+
+template <int bpp>
+static inline void storePixel(Guchar *p, __m128i v) {
+  Guint x;
+
+  x = (Guint)_mm_cvtsi128_si32(v);
+  if (bpp == 4) {
+    memcpy(p, &x, 4);
+  } else {
+    p[0] = (Guchar)x;
+    p[1] = (Guchar)(x >> 8);
+    p[2] = (Guchar)(x >> 16);
+  }
+}
+
+static void predictLeftSSE2(Guchar *out, const Guchar *in, int n, int bpp) {
+  __m128i d, a, t, keep;
+  int i;
+
+  i = 0;
+  if (bpp == 4) {
+    // 4 pixels at a time: prefix sum of the pixels, plus the last pixel
+    // of the previous block
+    a = _mm_shuffle_epi32(loadPixel<4>(out - 4), 0);
+    for (; i + 16 <= n; i += 16) {
+      d = _mm_loadu_si128((const __m128i *)(in + i));
+      d = _mm_add_epi8(d, _mm_slli_si128(d, 4));
+      d = _mm_add_epi8(d, _mm_slli_si128(d, 8));
+      d = _mm_add_epi8(d, a);
+      _mm_storeu_si128((__m128i *)(out + i), d);
+      a = _mm_shuffle_epi32(d, 0xff);
+    }
+  } else if (bpp == 3) {
+    // 5 pixels at a time, the 16th byte is stored back unchanged
+    keep = _mm_slli_si128(_mm_cvtsi32_si128(0xff), 15);
+    t = loadPixel<3>(out - 3);
+    t = _mm_or_si128(t, _mm_slli_si128(t, 3));
+    t = _mm_or_si128(t, _mm_slli_si128(t, 6));
+    a = _mm_or_si128(t, _mm_slli_si128(t, 12));
+    for (; i + 16 <= n; i += 15) {
+      t = _mm_loadu_si128((const __m128i *)(in + i));
+      d = _mm_add_epi8(t, _mm_slli_si128(t, 3));
+      d = _mm_add_epi8(d, _mm_slli_si128(d, 6));
+      d = _mm_add_epi8(d, _mm_slli_si128(d, 12));
+      d = _mm_add_epi8(d, a);
+      d = _mm_or_si128(_mm_andnot_si128(keep, d), _mm_and_si128(keep, t));
+      _mm_storeu_si128((__m128i *)(out + i), d);
+      t = _mm_and_si128(_mm_srli_si128(d, 12), _mm_cvtsi32_si128(0xffffff));
+      t = _mm_or_si128(t, _mm_slli_si128(t, 3));
+      t = _mm_or_si128(t, _mm_slli_si128(t, 6));
+      a = _mm_or_si128(t, _mm_slli_si128(t, 12));
+    }
+  } else if (bpp == 1) {
+    a = _mm_set1_epi8((char)out[-1]);
+    for (; i + 16 <= n; i += 16) {
+      d = _mm_loadu_si128((const __m128i *)(in + i));
+      d = _mm_add_epi8(d, _mm_slli_si128(d, 1));
+      d = _mm_add_epi8(d, _mm_slli_si128(d, 2));
+      d = _mm_add_epi8(d, _mm_slli_si128(d, 4));
+      d = _mm_add_epi8(d, _mm_slli_si128(d, 8));
+      d = _mm_add_epi8(d, a);
+      _mm_storeu_si128((__m128i *)(out + i), d);
+      t = _mm_srli_si128(d, 15);
+      t = _mm_unpacklo_epi8(t, t);
+      t = _mm_unpacklo_epi16(t, t);
+      a = _mm_shuffle_epi32(t, 0);
+    }
+  }
+  predictLeftScalar(out, in, n, bpp, i);
+}
+
+__attribute__((target("avx2")))
+static void predictUpAVX2(Guchar *out, const Guchar *in, int n) {
+  __m256i d;
+  int i;
+
+  for (i = 0; i + 32 <= n; i += 32) {
+    d = _mm256_add_epi8(_mm256_loadu_si256((const __m256i *)(out + i)),
+			_mm256_loadu_si256((const __m256i *)(in + i)));
+    _mm256_storeu_si256((__m256i *)(out + i), d);
+  }
+  predictUpScalar(out, in, n, i);
+}
+
+static void predictUpSSE2(Guchar *out, const Guchar *in, int n) {
+  __m128i d;
+  int i;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    d = _mm_add_epi8(_mm_loadu_si128((const __m128i *)(out + i)),
+		     _mm_loadu_si128((const __m128i *)(in + i)));
+    _mm_storeu_si128((__m128i *)(out + i), d);
+  }
+  predictUpScalar(out, in, n, i);
+}
+
+// a pixel at a time, the average is (a & b) + ((a ^ b) >> 1) without
+// overflow
+template <int bpp>
+static void predictAverageSSE2(Guchar *out, const Guchar *in, int n) {
+  __m128i a, b, lsb;
+  int i;
+
+  lsb = _mm_set1_epi8(1);
+  a = loadPixel<bpp>(out - bpp);
+  for (i = 0; i + bpp <= n; i += bpp) {
+    b = loadPixel<bpp>(out + i);
+    // floor((a + b) / 2) = avg_epu8(a, b) - ((a ^ b) & 1)
+    a = _mm_sub_epi8(_mm_avg_epu8(a, b),
+		     _mm_and_si128(_mm_xor_si128(a, b), lsb));
+    a = _mm_add_epi8(a, loadPixel<bpp>(in + i));
+    storePixel<bpp>(out + i, a);
+  }
+  predictAverageScalar(out, in, n, bpp, i);
+}
+
+static inline __m128i abs16(__m128i x) {
+  return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+// a pixel at a time, in 16-bit lanes: with p = a + b - c,
+// |p - a| = |b - c|, |p - b| = |a - c| and |p - c| = |b - c + a - c|
+template <int bpp>
+static void predictPaethSSE2(Guchar *out, const Guchar *prev,
+			     const Guchar *in, int n) {
+  __m128i zero, a, b, c, pa, pb, pc, smallest, nearest, isA, isB;
+  int i;
+
+  zero = _mm_setzero_si128();
+  a = _mm_unpacklo_epi8(loadPixel<bpp>(out - bpp), zero);
+  c = _mm_unpacklo_epi8(loadPixel<bpp>(prev - bpp), zero);
+  for (i = 0; i + bpp <= n; i += bpp) {
+    b = _mm_unpacklo_epi8(loadPixel<bpp>(prev + i), zero);
+    pa = _mm_sub_epi16(b, c);
+    pb = _mm_sub_epi16(a, c);
+    pc = abs16(_mm_add_epi16(pa, pb));
+    pa = abs16(pa);
+    pb = abs16(pb);
+    smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+    isA = _mm_cmpeq_epi16(smallest, pa);
+    isB = _mm_andnot_si128(isA, _mm_cmpeq_epi16(smallest, pb));
+    nearest = _mm_or_si128(_mm_and_si128(isA, a),
+			   _mm_andnot_si128(isA, c));
+    nearest = _mm_or_si128(_mm_and_si128(isB, b),
+			   _mm_andnot_si128(isB, nearest));
+    a = _mm_add_epi8(_mm_packus_epi16(nearest, zero),
+		     loadPixel<bpp>(in + i));
+    storePixel<bpp>(out + i, a);
+    a = _mm_unpacklo_epi8(a, zero);
+    c = b;
+  }
+  predictPaethScalar(out, prev, in, n, bpp, i);
+}
+
+static GBool haveAVX2() {
+  static const GBool avx2 = __builtin_cpu_supports("avx2") ? gTrue : gFalse;
+
+  return avx2;
+}
+
+#endif // USE_SSE2_PREDICTORS
+
+static void predictLeft(Guchar *out, const Guchar *in, int n, int bpp) {
+#ifdef USE_SSE2_PREDICTORS
+  if (bpp == 1 || bpp == 3 || bpp == 4) {
+    predictLeftSSE2(out, in, n, bpp);
+    return;
+  }
+#endif
+  predictLeftScalar(out, in, n, bpp, 0);
+}
+
+static void predictUp(Guchar *out, const Guchar *in, int n) {
+#ifdef USE_SSE2_PREDICTORS
+  if (haveAVX2()) {
+    predictUpAVX2(out, in, n);
+  } else {
+    predictUpSSE2(out, in, n);
+  }
+#else
+  predictUpScalar(out, in, n, 0);
+#endif
+}
+
+static void predictAverage(Guchar *out, const Guchar *in, int n, int bpp) {
+#ifdef USE_SSE2_PREDICTORS
+  if (bpp == 3) {
+    predictAverageSSE2<3>(out, in, n);
+    return;
+  } else if (bpp == 4) {
+    predictAverageSSE2<4>(out, in, n);
+    return;
+  }
+#endif
+  predictAverageScalar(out, in, n, bpp, 0);
+}
+
+static void predictPaeth(Guchar *out, const Guchar *prev, const Guchar *in,
+			 int n, int bpp) {
+#ifdef USE_SSE2_PREDICTORS
+  if (bpp == 3) {
+    predictPaethSSE2<3>(out, prev, in, n);
+    return;
+  } else if (bpp == 4) {
+    predictPaethSSE2<4>(out, prev, in, n);
+    return;
+  }
+#endif
+  predictPaethScalar(out, prev, in, n, bpp, 0);
+}
+
 //------------------------------------------------------------------------
 // StreamPredictor
 //------------------------------------------------------------------------
@@ -569,6 +889,8 @@ StreamPredictor::StreamPredictor(Stream *strA, int predictorA,
   nComps = nCompsA;
   nBits = nBitsA;
   predLine = nullptr;
+  rawLine = nullptr;
+  prevLine = nullptr;
   ok = gFalse;
 
   nVals = width * nComps;
@@ -584,12 +906,18 @@ StreamPredictor::StreamPredictor(Stream *strA, int predictorA,
   predLine = (Guchar *)gmalloc(rowBytes);
   memset(predLine, 0, rowBytes);
   predIdx = rowBytes;
+  if (predictor >= 10) {
+    rawLine = (Guchar *)gmalloc(rowBytes);
+    prevLine = (Guchar *)gmalloc(rowBytes);
+  }
 
   ok = gTrue;
 }
 
 StreamPredictor::~StreamPredictor() {
   gfree(predLine);
+  gfree(rawLine);
+  gfree(prevLine);
 }
 
 int StreamPredictor::lookChar() {
@@ -634,11 +962,9 @@ int StreamPredictor::getChars(int nChars, Guchar *buffer) {
 GBool StreamPredictor::getNextLine() {
   int curPred;
   Guchar upLeftBuf[gfxColorMaxComps * 2 + 1];
-  int left, up, upLeft, p, pa, pb, pc;
-  int c;
   Gulong inBuf, outBuf, bitMask;
   int inBits, outBits;
-  int i, j, k, kk;
+  int i, j, k, kk, n, end;
 
   // get PNG optimum predictor number
   if (predictor >= 10) {
@@ -651,60 +977,42 @@ GBool StreamPredictor::getNextLine() {
   }
 
   // read the raw line, apply PNG (byte) predictor
-  int *rawCharLine = new int[rowBytes - pixBytes];
-  str->getRawChars(rowBytes - pixBytes, rawCharLine);
-  memset(upLeftBuf, 0, pixBytes + 1);
-  for (i = pixBytes; i < rowBytes; ++i) {
-    for (j = pixBytes; j > 0; --j) {
-      upLeftBuf[j] = upLeftBuf[j-1];
-    }
-    upLeftBuf[0] = predLine[i];
-    if ((c = rawCharLine[i - pixBytes]) == EOF) {
-      if (i > pixBytes) {
-	// this ought to return false, but some (broken) PDF files
-	// contain truncated image data, and Adobe apparently reads the
-	// last partial line
-	break;
-      }
-      delete[] rawCharLine;
+  if (predictor >= 10) {
+    n = str->getRawChars(rowBytes - pixBytes, rawLine + pixBytes);
+    if (n == 0) {
       return gFalse;
     }
+    // this ought to return false, but some (broken) PDF files contain
+    // truncated image data, and Adobe apparently reads the last partial
+    // line; the rest of the line keeps the values of the previous one
+    end = pixBytes + n;
     switch (curPred) {
     case 11:			// PNG sub
-      predLine[i] = predLine[i - pixBytes] + (Guchar)c;
+      predictLeft(predLine + pixBytes, rawLine + pixBytes, n, pixBytes);
       break;
     case 12:			// PNG up
-      predLine[i] = predLine[i] + (Guchar)c;
+      predictUp(predLine + pixBytes, rawLine + pixBytes, n);
       break;
     case 13:			// PNG average
-      predLine[i] = ((predLine[i - pixBytes] + predLine[i]) >> 1) +
-	            (Guchar)c;
+      predictAverage(predLine + pixBytes, rawLine + pixBytes, n, pixBytes);
       break;
     case 14:			// PNG Paeth
-      left = predLine[i - pixBytes];
-      up = predLine[i];
-      upLeft = upLeftBuf[pixBytes];
-      p = left + up - upLeft;
-      if ((pa = p - left) < 0)
-	pa = -pa;
-      if ((pb = p - up) < 0)
-	pb = -pb;
-      if ((pc = p - upLeft) < 0)
-	pc = -pc;
-      if (pa <= pb && pa <= pc)
-	predLine[i] = left + (Guchar)c;
-      else if (pb <= pc)
-	predLine[i] = up + (Guchar)c;
-      else
-	predLine[i] = upLeft + (Guchar)c;
+      memcpy(prevLine, predLine, end);
+      predictPaeth(predLine + pixBytes, prevLine + pixBytes,
+		   rawLine + pixBytes, n, pixBytes);
       break;
     case 10:			// PNG none
-    default:			// no predictor or TIFF predictor
-      predLine[i] = (Guchar)c;
+    default:
+      memcpy(predLine + pixBytes, rawLine + pixBytes, n);
       break;
     }
+  } else {
+    // no predictor or TIFF predictor
+    n = str->getRawChars(rowBytes - pixBytes, predLine + pixBytes);
+    if (n == 0) {
+      return gFalse;
+    }
   }
-  delete[] rawCharLine;
 
   // apply TIFF (component) predictor
   if (predictor == 2) {
@@ -716,9 +1024,8 @@ GBool StreamPredictor::getNextLine() {
 	predLine[i] ^= inBuf >> nComps;
       }
     } else if (nBits == 8) {
-      for (i = pixBytes; i < rowBytes; ++i) {
-	predLine[i] += predLine[i - nComps];
-      }
+      predictLeft(predLine + pixBytes, predLine + pixBytes,
+		  rowBytes - pixBytes, nComps);
     } else {
       memset(upLeftBuf, 0, nComps + 1);
       bitMask = (1 << nBits) - 1;
@@ -846,6 +1153,62 @@ void FileStream::moveStart(Goffset delta) {
   bufPos = start;
 }
 
+//------------------------------------------------------------------------
+// MmapStream
+//------------------------------------------------------------------------
+
+// the system is told to read ahead the data of streams this long
+#define mmapStreamAdviseMinLength (64 * 1024)
+
+MmapStream *MmapStream::open(GooFile *file) {
+  const char *data;
+  Goffset mapLengthA;
+
+  if (!(data = file->map(&mapLengthA))) {
+    return nullptr;
+  }
+  return new MmapStream(data, 0, mapLengthA, Object(objNull), gFalse,
+			mapLengthA);
+}
+
+MmapStream::MmapStream(const char *bufA, Goffset startA, Goffset lengthA,
+		       Object &&dictA, GBool limitedA, Goffset mapLengthA):
+    BaseMemStream(bufA, startA, lengthA, std::move(dictA)) {
+  limited = limitedA;
+  mapLength = mapLengthA;
+}
+
+MmapStream::~MmapStream() {
+  if (mapLength > 0) {
+    GooFile::unmap(buf, mapLength);
+  }
+}
+
+BaseStream *MmapStream::copy() {
+  return new MmapStream(buf, getStart(), length, dict.copy(), limited, 0);
+}
+
+Stream *MmapStream::makeSubStream(Goffset startA, GBool limitedA,
+				  Goffset lengthA, Object &&dictA) {
+  Goffset newLength;
+
+  if (!limitedA || startA + lengthA > getStart() + length) {
+    newLength = getStart() + length - startA;
+  } else {
+    newLength = lengthA;
+  }
+  return new MmapStream(buf, startA, newLength, std::move(dictA), limitedA, 0);
+}
+
+void MmapStream::reset() {
+  BaseMemStream::reset();
+  // the data of a stream, e.g. a big image, is read once from start to
+  // end; everything else is read here and there
+  if (limited && length >= mmapStreamAdviseMinLength) {
+    GooFile::adviseSequential(buf + getStart(), length);
+  }
+}
+
 //------------------------------------------------------------------------
 // CachedFileStream
 //------------------------------------------------------------------------
@@ -922,6 +1285,12 @@ GBool CachedFileStream::fillBuf()
   return gTrue;
 }
 
+int CachedFileStream::getChars(int nChars, Guchar *buffer)
+{
+  return getBufChars(bufPtr, bufEnd, [this] { return fillBuf(); },
+		     nChars, buffer);
+}
+
 void CachedFileStream::setPos(Goffset pos, int dir)
 {
   Guint size;
@@ -1049,18 +1418,18 @@ int EmbedStream::getChars(int nChars, Guchar *buffer) {
     return 0;
   }
   if (replay) {
-    if (bufPos >= bufLen)
-      return EOF;
     len = bufLen - bufPos;
     if (nChars > len)
       nChars = len;
-    memcpy(buffer, bufData, nChars);
-    return len;
+    memcpy(buffer, bufData + bufPos, nChars);
+    bufPos += nChars;
+    return nChars;
   } else {
     if (limited && length < nChars) {
       nChars = length;
     }
     len = str->doGetChars(nChars, buffer);
+    length -= len;
     if (record) {
       if (bufLen + len >= bufMax) {
         while (bufLen + len >= bufMax)
@@ -1163,6 +1532,22 @@ int ASCIIHexStream::lookChar() {
   return buf;
 }
 
+int ASCIIHexStream::getChars(int nChars, Guchar *buffer) {
+  int n, c;
+
+  // the encoded data can't be read ahead, the stream might end in the
+  // middle of a content stream (inline images), but this saves a virtual
+  // call per byte
+  for (n = 0; n < nChars; ++n) {
+    if ((c = ASCIIHexStream::lookChar()) == EOF) {
+      break;
+    }
+    buffer[n] = (Guchar)c;
+    buf = EOF;
+  }
+  return n;
+}
+
 GooString *ASCIIHexStream::getPSFilter(int psLevel, const char *indent) {
   GooString *s;
 
@@ -1244,6 +1629,22 @@ int ASCII85Stream::lookChar() {
   return b[index];
 }
 
+int ASCII85Stream::getChars(int nChars, Guchar *buffer) {
+  int i;
+
+  // see ASCIIHexStream::getChars
+  i = 0;
+  while (i < nChars) {
+    if (index >= n && ASCII85Stream::lookChar() == EOF) {
+      break;
+    }
+    while (i < nChars && index < n) {
+      buffer[i++] = (Guchar)b[index++];
+    }
+  }
+  return i;
+}
+
 GooString *ASCII85Stream::getPSFilter(int psLevel, const char *indent) {
   GooString *s;
 
@@ -1320,24 +1721,20 @@ int LZWStream::lookChar() {
   return seqBuf[seqIndex];
 }
 
-void LZWStream::getRawChars(int nChars, int *buffer) {
-  for (int i = 0; i < nChars; ++i)
-    buffer[i] = doGetRawChar();
-}
-
 int LZWStream::getRawChar() {
   return doGetRawChar();
 }
 
 int LZWStream::getChars(int nChars, Guchar *buffer) {
-  int n, m;
-
   if (pred) {
     return pred->getChars(nChars, buffer);
   }
-  if (eof) {
-    return 0;
-  }
+  return getRawChars(nChars, buffer);
+}
+
+int LZWStream::getRawChars(int nChars, Guchar *buffer) {
+  int n, m;
+
   n = 0;
   while (n < nChars) {
     if (seqIndex >= seqLength) {
@@ -2325,6 +2722,19 @@ short CCITTFaxStream::lookBits(int n) {
   return (inputBuf >> (inputBits - n)) & (0xffffffff >> (32 - n));
 }
 
+int CCITTFaxStream::getChars(int nChars, Guchar *buffer) {
+  int n, c;
+
+  for (n = 0; n < nChars; ++n) {
+    if ((c = CCITTFaxStream::lookChar()) == EOF) {
+      break;
+    }
+    buffer[n] = (Guchar)c;
+    buf = EOF;
+  }
+  return n;
+}
+
 GooString *CCITTFaxStream::getPSFilter(int psLevel, const char *indent) {
   GooString *s;
   char s1[50];
@@ -4570,14 +4980,8 @@ int FlateStream::getChar() {
 int FlateStream::getChars(int nChars, Guchar *buffer) {
   if (pred) {
     return pred->getChars(nChars, buffer);
-  } else {
-    for (int i = 0; i < nChars; ++i) {
-      const int c = doGetRawChar();
-      if (likely(c != EOF)) buffer[i] = c;
-      else return i;
-    }
-    return nChars;
   }
+  return getRawChars(nChars, buffer);
 }
 
 int FlateStream::lookChar() {
@@ -4595,9 +4999,31 @@ int FlateStream::lookChar() {
   return c;
 }
 
-void FlateStream::getRawChars(int nChars, int *buffer) {
-  for (int i = 0; i < nChars; ++i)
-    buffer[i] = doGetRawChar();
+int FlateStream::getRawChars(int nChars, Guchar *buffer) {
+  int n, m;
+
+  n = 0;
+  while (n < nChars) {
+    while (remain == 0) {
+      if (endOfBlock && eof) {
+	return n;
+      }
+      readSome();
+    }
+    // copy up to the end of the window, it wraps around
+    m = remain;
+    if (m > flateWindow - index) {
+      m = flateWindow - index;
+    }
+    if (m > nChars - n) {
+      m = nChars - n;
+    }
+    memcpy(buffer + n, buf + index, m);
+    index = (index + m) & flateMask;
+    remain -= m;
+    n += m;
+  }
+  return n;
 }
 
 int FlateStream::getRawChar() {
@@ -5065,6 +5491,11 @@ void ASCIIHexEncoder::reset() {
   eof = gFalse;
 }
 
+int ASCIIHexEncoder::getChars(int nChars, Guchar *buffer) {
+  return getBufChars(bufPtr, bufEnd, [this] { return fillBuf(); },
+		     nChars, buffer);
+}
+
 GBool ASCIIHexEncoder::fillBuf() {
   static const char *hex = "0123456789abcdef";
   int c;
@@ -5111,6 +5542,11 @@ void ASCII85Encoder::reset() {
   eof = gFalse;
 }
 
+int ASCII85Encoder::getChars(int nChars, Guchar *buffer) {
+  return getBufChars(bufPtr, bufEnd, [this] { return fillBuf(); },
+		     nChars, buffer);
+}
+
 GBool ASCII85Encoder::fillBuf() {
   Guint t;
   char buf1[5];
@@ -5201,6 +5637,11 @@ void RunLengthEncoder::reset() {
   eof = gFalse;
 }
 
+int RunLengthEncoder::getChars(int nChars, Guchar *buffer) {
+  return getBufChars(bufPtr, bufEnd, [this] { return fillBuf(); },
+		     nChars, buffer);
+}
+
 //
 // When fillBuf finishes, buf[] looks like this:
 //   +-----+--------------+-----------------+--
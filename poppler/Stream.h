@@ -173,10 +173,16 @@ public:
   // Peek at next char in stream.
   virtual int lookChar() = 0;
 
-  // Get next char from stream without using the predictor.
-  // This is only used by StreamPredictor.
+  // Get next char / up to <nChars> chars from stream without using the
+  // predictor, getRawChars() returns the number of chars read.  This is
+  // only used by StreamPredictor.
   virtual int getRawChar();
-  virtual void getRawChars(int nChars, int *buffer);
+  virtual int getRawChars(int nChars, Guchar *buffer);
+
+  // Can chars be read past the end of the encoded data, by a filter that
+  // reads its input in blocks?  Not for the data of an inline image, the
+  // rest of its content stream follows it.
+  virtual GBool canReadAhead() { return gTrue; }
 
   // Get next char directly from stream source, without filtering it
   virtual int getUnfilteredChar () = 0;
@@ -221,6 +227,40 @@ public:
   virtual void getImageParams(int * /*bitsPerComponent*/,
 			      StreamColorSpaceMode * /*csMode*/) {}
 
+  // Does the image filter follow the hints below?  The same image may
+  // then be decoded differently with other hints.
+  virtual GBool usesImageHints() { return gFalse; }
+
+  // Hint, given before reset(), that the image is drawn at no more than
+  // <minWidth> x <minHeight> pixels.  The image filters that can decode
+  // at a fraction of the full size for less (DCT) use the smallest such
+  // size that is still at least that big.
+  virtual void setMinImageSize(int /*minWidth*/, int /*minHeight*/) {}
+
+  // Once reset, returns true and sets the size of the image if the hint
+  // above was followed, and the image is smaller than its dictionary
+  // says.
+  virtual GBool getReducedImageSize(int * /*width*/, int * /*height*/)
+    { return gFalse; }
+
+  // Hint, given before reset(), that only the pixels <x0>,<y0> up to,
+  // but excluding, <x1>,<y1> of the image are drawn.  The image filters
+  // that can decode part of an image (JPX) decode at least that part.
+  virtual void setImageArea(int /*x0*/, int /*y0*/, int /*x1*/, int /*y1*/) {}
+
+  // Once reset, returns true and sets the part of the image that was
+  // decoded, in pixels of the full size image, if it isn't the whole
+  // image.  getReducedImageSize() then gives the size of that part.
+  virtual GBool getImageArea(int * /*x0*/, int * /*y0*/,
+			     int * /*x1*/, int * /*y1*/)
+    { return gFalse; }
+
+  // Hint, given before reset(), of how many threads the image filters
+  // that can decode on several of them (JPX) may use at most, on top
+  // of the limit set in GlobalParams; 0 for no more limit, 1 when the
+  // caller is already one of several threads drawing the page.
+  virtual void setMaxDecodeThreads(int /*maxThreads*/) {}
+
   // Return the next stream in the "stack".
   virtual Stream *getNextStream() { return NULL; }
 
@@ -322,6 +362,9 @@ public:
   virtual GooString *getFileName() { return NULL; }
   virtual Goffset getLength() { return length; }
 
+  // Can sub streams be made and read by several threads at once?
+  virtual GBool hasThreadSafeSubStreams() { return gFalse; }
+
   // Get/set position of first byte of stream within the file.
   virtual Goffset getStart() = 0;
   virtual void moveStart(Goffset delta) = 0;
@@ -443,6 +486,8 @@ private:
   int pixBytes;			// bytes per pixel
   int rowBytes;			// bytes per line
   Guchar *predLine;		// line buffer
+  Guchar *rawLine;		// undecoded line, for PNG predictors
+  Guchar *prevLine;		// previous line, for the Paeth predictor
   int predIdx;			// current index in predLine
   GBool ok;
 };
@@ -463,6 +508,8 @@ public:
   Stream *makeSubStream(Goffset startA, GBool limitedA,
 				Goffset lengthA, Object &&dictA) override;
   StreamKind getKind() override { return strFile; }
+  // GooFile reads at a given offset, without a shared file position
+  GBool hasThreadSafeSubStreams() override { return gTrue; }
   void reset() override;
   void close() override;
   int getChar() override
@@ -551,6 +598,9 @@ private:
 
   GBool fillBuf();
 
+  GBool hasGetChars() override { return true; }
+  int getChars(int nChars, Guchar *buffer) override;
+
   CachedFile *cc;
   Goffset start;
   GBool limited;
@@ -595,6 +645,7 @@ public:
   }
 
   StreamKind getKind() override { return strWeird; }
+  GBool hasThreadSafeSubStreams() override { return gTrue; }
   void reset() override {
     bufPtr = buf + start;
   }
@@ -607,10 +658,10 @@ public:
   int lookChar() override
     { return (bufPtr < bufEnd) ? (*bufPtr & 0xff) : EOF; }
 
-  Goffset getPos() override { return (int)(bufPtr - buf); }
+  Goffset getPos() override { return (Goffset)(bufPtr - buf); }
 
   void setPos(Goffset pos, int dir = 0) override {
-    Guint i;
+    Goffset i;
 
     if (dir >= 0) {
       i = pos;
@@ -684,6 +735,37 @@ public:
     { gfree(buf); }
 };
 
+//------------------------------------------------------------------------
+// MmapStream
+//
+// A file mapped in memory.  Reading it doesn't need any system call or
+// copy, and its sub streams read straight from the mapping.
+//------------------------------------------------------------------------
+
+class MmapStream: public BaseMemStream<const char> {
+public:
+
+  // Maps the whole <file>.  Returns NULL if it can't be mapped, a
+  // FileStream has to be used then.  The file must stay open as long as
+  // the stream and its sub streams are used.
+  static MmapStream *open(GooFile *file);
+
+  ~MmapStream();
+  BaseStream *copy() override;
+  Stream *makeSubStream(Goffset startA, GBool limitedA,
+			Goffset lengthA, Object &&dictA) override;
+  void reset() override;
+
+private:
+
+  MmapStream(const char *bufA, Goffset startA, Goffset lengthA,
+	     Object &&dictA, GBool limitedA, Goffset mapLengthA);
+
+  GBool limited;		// is this the data of a PDF stream?
+  Goffset mapLength;		// length of the mapping, 0 if this stream
+				//   doesn't own it
+};
+
 
 //------------------------------------------------------------------------
 // EmbedStream
@@ -714,6 +796,8 @@ public:
 
   int getUnfilteredChar () override { return str->getUnfilteredChar(); }
   void unfilteredReset () override { str->unfilteredReset(); }
+  // without a length the end of the data is only known once read
+  GBool canReadAhead() override { return limited; }
 
   void rewind();
   void restore();
@@ -754,6 +838,9 @@ public:
 
 private:
 
+  GBool hasGetChars() override { return true; }
+  int getChars(int nChars, Guchar *buffer) override;
+
   int buf;
   GBool eof;
 };
@@ -777,6 +864,9 @@ public:
 
 private:
 
+  GBool hasGetChars() override { return true; }
+  int getChars(int nChars, Guchar *buffer) override;
+
   int c[5];
   int b[4];
   int index, n;
@@ -798,7 +888,7 @@ public:
   int getChar() override;
   int lookChar() override;
   int getRawChar() override;
-  void getRawChars(int nChars, int *buffer) override;
+  int getRawChars(int nChars, Guchar *buffer) override;
   GooString *getPSFilter(int psLevel, const char *indent) override;
   GBool isBinary(GBool last = gTrue) override;
 
@@ -907,6 +997,9 @@ public:
 
 private:
 
+  GBool hasGetChars() override { return true; }
+  int getChars(int nChars, Guchar *buffer) override;
+
   void ccittReset(GBool unfiltered);
   int encoding;			// 'K' parameter
   GBool endOfLine;		// 'EndOfLine' parameter
@@ -1086,7 +1179,7 @@ public:
   int getChar() override;
   int lookChar() override;
   int getRawChar() override;
-  void getRawChars(int nChars, int *buffer) override;
+  int getRawChars(int nChars, Guchar *buffer) override;
   GooString *getPSFilter(int psLevel, const char *indent) override;
   GBool isBinary(GBool last = gTrue) override;
   void unfilteredReset () override;
@@ -1239,6 +1332,9 @@ private:
   GBool eof;
 
   GBool fillBuf();
+
+  GBool hasGetChars() override { return true; }
+  int getChars(int nChars, Guchar *buffer) override;
 };
 
 //------------------------------------------------------------------------
@@ -1269,6 +1365,9 @@ private:
   GBool eof;
 
   GBool fillBuf();
+
+  GBool hasGetChars() override { return true; }
+  int getChars(int nChars, Guchar *buffer) override;
 };
 
 //------------------------------------------------------------------------
@@ -1299,6 +1398,9 @@ private:
   GBool eof;
 
   GBool fillBuf();
+
+  GBool hasGetChars() override { return true; }
+  int getChars(int nChars, Guchar *buffer) override;
 };
 
 //------------------------------------------------------------------------
@@ -72,6 +72,16 @@
 #define permHighResPrint  (1<<11) // bit 12
 #define defPermFlags 0xfffc
 
+// at most this many objects / bytes of objects are kept in the parsed
+// object cache, split evenly between its shards
+#define parsedObjCacheSize 4096
+#define parsedObjCacheCost (4*1024*1024)
+
+// at most this many decoded object streams are kept, and by default at
+// most this many bytes of them
+#define objStrCacheSize 1024
+#define objStrCacheCost (8*1024*1024)
+
 #ifdef MULTITHREADED
 #  define xrefLocker()   MutexLocker locker(&mutex)
 #  define xrefCondLocker(X)  MutexLocker locker(&mutex, (X))
@@ -102,15 +112,23 @@ public:
   int getObjStrNum() { return objStrNum; }
 
   // Get the <objIdx>th object from this stream, which should be
-  // object number <objNum>, generation 0.
-  Object getObject(int objIdx, int objNum);
+  // object number <objNum>, generation 0.  The object is parsed the
+  // first time it is asked for.
+  Object getObject(XRef *xref, int objIdx, int objNum);
+
+  // Approximate memory used by the object stream, in bytes.
+  size_t getCost();
 
 private:
 
   int objStrNum;		// object number of the object stream
   int nObjects;			// number of objects in the stream
-  Object *objs;			// the objects (length = nObjects)
+  GooString *data;		// the decoded stream
+  Object *objs;			// the objects (length = nObjects), objNone
+				//   until parsed
   int *objNums;			// the object numbers (length = nObjects)
+  int *offsets;			// the offsets of the objects in data
+				//   (length = nObjects + 1)
   GBool ok;
 };
 
@@ -127,6 +145,11 @@ class ObjectStreamKey : public PopplerCacheKey
       return objStrNum == k->objStrNum;
     }
 
+    size_t hash() const override
+    {
+      return objStrNum;
+    }
+
     const int objStrNum;
 };
 
@@ -145,18 +168,97 @@ class ObjectStreamItem : public PopplerCacheItem
     ObjectStream *objStream;
 };
 
+//------------------------------------------------------------------------
+// ParsedObjectKey / ParsedObjectItem
+//------------------------------------------------------------------------
+
+class ParsedObjectKey : public PopplerCacheKey
+{
+  public:
+    ParsedObjectKey(int numA, int genA, Goffset offsetA) :
+      num(numA), gen(genA), offset(offsetA)
+    {
+    }
+
+    bool operator==(const PopplerCacheKey &key) const override
+    {
+      const ParsedObjectKey *k = static_cast<const ParsedObjectKey*>(&key);
+      return num == k->num && gen == k->gen && offset == k->offset;
+    }
+
+    size_t hash() const override
+    {
+      return num;
+    }
+
+    const int num;
+    const int gen;
+    // a reconstructed xref table can move the object
+    const Goffset offset;
+};
+
+class ParsedObjectItem : public PopplerCacheItem
+{
+  public:
+    ParsedObjectItem(Object &&objA) : obj(std::move(objA))
+    {
+    }
+
+    Object obj;
+};
+
+// Approximate memory used by a parsed object, 0 if it can't be cached
+// because it has streams, which can't be copied.
+static size_t parsedObjectCost(const Object *obj) {
+  size_t cost, elemCost;
+  int i;
+
+  cost = sizeof(Object);
+  switch (obj->getType()) {
+  case objString:
+    cost += sizeof(GooString) + obj->getString()->getLength();
+    break;
+  case objName:
+    cost += strlen(obj->getName()) + 1;
+    break;
+  case objArray:
+    for (i = 0; i < obj->arrayGetLength(); ++i) {
+      Object elem = obj->arrayGetNF(i);
+      if (!(elemCost = parsedObjectCost(&elem))) {
+	return 0;
+      }
+      cost += elemCost;
+    }
+    break;
+  case objDict:
+    for (i = 0; i < obj->dictGetLength(); ++i) {
+      Object val = obj->dictGetValNF(i);
+      if (!(elemCost = parsedObjectCost(&val))) {
+	return 0;
+      }
+      cost += sizeof(DictEntry) + strlen(obj->dictGetKey(i)) + 1 + elemCost;
+    }
+    break;
+  case objStream:
+    return 0;
+  default:
+    break;
+  }
+  return cost;
+}
+
 ObjectStream::ObjectStream(XRef *xref, int objStrNumA, int recursion) {
-  Stream *str;
   Parser *parser;
-  Goffset *offsets;
   Object objStr, obj1;
-  Goffset first;
+  Goffset first, offset;
   int i;
 
   objStrNum = objStrNumA;
   nObjects = 0;
+  data = nullptr;
   objs = nullptr;
   objNums = nullptr;
+  offsets = nullptr;
   ok = gFalse;
 
   objStr = xref->fetch(objStrNum, 0, recursion);
@@ -192,74 +294,84 @@ ObjectStream::ObjectStream(XRef *xref, int objStrNumA, int recursion) {
     error(errSyntaxError, -1, "Too many objects in an object stream");
     return;
   }
+
+  // decode the whole stream once, the objects are parsed from it as
+  // they are needed
+  data = new GooString();
+  objStr.getStream()->fillGooString(data);
+  objStr.streamClose();
+  if (first > data->getLength()) {
+    first = data->getLength();
+  }
+
   objs = new Object[nObjects];
   objNums = (int *)gmallocn(nObjects, sizeof(int));
-  offsets = (Goffset *)gmallocn(nObjects, sizeof(Goffset));
+  offsets = (int *)gmallocn(nObjects + 1, sizeof(int));
 
   // parse the header: object numbers and offsets
-  objStr.streamReset();
-  str = new EmbedStream(objStr.getStream(), Object(objNull), gTrue, first);
-  parser = new Parser(xref, new Lexer(xref, str), gFalse);
+  parser = new Parser(xref,
+		      new Lexer(xref, new MemStream(data->getCString(), 0, first,
+						    Object(objNull))),
+		      gFalse);
   for (i = 0; i < nObjects; ++i) {
     obj1 = parser->getObj();
     Object obj2 = parser->getObj();
     if (!obj1.isInt() || !(obj2.isInt() || obj2.isInt64())) {
       delete parser;
-      gfree(offsets);
       return;
     }
     objNums[i] = obj1.getInt();
     if (obj2.isInt())
-      offsets[i] = obj2.getInt();
+      offset = obj2.getInt();
     else
-      offsets[i] = obj2.getInt64();
-    if (objNums[i] < 0 || offsets[i] < 0 ||
-	(i > 0 && offsets[i] < offsets[i-1])) {
+      offset = obj2.getInt64();
+    if (objNums[i] < 0 || offset < 0 ||
+	(i > 0 && first + offset < offsets[i-1])) {
       delete parser;
-      gfree(offsets);
       return;
     }
+    // objects past the end of the stream are empty
+    offsets[i] = first + offset < data->getLength() ? first + offset
+                                                    : data->getLength();
   }
-  while (str->getChar() != EOF) ;
+  offsets[nObjects] = data->getLength();
   delete parser;
 
-  // skip to the first object - this shouldn't be necessary because
-  // the First key is supposed to be equal to offsets[0], but just in
-  // case...
-  for (Goffset pos = first; pos < offsets[0]; ++pos) {
-    objStr.getStream()->getChar();
-  }
-
-  // parse the objects
-  for (i = 0; i < nObjects; ++i) {
-    if (i == nObjects - 1) {
-      str = new EmbedStream(objStr.getStream(), Object(objNull), gFalse, 0);
-    } else {
-      str = new EmbedStream(objStr.getStream(), Object(objNull), gTrue,
-			    offsets[i+1] - offsets[i]);
-    }
-    parser = new Parser(xref, new Lexer(xref, str), gFalse);
-    objs[i] = parser->getObj();
-    while (str->getChar() != EOF) ;
-    delete parser;
-  }
-
-  gfree(offsets);
   ok = gTrue;
 }
 
 ObjectStream::~ObjectStream() {
+  delete data;
   delete[] objs;
   gfree(objNums);
+  gfree(offsets);
 }
 
-Object ObjectStream::getObject(int objIdx, int objNum) {
+Object ObjectStream::getObject(XRef *xref, int objIdx, int objNum) {
+  Parser *parser;
+
   if (objIdx < 0 || objIdx >= nObjects || objNum != objNums[objIdx]) {
     return Object(objNull);
   }
+  if (objs[objIdx].isNone()) {
+    parser = new Parser(xref,
+			new Lexer(xref, new MemStream(data->getCString(),
+						      offsets[objIdx],
+						      offsets[objIdx + 1] - offsets[objIdx],
+						      Object(objNull))),
+			gFalse);
+    objs[objIdx] = parser->getObj();
+    delete parser;
+  }
   return objs[objIdx].copy();
 }
 
+size_t ObjectStream::getCost() {
+  // parsed objects take roughly as much memory as their text
+  return sizeof(ObjectStream) + 2 * data->getLength() +
+         nObjects * (sizeof(Object) + sizeof(int) + sizeof(int));
+}
+
 //------------------------------------------------------------------------
 // XRef
 //------------------------------------------------------------------------
@@ -274,9 +386,15 @@ void XRef::init() {
   capacity = 0;
   size = 0;
   modified = gFalse;
+  modificationCount = 0;
   streamEnds = nullptr;
   streamEndsLen = 0;
-  objStrs = new PopplerCache(5);
+  objStrs = new PopplerCache(objStrCacheSize, objStrCacheCost);
+  for (int i = 0; i < parsedObjCacheShards; ++i) {
+    parsedObjs[i] = new PopplerCache(parsedObjCacheSize / parsedObjCacheShards,
+				     parsedObjCacheCost / parsedObjCacheShards,
+				     true);
+  }
   mainXRefEntriesOffset = 0;
   xRefStream = gFalse;
   scannedSpecialFlags = gFalse;
@@ -385,6 +503,9 @@ XRef::~XRef() {
   if (objStrs) {
     delete objStrs;
   }
+  for (int i = 0; i < parsedObjCacheShards; ++i) {
+    delete parsedObjs[i];
+  }
   if (strOwner) {
     delete str;
   }
@@ -879,6 +1000,7 @@ GBool XRef::constructXRef(GBool *wasReconstructed, GBool needCatalogDict) {
   capacity = 0;
   size = 0;
   entries = nullptr;
+  clearParsedObjectCache();
 
   gotRoot = gFalse;
   streamEndsLen = streamEndsSize = 0;
@@ -1027,6 +1149,8 @@ void XRef::setEncryption(int permFlagsA, GBool ownerPasswordOkA,
 			 CryptAlgorithm encAlgorithmA) {
   int i;
 
+  // objects fetched so far weren't decrypted
+  clearParsedObjectCache();
   encrypted = gTrue;
   permFlags = permFlagsA;
   ownerPasswordOk = ownerPasswordOkA;
@@ -1117,8 +1241,6 @@ Object XRef::getCatalog() {
 
 Object XRef::fetch(int num, int gen, int recursion) {
   XRefEntry *e;
-  Parser *parser;
-  Object obj1, obj2, obj3;
 
   xrefLocker();
   // check for bogus ref - this can happen in corrupted PDF files
@@ -1138,42 +1260,41 @@ Object XRef::fetch(int num, int gen, int recursion) {
     if (e->gen != gen) {
       goto err;
     }
-    parser = new Parser(this,
-	       new Lexer(this,
-		 str->makeSubStream(start + e->offset, gFalse, 0, Object(objNull))),
-	       gTrue);
-    obj1 = parser->getObj(recursion);
-    obj2 = parser->getObj(recursion);
-    obj3 = parser->getObj(recursion);
-    if (!obj1.isInt() || obj1.getInt() != num ||
-	!obj2.isInt() || obj2.getInt() != gen ||
-	!obj3.isCmd("obj")) {
-      // some buggy pdf have obj1234 for ints that represent 1234
-      // try to recover here
-      if (obj1.isInt() && obj1.getInt() == num &&
-	  obj2.isInt() && obj2.getInt() == gen &&
-	  obj3.isCmd()) {
-	char *cmd = obj3.getCmd();
-	if (strlen(cmd) > 3 &&
-	    cmd[0] == 'o' &&
-	    cmd[1] == 'b' &&
-	    cmd[2] == 'j') {
-	  char *end_ptr;
-	  long longNumber = strtol(cmd + 3, &end_ptr, 0);
-	  if (longNumber <= INT_MAX && longNumber >= INT_MIN && *end_ptr == '\0') {
-	    int number = longNumber;
-	    error(errSyntaxWarning, -1, "Cmd was not obj but {0:s}, assuming the creator meant obj {1:d}", cmd, number);
-	    delete parser;
-	    return Object(number);
-	  }
-	}
+    GBool ok;
+    Guchar *objFileKey = (encrypted && !e->getFlag(XRefEntry::Unencrypted)) ? fileKey : nullptr;
+    // most objects are fetched only once, only cache those fetched again
+    PopplerCache *cache = e->getFlag(XRefEntry::Fetched) ? getParsedObjectCache(num) : nullptr;
+    e->setFlag(XRefEntry::Fetched, gTrue);
+    ParsedObjectKey key(num, gen, e->offset);
+    if (cache) {
+      cache->lock();
+      ParsedObjectItem *item = static_cast<ParsedObjectItem *>(cache->lookup(key));
+      if (item) {
+	// the caller may modify what it gets
+	Object obj = item->obj.deepCopy();
+	cache->unlock();
+	return obj;
       }
-      delete parser;
+      cache->unlock();
+    }
+    // parsing the object only reads the file through a sub stream of its
+    // own, let the other threads fetch objects meanwhile
+    const GBool unlocked = str->hasThreadSafeSubStreams();
+    if (unlocked) {
+      unlock();
+    }
+    Object obj = parseObject(num, gen, start + e->offset, objFileKey, recursion, &ok);
+    if (unlocked) {
+      lock();
+    }
+    if (!ok) {
       goto err;
     }
-    Object obj = parser->getObj(gFalse, (encrypted && !e->getFlag(XRefEntry::Unencrypted)) ? fileKey : nullptr,
-		   encAlgorithm, keyLength, num, gen, recursion);
-    delete parser;
+    size_t cost = cache ? parsedObjectCost(&obj) : 0;
+    if (cost > 0) {
+      cache->put(new ParsedObjectKey(num, gen, key.offset),
+		 new ParsedObjectItem(obj.deepCopy()), cost);
+    }
     return obj;
   }
 
@@ -1209,10 +1330,10 @@ Object XRef::fetch(int num, int gen, int recursion) {
 	e = getEntry(num);
 	ObjectStreamKey *newkey = new ObjectStreamKey(e->offset);
 	ObjectStreamItem *newitem = new ObjectStreamItem(objStr);
-	objStrs->put(newkey, newitem);
+	objStrs->put(newkey, newitem, objStr->getCost());
       }
     }
-    return objStr->getObject(e->gen, num);
+    return objStr->getObject(this, e->gen, num);
   }
 
   default:
@@ -1229,6 +1350,83 @@ Object XRef::fetch(int num, int gen, int recursion) {
   return Object(objNull);
 }
 
+// Parses the object <num> <gen> at <offset>.  This must not modify the
+// XRef, it can run without the xref lock.
+Object XRef::parseObject(int num, int gen, Goffset offset, Guchar *objFileKey,
+			 int recursion, GBool *ok) {
+  Parser *parser;
+  Object obj1, obj2, obj3;
+
+  *ok = gTrue;
+  parser = new Parser(this,
+	     new Lexer(this,
+	       str->makeSubStream(offset, gFalse, 0, Object(objNull))),
+	     gTrue);
+  obj1 = parser->getObj(recursion);
+  obj2 = parser->getObj(recursion);
+  obj3 = parser->getObj(recursion);
+  if (!obj1.isInt() || obj1.getInt() != num ||
+      !obj2.isInt() || obj2.getInt() != gen ||
+      !obj3.isCmd("obj")) {
+    // some buggy pdf have obj1234 for ints that represent 1234
+    // try to recover here
+    if (obj1.isInt() && obj1.getInt() == num &&
+	obj2.isInt() && obj2.getInt() == gen &&
+	obj3.isCmd()) {
+      char *cmd = obj3.getCmd();
+      if (strlen(cmd) > 3 &&
+	  cmd[0] == 'o' &&
+	  cmd[1] == 'b' &&
+	  cmd[2] == 'j') {
+	char *end_ptr;
+	long longNumber = strtol(cmd + 3, &end_ptr, 0);
+	if (longNumber <= INT_MAX && longNumber >= INT_MIN && *end_ptr == '\0') {
+	  int number = longNumber;
+	  error(errSyntaxWarning, -1, "Cmd was not obj but {0:s}, assuming the creator meant obj {1:d}", cmd, number);
+	  delete parser;
+	  return Object(number);
+	}
+      }
+    }
+    delete parser;
+    *ok = gFalse;
+    return Object(objNull);
+  }
+  Object obj = parser->getObj(gFalse, objFileKey, encAlgorithm, keyLength, num, gen, recursion);
+  delete parser;
+  return obj;
+}
+
+void XRef::setObjectStreamCacheCost(size_t maxCost) {
+  xrefLocker();
+  delete objStrs;
+  objStrs = new PopplerCache(objStrCacheSize, maxCost);
+}
+
+void XRef::clearParsedObjectCache() {
+  for (int i = 0; i < parsedObjCacheShards; ++i) {
+    parsedObjs[i]->clear();
+  }
+}
+
+unsigned long XRef::getNumParsedObjectHits() {
+  unsigned long n = 0;
+
+  for (int i = 0; i < parsedObjCacheShards; ++i) {
+    n += parsedObjs[i]->numberOfHits();
+  }
+  return n;
+}
+
+unsigned long XRef::getNumParsedObjectMisses() {
+  unsigned long n = 0;
+
+  for (int i = 0; i < parsedObjCacheShards; ++i) {
+    n += parsedObjs[i]->numberOfMisses();
+  }
+  return n;
+}
+
 void XRef::lock() {
 #ifdef MULTITHREADED
   gLockMutex(&mutex);
@@ -1281,6 +1479,8 @@ void XRef::removeDocInfo() {
 GBool XRef::getStreamEnd(Goffset streamStart, Goffset *streamEnd) {
   int a, b, m;
 
+  // objects are parsed without the lock, see fetch()
+  xrefLocker();
   if (streamEndsLen == 0 ||
       streamStart > streamEnds[streamEndsLen - 1]) {
     return gFalse;
@@ -1358,6 +1558,9 @@ void XRef::setModifiedObject (Object* o, Ref r) {
     return;
   }
   XRefEntry *e = getEntry(r.num);
+  if (e->type == xrefEntryUncompressed) {
+    getParsedObjectCache(r.num)->remove(ParsedObjectKey(r.num, e->gen, e->offset));
+  }
   e->obj = o->copy();
   e->setFlag(XRefEntry::Updated, gTrue);
   setModified();
@@ -1404,6 +1607,9 @@ void XRef::removeIndirectObject(Ref r) {
   if (e->type == xrefEntryFree) {
     return;
   }
+  if (e->type == xrefEntryUncompressed) {
+    getParsedObjectCache(r.num)->remove(ParsedObjectKey(r.num, e->gen, e->offset));
+  }
   e->obj.free();
   e->type = xrefEntryFree;
   e->gen++;
@@ -1691,6 +1897,8 @@ void XRef::scanSpecialFlags() {
     return;
   }
   scannedSpecialFlags = gTrue;
+  // objects that turn out to be Unencrypted may have been fetched already
+  clearParsedObjectCache();
 
   // "Rewind" the XRef linked list, so that readXRefUntil re-reads all XRef
   // tables/streams, even those that had already been parsed
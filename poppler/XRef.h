@@ -70,6 +70,7 @@ struct XRefEntry {
   enum Flag {
     // Regular flags
     Updated,     // Entry was modified
+    Fetched,     // Entry was fetched already, its object is worth caching
 
     // Special flags -- available only after xref->scanSpecialFlags() is run
     Unencrypted, // Entry is stored in unencrypted form (meaningless in unencrypted documents)
@@ -91,6 +92,11 @@ struct XRefEntry {
   }
 };
 
+// The parsed object cache is split in this many parts, each with its own
+// lock, so that threads fetching different objects don't wait on each
+// other.
+#define parsedObjCacheShards 8
+
 class XRef {
 public:
 
@@ -146,9 +152,20 @@ public:
   // Get catalog object.
   Object getCatalog();
 
-  // Fetch an indirect reference.
+  // Fetch an indirect reference.  Objects that aren't in object streams
+  // are parsed without holding the xref lock when the file stream allows
+  // it, so that several threads can fetch objects at once.
   Object fetch(int num, int gen, int recursion = 0);
 
+  // Keeps at most <maxCost> bytes of decoded object streams, 8 MB by
+  // default.  The objects in object streams are parsed from there.
+  void setObjectStreamCacheCost(size_t maxCost);
+
+  // The number of fetches answered from the cache of parsed objects /
+  // that had to parse the object.
+  unsigned long getNumParsedObjectHits();
+  unsigned long getNumParsedObjectMisses();
+
   // Return the document's Info dictionary (if any).
   Object getDocInfo();
   Object getDocInfoNF();
@@ -189,7 +206,10 @@ public:
   // Was the XRef modified?
   GBool isModified() { return modified; }
   // Set the modification flag for XRef to true.
-  void setModified() { modified = gTrue; }
+  void setModified() { modified = gTrue; ++modificationCount; }
+  // Number of times the XRef was modified, lets callers detect that data
+  // they derived from the document is stale.
+  Guint getModificationCount() { return modificationCount; }
 
   // Write access
   void setModifiedObject(Object* o, Ref r);
@@ -220,10 +240,14 @@ private:
   GBool xrefReconstructed;	// marker, true if xref was already reconstructed
   Object trailerDict;		// trailer dictionary
   GBool modified;
+  Guint modificationCount;	// incremented on every modification
   Goffset *streamEnds;		// 'endstream' positions - only used in
 				//   damaged files
   int streamEndsLen;		// number of valid entries in streamEnds
   PopplerCache *objStrs;	// cached object streams
+  PopplerCache *parsedObjs[parsedObjCacheShards];
+				// cached objects that aren't streams
+				//   nor in object streams, by number
   GBool encrypted;		// true if file is encrypted
   int encRevision;		
   int encVersion;		// encryption algorithm
@@ -251,6 +275,11 @@ private:
   GBool readXRefStream(Stream *xrefStr, Goffset *pos);
   GBool constructXRef(GBool *wasReconstructed, GBool needCatalogDict = gFalse);
   GBool parseEntry(Goffset offset, XRefEntry *entry);
+  Object parseObject(int num, int gen, Goffset offset, Guchar *objFileKey,
+		     int recursion, GBool *ok);
+  PopplerCache *getParsedObjectCache(int num)
+    { return parsedObjs[num % parsedObjCacheShards]; }
+  void clearParsedObjectCache();
   void readXRefUntil(int untilEntryNum, std::vector<int> *xrefStreamObjsNum = NULL);
   void markUnencrypted(Object *obj);
 
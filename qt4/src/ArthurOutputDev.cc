@@ -54,6 +54,7 @@
 #include "Page.h"
 #include "Gfx.h"
 #include "PDFDoc.h"
+#include "DecodedImageCache.h"
 
 #include <QtCore/QtDebug>
 #include <QRawFont>
@@ -1106,8 +1107,10 @@ void ArthurOutputDev::drawImage(GfxState *state, Object *ref, Stream *str,
   QImage image;
   int stride;
   
-  /* TODO: Do we want to cache these? */
-  imgStr = new ImageStream(str, width,
+  Stream *imgDataStr = m_doc->getDecodedImageCache()->getImageStream(xref, ref, str, width, height,
+                                                                      colorMap->getNumPixelComps(),
+                                                                      colorMap->getBits());
+  imgStr = new ImageStream(imgDataStr, width,
                colorMap->getNumPixelComps(),
                colorMap->getBits());
   imgStr->reset();
@@ -1143,6 +1146,8 @@ void ArthurOutputDev::drawImage(GfxState *state, Object *ref, Stream *str,
   // that QRect(0,0,1,1) is exactly the area of the image.
   m_painter.top()->drawImage( QRect(0,0,1,1), image );
   delete imgStr;
+  if (imgDataStr != str)
+    delete imgDataStr;
 
 }
 
@@ -1173,8 +1178,11 @@ void ArthurOutputDev::drawSoftMaskedImage(GfxState *state, Object *ref, Stream *
     return;
   }
 
-  /* TODO: Do we want to cache these? */
-  std::unique_ptr<ImageStream> imgStr(new ImageStream(str, width,
+  Stream *imgDataStr = m_doc->getDecodedImageCache()->getImageStream(xref, ref, str, width, height,
+                                                                      colorMap->getNumPixelComps(),
+                                                                      colorMap->getBits());
+  std::unique_ptr<Stream> cachedDataStr(imgDataStr != str ? imgDataStr : nullptr);
+  std::unique_ptr<ImageStream> imgStr(new ImageStream(imgDataStr, width,
                                                       colorMap->getNumPixelComps(),
                                                       colorMap->getBits()));
   imgStr->reset();
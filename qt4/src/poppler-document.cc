@@ -41,12 +41,20 @@
 #include <DateInfo.h>
 #include <GfxState.h>
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QDebug>
 #include <QtCore/QFile>
 #include <QtCore/QByteArray>
+#include <QtCore/QMutex>
+#include <QtCore/QRunnable>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtGui/QImage>
 
 #include "poppler-private.h"
 #include "poppler-page-private.h"
+#include "poppler-searchindex-private.h"
 
 #if defined(ENABLE_LCMS2)
 #include <lcms2.h>
@@ -695,6 +703,152 @@ namespace Poppler {
         return Document::RenderHints( m_doc->m_hints );
     }
 
+    QList< QPair<int, QRectF> > Document::search(const QString &text, Page::SearchFlags flags) const
+    {
+        QMutexLocker locker(&m_doc->m_searchIndexMutex);
+        if (!m_doc->m_searchIndex || m_doc->m_searchIndex->isStale(m_doc->doc))
+        {
+            delete m_doc->m_searchIndex;
+            m_doc->m_searchIndex = new SearchIndex(m_doc->doc, 0);
+        }
+
+        return m_doc->m_searchIndex->search(text, !flags.testFlag(Page::IgnoreCase), flags.testFlag(Page::WholeWords));
+    }
+
+    void Document::buildSearchIndex(int threadCount) const
+    {
+        SearchIndex *index = new SearchIndex(m_doc->doc, threadCount);
+
+        QMutexLocker locker(&m_doc->m_searchIndexMutex);
+        delete m_doc->m_searchIndex;
+        m_doc->m_searchIndex = index;
+    }
+
+    bool Document::saveSearchIndex(QIODevice *device) const
+    {
+        QMutexLocker locker(&m_doc->m_searchIndexMutex);
+        if (!m_doc->m_searchIndex || m_doc->m_searchIndex->isStale(m_doc->doc))
+        {
+            delete m_doc->m_searchIndex;
+            m_doc->m_searchIndex = new SearchIndex(m_doc->doc, 0);
+        }
+
+        return m_doc->m_searchIndex->save(device);
+    }
+
+    bool Document::loadSearchIndex(QIODevice *device)
+    {
+        SearchIndex *index = SearchIndex::load(m_doc->doc, device);
+        if (!index)
+            return false;
+
+        QMutexLocker locker(&m_doc->m_searchIndexMutex);
+        delete m_doc->m_searchIndex;
+        m_doc->m_searchIndex = index;
+        return true;
+    }
+
+    void Document::clearSearchIndex()
+    {
+        QMutexLocker locker(&m_doc->m_searchIndexMutex);
+        delete m_doc->m_searchIndex;
+        m_doc->m_searchIndex = nullptr;
+    }
+
+    void Document::clearRenderCache()
+    {
+        m_doc->clearRenderContexts();
+    }
+
+    namespace {
+
+    // State shared by the workers of a Document::renderPages() call
+    struct RenderPagesJob
+    {
+        const Document *document;
+        QList<int> pages;
+        double xres;
+        double yres;
+        Page::Rotation rotate;
+        Document::RenderedPageFunc callback;
+        QVariant closure;
+        QAtomicInt nextPage;
+        QMutex callbackMutex;
+    };
+
+    class RenderPagesWorker : public QRunnable
+    {
+    public:
+        explicit RenderPagesWorker(RenderPagesJob *job)
+          : m_job(job)
+        {
+        }
+
+        void run() override
+        {
+            // every worker pulls the next pending page, so the load stays
+            // balanced even if some pages are much slower to render than others
+            forever
+            {
+                const int i = m_job->nextPage.fetchAndAddOrdered(1);
+                if (i >= m_job->pages.count())
+                    return;
+
+                const int index = m_job->pages.at(i);
+                QImage image;
+                QScopedPointer<Page> page(m_job->document->page(index));
+                if (page)
+                    image = page->renderToImage(m_job->xres, m_job->yres, -1, -1, -1, -1, m_job->rotate);
+
+                QMutexLocker locker(&m_job->callbackMutex);
+                (*m_job->callback)(index, image, m_job->closure);
+            }
+        }
+
+    private:
+        RenderPagesJob *m_job;
+    };
+
+    }
+
+    bool Document::renderPages(const QList<int> &pages, double xres, double yres, Page::Rotation rotate,
+                               RenderedPageFunc callback, const QVariant &closure, int threadCount) const
+    {
+        if (m_doc->locked || !callback)
+            return false;
+
+        RenderPagesJob job;
+        job.document = this;
+        job.pages = pages;
+        job.xres = xres;
+        job.yres = yres;
+        job.rotate = rotate;
+        job.callback = callback;
+        job.closure = closure;
+
+        if (threadCount <= 0)
+            threadCount = QThread::idealThreadCount();
+        if (m_doc->m_backend != Document::SplashBackend)
+            threadCount = 1;
+        threadCount = qMin(threadCount, pages.count());
+
+        if (threadCount <= 1)
+        {
+            RenderPagesWorker(&job).run();
+            return true;
+        }
+
+        QThreadPool pool;
+        pool.setMaxThreadCount(threadCount);
+        for (int i = 0; i < threadCount; ++i)
+        {
+            pool.start(new RenderPagesWorker(&job));
+        }
+        pool.waitForDone();
+
+        return true;
+    }
+
     PSConverter *Document::psConverter() const
     {
         return new PSConverter(m_doc);
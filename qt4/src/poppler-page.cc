@@ -39,6 +39,7 @@
 
 #include <QtCore/QHash>
 #include <QtCore/QMap>
+#include <QtCore/QMutexLocker>
 #include <QtCore/QVarLengthArray>
 #include <QtGui/QImage>
 #include <QtGui/QPainter>
@@ -252,13 +253,7 @@ inline TextPage *PageData::prepareTextSearch(const QString &text, Page::Rotation
 
   const int rotation = (int)rotate * 90;
 
-  // fetch ourselves a textpage
-  TextOutputDev td(nullptr, gTrue, 0, gFalse, gFalse);
-  parentDoc->doc->displayPage( &td, index + 1, 72, 72, rotation, false, true, false,
-    nullptr, nullptr, nullptr, nullptr, gTrue);
-  TextPage *textPage=td.takeText();
-  
-  return textPage;
+  return parentDoc->textPage(index, rotation, false, true);
 }
 
 inline GBool PageData::performSingleTextSearch(TextPage* textPage, QVector<Unicode> &u, double &sLeft, double &sTop, double &sRight, double &sBottom, Page::SearchDirection direction, GBool sCase, GBool sWords)
@@ -268,10 +263,10 @@ inline GBool PageData::performSingleTextSearch(TextPage* textPage, QVector<Unico
            gTrue, gTrue, gFalse, gFalse, sCase, gFalse, sWords, &sLeft, &sTop, &sRight, &sBottom );
   else if ( direction == Page::NextResult )
     return textPage->findText( u.data(), u.size(),
-           gFalse, gTrue, gTrue, gFalse, sCase, gFalse, sWords, &sLeft, &sTop, &sRight, &sBottom );
+           gFalse, gTrue, gFalse, gFalse, sCase, gFalse, sWords, &sLeft, &sTop, &sRight, &sBottom );
   else if ( direction == Page::PreviousResult )
     return textPage->findText( u.data(), u.size(),
-           gFalse, gTrue, gTrue, gFalse, sCase, gTrue, sWords, &sLeft, &sTop, &sRight, &sBottom );
+           gFalse, gTrue, gFalse, gFalse, sCase, gTrue, sWords, &sLeft, &sTop, &sRight, &sBottom );
 
   return gFalse;
 }
@@ -280,10 +275,14 @@ inline QList<QRectF> PageData::performMultipleTextSearch(TextPage* textPage, QVe
 {
   QList<QRectF> results;
   double sLeft = 0.0, sTop = 0.0, sRight = 0.0, sBottom = 0.0;
+  // the shared page may remember the last find of an earlier search, so
+  // only continue from the last result once this search found one
+  GBool startAtLast = gFalse;
 
   while(textPage->findText( u.data(), u.size(),
-        gFalse, gTrue, gTrue, gFalse, sCase, gFalse, sWords, &sLeft, &sTop, &sRight, &sBottom ))
+        gFalse, gTrue, startAtLast, gFalse, sCase, gFalse, sWords, &sLeft, &sTop, &sRight, &sBottom ))
   {
+      startAtLast = gTrue;
       QRectF result;
 
       result.setLeft(sLeft);
@@ -320,11 +319,10 @@ QImage Page::renderToImage(double xres, double yres, int x, int y, int w, int h,
     case Poppler::Document::SplashBackend:
     {
 #if defined(HAVE_SPLASH)
-      SplashColor bgColor;
-      GBool overprintPreview = gFalse;
+      SplashRenderKey key;
 #ifdef SPLASH_CMYK
-      overprintPreview = m_page->parentDoc->m_hints & Document::OverprintPreview ? gTrue : gFalse;
-      if (overprintPreview)
+      key.overprintPreview = m_page->parentDoc->m_hints & Document::OverprintPreview;
+      if (key.overprintPreview)
       {
         Guchar c, m, y, k;
 
@@ -338,53 +336,51 @@ QImage Page::renderToImage(double xres, double yres, int x, int y, int w, int h,
         if (y < k) {
           k = y;
         }
-        bgColor[0] = c - k;
-        bgColor[1] = m - k;
-        bgColor[2] = y - k;
-        bgColor[3] = k;
+        key.paperColor[0] = c - k;
+        key.paperColor[1] = m - k;
+        key.paperColor[2] = y - k;
+        key.paperColor[3] = k;
         for (int i = 4; i < SPOT_NCOMPS + 4; i++) {
-          bgColor[i] = 0;
+          key.paperColor[i] = 0;
         }
       }
       else
 #endif
       {
-        bgColor[0] = m_page->parentDoc->paperColor.blue();
-        bgColor[1] = m_page->parentDoc->paperColor.green();
-        bgColor[2] = m_page->parentDoc->paperColor.red();
+        key.paperColor[0] = m_page->parentDoc->paperColor.blue();
+        key.paperColor[1] = m_page->parentDoc->paperColor.green();
+        key.paperColor[2] = m_page->parentDoc->paperColor.red();
       }
 
-      SplashColorMode colorMode = splashModeXBGR8;
+      key.colorMode = splashModeXBGR8;
 #ifdef SPLASH_CMYK
-      if (overprintPreview) colorMode = splashModeDeviceN8;
+      if (key.overprintPreview) key.colorMode = splashModeDeviceN8;
 #endif
  
-      SplashThinLineMode thinLineMode = splashThinLineDefault;
-      if (m_page->parentDoc->m_hints & Document::ThinLineShape) thinLineMode = splashThinLineShape;
-      if (m_page->parentDoc->m_hints & Document::ThinLineSolid) thinLineMode = splashThinLineSolid;
+      key.thinLineMode = splashThinLineDefault;
+      if (m_page->parentDoc->m_hints & Document::ThinLineShape) key.thinLineMode = splashThinLineShape;
+      if (m_page->parentDoc->m_hints & Document::ThinLineSolid) key.thinLineMode = splashThinLineSolid;
 
       const bool ignorePaperColor = m_page->parentDoc->m_hints & Document::IgnorePaperColor;
+      key.ignorePaperColor = ignorePaperColor;
+      key.fontAntialias = m_page->parentDoc->m_hints & Document::TextAntialiasing;
+      key.freeTypeHinting = m_page->parentDoc->m_hints & Document::TextHinting;
+      key.slightHinting = m_page->parentDoc->m_hints & Document::TextSlightHinting;
 
-      SplashOutputDev splash_output(
-                  colorMode, 4,
-                  gFalse,
-                  ignorePaperColor ? nullptr : bgColor,
-                  gTrue,
-                  thinLineMode,
-                  overprintPreview);
-
-      splash_output.setFontAntialias(m_page->parentDoc->m_hints & Document::TextAntialiasing ? gTrue : gFalse);
-      splash_output.setVectorAntialias(m_page->parentDoc->m_hints & Document::Antialiasing ? gTrue : gFalse);
-      splash_output.setFreeTypeHinting(m_page->parentDoc->m_hints & Document::TextHinting ? gTrue : gFalse,
-                                        m_page->parentDoc->m_hints & Document::TextSlightHinting ? gTrue : gFalse);
+      // Reuse an already started output device so the font engine and the
+      // glyph caches survive between renders of this document
+      SplashRenderContext context = m_page->parentDoc->takeRenderContext(key);
+      SplashOutputDev *splash_output = context.outputDev;
 
-      splash_output.startDoc(m_page->parentDoc->doc);
+      splash_output->setVectorAntialias(m_page->parentDoc->m_hints & Document::Antialiasing ? gTrue : gFalse);
 
-      m_page->parentDoc->doc->displayPageSlice(&splash_output, m_page->index + 1, xres, yres,
+      m_page->parentDoc->doc->displayPageSlice(splash_output, m_page->index + 1, xres, yres,
                                                rotation, false, true, false, x, y, w, h,
                                                NULL, NULL, NULL, NULL, gTrue);
 
-      SplashBitmap *b = splash_output.getBitmap();
+      // Take the bitmap so the idle output device doesn't keep the page memory alive
+      SplashBitmap *b = splash_output->takeBitmap();
+      m_page->parentDoc->releaseRenderContext(context);
 
       const int bw = b->getWidth();
       const int bh = b->getHeight();
@@ -418,6 +414,7 @@ QImage Page::renderToImage(double xres, double yres, int x, int y, int w, int h,
           // Construct a Qt image sharing the raw bitmap data.
           img = QImage(data, bw, bh, brs, format).copy();
       }
+      delete b;
 #endif
       break;
     }
@@ -498,29 +495,25 @@ QImage Page::thumbnail() const
 
 QString Page::text(const QRectF &r, TextLayout textLayout) const
 {
-  TextOutputDev *output_dev;
   GooString *s;
   PDFRectangle *rect;
   QString result;
   
-  const GBool rawOrder = textLayout == RawOrderLayout;
-  output_dev = new TextOutputDev(nullptr, gFalse, 0, rawOrder, gFalse);
-  m_page->parentDoc->doc->displayPageSlice(output_dev, m_page->index + 1, 72, 72,
-      0, false, true, false, -1, -1, -1, -1,
-      nullptr, nullptr, nullptr, nullptr, gTrue);
+  const bool rawOrder = textLayout == RawOrderLayout;
+  TextPage *textPage = m_page->parentDoc->textPage(m_page->index, 0, rawOrder, true);
   if (r.isNull())
   {
     rect = m_page->page->getCropBox();
-    s = output_dev->getText(rect->x1, rect->y1, rect->x2, rect->y2);
+    s = textPage->getText(rect->x1, rect->y1, rect->x2, rect->y2);
   }
   else
   {
-    s = output_dev->getText(r.left(), r.top(), r.right(), r.bottom());
+    s = textPage->getText(r.left(), r.top(), r.right(), r.bottom());
   }
 
   result = QString::fromUtf8(s->getCString());
 
-  delete output_dev;
+  m_page->parentDoc->releaseTextPage(textPage);
   delete s;
   return result;
 }
@@ -538,9 +531,13 @@ bool Page::search(const QString &text, double &sLeft, double &sTop, double &sRig
   QVector<Unicode> u;
   TextPage *textPage = m_page->prepareTextSearch(text, rotate, &u);
 
-  const bool found = m_page->performSingleTextSearch(textPage, u, sLeft, sTop, sRight, sBottom, direction, sCase, sWords);
+  bool found;
+  {
+    QMutexLocker locker(&m_page->parentDoc->m_textSearchMutex);
+    found = m_page->performSingleTextSearch(textPage, u, sLeft, sTop, sRight, sBottom, direction, sCase, sWords);
+  }
 
-  textPage->decRefCnt();
+  m_page->parentDoc->releaseTextPage(textPage);
 
   return found;
 }
@@ -553,31 +550,28 @@ QList<QRectF> Page::search(const QString &text, SearchFlags flags, Rotation rota
   QVector<Unicode> u;
   TextPage *textPage = m_page->prepareTextSearch(text, rotate, &u);
 
-  const QList<QRectF> results = m_page->performMultipleTextSearch(textPage, u, sCase, sWords);
+  QList<QRectF> results;
+  {
+    QMutexLocker locker(&m_page->parentDoc->m_textSearchMutex);
+    results = m_page->performMultipleTextSearch(textPage, u, sCase, sWords);
+  }
 
-  textPage->decRefCnt();
+  m_page->parentDoc->releaseTextPage(textPage);
 
   return results;
 }
 
 QList<TextBox*> Page::textList(Rotation rotate) const
 {
-  TextOutputDev *output_dev;
-  
   QList<TextBox*> output_list;
   
-  output_dev = new TextOutputDev(nullptr, gFalse, 0, gFalse, gFalse);
-  
   int rotation = (int)rotate * 90;
 
-  m_page->parentDoc->doc->displayPageSlice(output_dev, m_page->index + 1, 72, 72,
-      rotation, false, false, false, -1, -1, -1, -1,
-      nullptr, nullptr, nullptr, nullptr, gTrue);
-
-  TextWordList *word_list = output_dev->makeWordList();
+  TextPage *textPage = m_page->parentDoc->textPage(m_page->index, rotation, false, false);
+  TextWordList *word_list = textPage->makeWordList(gFalse);
   
   if (!word_list) {
-    delete output_dev;
+    m_page->parentDoc->releaseTextPage(textPage);
     return output_list;
   }
   
@@ -613,7 +607,7 @@ QList<TextBox*> Page::textList(Rotation rotate) const
   }
   
   delete word_list;
-  delete output_dev;
+  m_page->parentDoc->releaseTextPage(textPage);
   
   return output_list;
 }
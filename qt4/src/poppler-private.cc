@@ -26,14 +26,20 @@
  */
 
 #include "poppler-private.h"
+#include "poppler-searchindex-private.h"
+
+#include <string.h>
 
 #include <QtCore/QByteArray>
 #include <QtCore/QDebug>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QThread>
 #include <QtCore/QVariant>
 
 #include <Link.h>
 #include <Outline.h>
 #include <PDFDocEncoding.h>
+#include <TextOutputDev.h>
 #include <UnicodeMap.h>
 
 namespace Poppler {
@@ -230,6 +236,9 @@ namespace Debug {
     
     DocumentData::~DocumentData()
     {
+        clearRenderContexts();
+        clearTextPages();
+        delete m_searchIndex;
         qDeleteAll(m_embeddedFiles);
         delete (OptContentModel *)m_optContentModel;
         delete doc;
@@ -250,6 +259,8 @@ namespace Debug {
         paperColor = Qt::white;
         m_hints = 0;
         m_optContentModel = nullptr;
+        m_textPagesCost = 0;
+        m_searchIndex = nullptr;
       
         if ( count == 0 )
         {
@@ -260,6 +271,201 @@ namespace Debug {
         count ++;
     }
 
+#if defined(HAVE_SPLASH)
+    // How many started output devices are kept around once nobody is using them;
+    // enough for one renderer per core or for switching between render hints
+    static int maxIdleRenderContexts()
+    {
+        return qMax(4, QThread::idealThreadCount());
+    }
+
+    SplashRenderKey::SplashRenderKey()
+      : colorMode(splashModeXBGR8), ignorePaperColor(false), thinLineMode(splashThinLineDefault),
+        overprintPreview(false), fontAntialias(false), freeTypeHinting(false), slightHinting(false)
+    {
+        splashClearColor(paperColor);
+    }
+
+    bool SplashRenderKey::operator==(const SplashRenderKey &other) const
+    {
+        if (colorMode != other.colorMode || ignorePaperColor != other.ignorePaperColor ||
+            thinLineMode != other.thinLineMode || overprintPreview != other.overprintPreview ||
+            fontAntialias != other.fontAntialias || freeTypeHinting != other.freeTypeHinting ||
+            slightHinting != other.slightHinting)
+            return false;
+
+        return ignorePaperColor || memcmp(paperColor, other.paperColor, sizeof(SplashColor)) == 0;
+    }
+
+    SplashRenderContext DocumentData::takeRenderContext(const SplashRenderKey &key)
+    {
+        {
+            QMutexLocker locker(&m_renderContextsMutex);
+            for (int i = m_idleRenderContexts.count() - 1; i >= 0; --i)
+            {
+                if (m_idleRenderContexts.at(i).key == key)
+                    return m_idleRenderContexts.takeAt(i);
+            }
+        }
+
+        // Construct and start the output device outside of the lock, it's the expensive part
+        SplashRenderContext context;
+        context.key = key;
+        context.outputDev = new SplashOutputDev(key.colorMode, 4, gFalse,
+                                                key.ignorePaperColor ? nullptr : const_cast<Guchar *>(key.paperColor),
+                                                gTrue, key.thinLineMode,
+                                                key.overprintPreview ? gTrue : gFalse);
+        context.outputDev->setFontAntialias(key.fontAntialias ? gTrue : gFalse);
+        context.outputDev->setFreeTypeHinting(key.freeTypeHinting ? gTrue : gFalse,
+                                              key.slightHinting ? gTrue : gFalse);
+        context.outputDev->startDoc(doc);
+        return context;
+    }
+
+    void DocumentData::releaseRenderContext(const SplashRenderContext &context)
+    {
+        SplashOutputDev *evicted = nullptr;
+        {
+            QMutexLocker locker(&m_renderContextsMutex);
+            // most recently used contexts live at the end of the list
+            m_idleRenderContexts.append(context);
+            if (m_idleRenderContexts.count() > maxIdleRenderContexts())
+                evicted = m_idleRenderContexts.takeFirst().outputDev;
+        }
+        delete evicted;
+    }
+#endif
+
+    void DocumentData::clearRenderContexts()
+    {
+#if defined(HAVE_SPLASH)
+        QList<SplashRenderContext> contexts;
+        {
+            QMutexLocker locker(&m_renderContextsMutex);
+            contexts = m_idleRenderContexts;
+            m_idleRenderContexts.clear();
+        }
+        foreach(const SplashRenderContext &context, contexts)
+            delete context.outputDev;
+#endif
+    }
+
+
+    // Upper bound for the estimated memory used by the cached text pages
+    static const int maxTextPagesCost = 32 * 1024 * 1024;
+
+    // Rough estimate of the memory used by a TextPage, a TextWord keeps
+    // several coordinates and a font pointer for every character
+    static int textPageCost(TextPage *textPage)
+    {
+        int nWords = 0;
+        int nChars = 0;
+        if (textPage->getFlows()) {
+            for (TextFlow *flow = textPage->getFlows(); flow; flow = flow->getNext()) {
+                for (TextBlock *block = flow->getBlocks(); block; block = block->getNext()) {
+                    for (TextLine *line = block->getLines(); line; line = line->getNext()) {
+                        for (TextWord *word = line->getWords(); word; word = word->getNext()) {
+                            ++nWords;
+                            nChars += word->getLength();
+                        }
+                    }
+                }
+            }
+        } else {
+            // raw order pages keep no flows
+            TextWordList *wordList = textPage->makeWordList(gFalse);
+            nWords = wordList->getLength();
+            for (int i = 0; i < nWords; ++i)
+                nChars += wordList->get(i)->getLength();
+            delete wordList;
+        }
+        return 1024 + nWords * 128 + nChars * 96;
+    }
+
+    TextPage *DocumentData::textPage(int index, int rotation, bool rawOrder, bool crop)
+    {
+        const Guint modificationCount = doc->getXRef()->getModificationCount();
+
+        {
+            QMutexLocker locker(&m_textPagesMutex);
+            for (int i = 0; i < m_textPages.count(); ++i)
+            {
+                const CachedTextPage &cached = m_textPages.at(i);
+                if (cached.index == index && cached.rotation == rotation &&
+                    cached.rawOrder == rawOrder && cached.crop == crop)
+                {
+                    if (cached.modificationCount != modificationCount)
+                    {
+                        // annotations or forms changed since the text was extracted
+                        m_textPagesCost -= cached.cost;
+                        cached.textPage->decRefCnt();
+                        m_textPages.removeAt(i);
+                        break;
+                    }
+                    // most recently used pages live at the end of the list
+                    CachedTextPage hit = m_textPages.takeAt(i);
+                    m_textPages.append(hit);
+                    hit.textPage->incRefCnt();
+                    return hit.textPage;
+                }
+            }
+        }
+
+        // Do the extraction outside of the lock, it's the expensive part
+        TextOutputDev td(nullptr, gFalse, 0, rawOrder ? gTrue : gFalse, gFalse);
+        doc->displayPageSlice(&td, index + 1, 72, 72, rotation, false, crop, false,
+                              -1, -1, -1, -1, nullptr, nullptr, nullptr, nullptr, gTrue);
+        TextPage *textPage = td.takeText();
+
+        CachedTextPage entry;
+        entry.index = index;
+        entry.rotation = rotation;
+        entry.rawOrder = rawOrder;
+        entry.crop = crop;
+        entry.modificationCount = modificationCount;
+        entry.cost = textPageCost(textPage);
+        entry.textPage = textPage;
+        if (entry.cost > maxTextPagesCost)
+            return textPage;
+
+        QMutexLocker locker(&m_textPagesMutex);
+        for (int i = 0; i < m_textPages.count(); ++i)
+        {
+            const CachedTextPage &cached = m_textPages.at(i);
+            if (cached.index == index && cached.rotation == rotation &&
+                cached.rawOrder == rawOrder && cached.crop == crop)
+            {
+                // another thread extracted the same page meanwhile
+                return textPage;
+            }
+        }
+        // one reference for the cache, one for the caller
+        textPage->incRefCnt();
+        m_textPages.append(entry);
+        m_textPagesCost += entry.cost;
+        while (m_textPagesCost > maxTextPagesCost)
+        {
+            const CachedTextPage evicted = m_textPages.takeFirst();
+            m_textPagesCost -= evicted.cost;
+            evicted.textPage->decRefCnt();
+        }
+        return textPage;
+    }
+
+    void DocumentData::releaseTextPage(TextPage *textPage)
+    {
+        QMutexLocker locker(&m_textPagesMutex);
+        textPage->decRefCnt();
+    }
+
+    void DocumentData::clearTextPages()
+    {
+        QMutexLocker locker(&m_textPagesMutex);
+        foreach(const CachedTextPage &cached, m_textPages)
+            cached.textPage->decRefCnt();
+        m_textPages.clear();
+        m_textPagesCost = 0;
+    }
 
     void DocumentData::addTocChildren( QDomDocument * docSyn, QDomNode * parent, const GooList * items )
     {
@@ -32,6 +32,8 @@
 #define _POPPLER_PRIVATE_H_
 
 #include <QtCore/QFile>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
 #include <QtCore/QPointer>
 #include <QtCore/QVector>
 
@@ -51,6 +53,7 @@
 
 class LinkDest;
 class FormWidget;
+class TextPage;
 
 namespace Poppler {
 
@@ -81,6 +84,55 @@ namespace Poppler {
             bool externalDest;
     };
 
+#if defined(HAVE_SPLASH)
+    /*
+     The SplashOutputDev parameters that can't be changed once the output
+     device has been constructed and startDoc() has been called on it.
+     */
+    struct SplashRenderKey
+    {
+	SplashRenderKey();
+
+	bool operator==(const SplashRenderKey &other) const;
+
+	SplashColorMode colorMode;
+	SplashColor paperColor;
+	bool ignorePaperColor;
+	SplashThinLineMode thinLineMode;
+	bool overprintPreview;
+	bool fontAntialias;
+	bool freeTypeHinting;
+	bool slightHinting;
+    };
+
+    /*
+     A started SplashOutputDev, keeping its font engine, glyph caches and
+     Type 3 caches alive between renders of pages of the same document.
+     */
+    struct SplashRenderContext
+    {
+	SplashRenderKey key;
+	SplashOutputDev *outputDev;
+    };
+#endif
+
+    class SearchIndex;
+
+    /*
+     The text extracted from a page, shared by the text and search
+     functions of all the Page objects of the document.
+     */
+    struct CachedTextPage
+    {
+	int index;
+	int rotation;
+	bool rawOrder;
+	bool crop;
+	Guint modificationCount;
+	int cost;
+	TextPage *textPage;
+    };
+
     class DocumentData {
     public:
 	DocumentData(const QString &filePath, GooString *ownerPassword, GooString *userPassword)
@@ -141,6 +193,28 @@ namespace Poppler {
 	
 	static Document *checkDocument(DocumentData *doc);
 
+#if defined(HAVE_SPLASH)
+	/*
+	 Returns an idle render context matching \p key, or a newly started
+	 one if there is none. The caller has exclusive use of it until it is
+	 given back with releaseRenderContext().
+	 */
+	SplashRenderContext takeRenderContext(const SplashRenderKey &key);
+	void releaseRenderContext(const SplashRenderContext &context);
+#endif
+	void clearRenderContexts();
+
+	/*
+	 Returns the text of page \p index as TextOutputDev extracts it with
+	 the given rotation, reading order and cropping, reusing a previous
+	 extraction if the document hasn't been modified since. The caller
+	 owns a reference to the returned page, which must be given back with
+	 releaseTextPage().
+	 */
+	TextPage *textPage(int index, int rotation, bool rawOrder, bool crop);
+	void releaseTextPage(TextPage *textPage);
+	void clearTextPages();
+
 	PDFDoc *doc;
 	QString m_filePath;
 	QByteArray fileContents;
@@ -151,6 +225,18 @@ namespace Poppler {
 	QPointer<OptContentModel> m_optContentModel;
 	QColor paperColor;
 	int m_hints;
+#if defined(HAVE_SPLASH)
+	QMutex m_renderContextsMutex;
+	QList<SplashRenderContext> m_idleRenderContexts;
+#endif
+	// guards the cached text pages and their (non atomic) reference counts
+	QMutex m_textPagesMutex;
+	QList<CachedTextPage> m_textPages;
+	int m_textPagesCost;
+	// TextPage::findText keeps state in the page, so searches are serialized
+	QMutex m_textSearchMutex;
+	QMutex m_searchIndexMutex;
+	SearchIndex *m_searchIndex;
 	static int count;
     };
 
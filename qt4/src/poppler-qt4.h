@@ -41,6 +41,7 @@
 
 #include <QtCore/QByteArray>
 #include <QtCore/QDateTime>
+#include <QtCore/QPair>
 #include <QtCore/QSet>
 #include <QtXml/QDomDocument>
 #include "poppler-export.h"
@@ -1409,6 +1410,126 @@ QString subject = m_doc->info("Subject");
 	  \since 0.6
 	 */
 	RenderHints renderHints() const;
+
+	/**
+	   Searches for the given text in the whole document.
+
+	   The first search extracts the text of all the pages, the same way
+	   Page::search() does, and keeps it in an index, so later searches
+	   don't need to process the pages again. The index is rebuilt if the
+	   document changes, e.g. when annotations or forms are edited. Call
+	   buildSearchIndex() beforehand to control how the text is
+	   extracted.
+
+	   \param text the text to search for
+	   \param flags the search flags; the pages are searched without
+	   rotation
+
+	   \returns the index of the page and the bounding rectangle, in
+	   points, of every match, ordered by page and then in reading order
+
+	   \since 0.64
+	*/
+	QList< QPair<int, QRectF> > search(const QString &text, Page::SearchFlags flags = Page::NoSearchFlags) const;
+
+	/**
+	   Extracts the text of all the pages for search(), replacing any
+	   previous index.
+
+	   \param threadCount the number of threads extracting pages in
+	   parallel, or 0 to use one per processor core
+
+	   \since 0.64
+	*/
+	void buildSearchIndex(int threadCount = 0) const;
+
+	/**
+	   Writes the search index to \p device, building it first if needed,
+	   so that it can be restored with loadSearchIndex() when the document
+	   is opened again.
+
+	   \returns whether the index could be written
+
+	   \since 0.64
+	*/
+	bool saveSearchIndex(QIODevice *device) const;
+
+	/**
+	   Restores a search index written by saveSearchIndex().
+
+	   \returns whether \p device contained a valid index for this
+	   document; if not, the current index is kept
+
+	   \since 0.64
+	*/
+	bool loadSearchIndex(QIODevice *device);
+
+	/**
+	   Frees the search index of the document.
+
+	   \since 0.64
+	*/
+	void clearSearchIndex();
+
+	/**
+	  Frees the cached rendering state of the document.
+
+	  To speed up rendering several pages of the same document, the
+	  Splash backend keeps the output devices it used, together with
+	  their loaded fonts and glyph caches, for later calls to
+	  Page::renderToImage(). This releases all the ones that are not
+	  currently in use, e.g. to reduce memory usage after a batch of
+	  renders.
+
+	  \since 0.64
+	 */
+	void clearRenderCache();
+
+	/**
+	   Callback used by renderPages() to hand over each rendered page.
+
+	   \param index the index of the page, as passed to renderPages()
+	   \param image the rendered page, a null image if rendering failed
+	   \param closure the closure passed to renderPages()
+
+	   \since 0.64
+	*/
+	typedef void (*RenderedPageFunc)(int /*index*/, const QImage & /*image*/, const QVariant & /*closure*/);
+
+	/**
+	   Renders several pages of the document concurrently.
+
+	   The pages are distributed over \p threadCount worker threads, each
+	   one rendering with its own output device while sharing the parsed
+	   document. \p callback is called for every page as soon as it has
+	   been rendered, so the pages are not necessarily delivered in the
+	   order of \p pages. The calls happen on the worker threads, but
+	   never concurrently, so the callback does not need to be reentrant.
+
+	   This function returns once all the pages have been rendered.
+
+	   \note Only the Splash backend renders in parallel, with the Arthur
+	   backend the pages are rendered one after the other on the calling
+	   thread.
+
+	   \param pages the indexes of the pages to render
+	   \param xres horizontal resolution of the graphics device,
+	   in dots per inch
+	   \param yres vertical resolution of the graphics device, in
+	   dots per inch
+	   \param rotate how to rotate the pages
+	   \param callback the function to call for every rendered page
+	   \param closure user data passed to \p callback
+	   \param threadCount the number of worker threads, or 0 to use
+	   one per processor core
+
+	   \returns whether the pages could be rendered, i.e. false if the
+	   document is locked or \p callback is null
+
+	   \since 0.64
+	*/
+	bool renderPages(const QList<int> &pages, double xres, double yres, Page::Rotation rotate,
+			 RenderedPageFunc callback, const QVariant &closure, int threadCount = 0) const;
 	
 	/**
 	  Gets a new PS converter for this document.
@@ -0,0 +1,85 @@
+/* poppler-searchindex-private.h: Qt4 interface to poppler
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef POPPLER_SEARCHINDEX_PRIVATE_H
+#define POPPLER_SEARCHINDEX_PRIVATE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QPair>
+#include <QtCore/QRectF>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include "CharTypes.h"
+#include "goo/gtypes.h"
+
+class QIODevice;
+class PDFDoc;
+
+namespace Poppler
+{
+
+/*
+ The text of a whole document, extracted once, in a form that can be
+ searched without running the content streams again.
+
+ For every page the NFKC normalized text is kept in reading order, with
+ words of a line separated by a space and lines separated by a newline,
+ together with the bounding box of every character.
+ */
+class SearchIndex
+{
+public:
+	SearchIndex(PDFDoc *doc, int threadCount);
+
+	SearchIndex(const SearchIndex &) = delete;
+	SearchIndex& operator=(const SearchIndex &) = delete;
+
+	// Reads an index written by save(), returns NULL if it is invalid or
+	// was not made for \p doc
+	static SearchIndex *load(PDFDoc *doc, QIODevice *device);
+	bool save(QIODevice *device) const;
+
+	// Whether the document was modified after the text was extracted
+	bool isStale(PDFDoc *doc) const;
+
+	QList< QPair<int, QRectF> > search(const QString &text, bool caseSensitive, bool wholeWords) const;
+
+private:
+	struct PageText
+	{
+		QVector<Unicode> text;
+		// xMin, yMin, xMax, yMax of every character, empty for separators
+		QVector<float> boxes;
+	};
+
+	SearchIndex();
+
+	friend class SearchIndexWorker;
+
+	static void extractPage(PDFDoc *doc, int index, PageText *pageText);
+
+	QVector<PageText> m_pages;
+	QByteArray m_permanentId;
+	QByteArray m_updateId;
+	Guint m_modificationCount;
+};
+
+}
+
+#endif
@@ -0,0 +1,292 @@
+/* poppler-searchindex.cc: Qt4 interface to poppler
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "poppler-searchindex-private.h"
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QDataStream>
+#include <QtCore/QIODevice>
+#include <QtCore/QRunnable>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+
+#include <string.h>
+
+#include "goo/gmem.h"
+#include <PDFDoc.h>
+#include <TextOutputDev.h>
+#include <UnicodeTypeTable.h>
+#include <XRef.h>
+
+namespace Poppler {
+
+static const quint32 searchIndexMagic = 0x50505849; // "PPXI"
+static const quint32 searchIndexVersion = 1;
+
+static void getDocumentIds(PDFDoc *doc, QByteArray *permanentId, QByteArray *updateId)
+{
+    GooString gooPermanentId;
+    GooString gooUpdateId;
+
+    if (doc->getID(&gooPermanentId, &gooUpdateId)) {
+        *permanentId = QByteArray(gooPermanentId.getCString(), gooPermanentId.getLength());
+        *updateId = QByteArray(gooUpdateId.getCString(), gooUpdateId.getLength());
+    }
+}
+
+static QVector<Unicode> normalize(const QString &text)
+{
+    QVector<uint> ucs4 = text.toUcs4();
+    QVector<Unicode> result;
+    if (ucs4.isEmpty())
+        return result;
+
+    int len;
+    Unicode *normalized = unicodeNormalizeNFKC(ucs4.data(), ucs4.count(), &len, nullptr);
+    result.resize(len);
+    for (int i = 0; i < len; ++i)
+        result[i] = normalized[i];
+    gfree(normalized);
+    return result;
+}
+
+// Pulls pages to extract until there are none left, see SearchIndex constructor
+class SearchIndexWorker : public QRunnable
+{
+public:
+    SearchIndexWorker(PDFDoc *doc, SearchIndex::PageText *pages, int nPages, QAtomicInt *nextPage)
+      : m_doc(doc), m_pages(pages), m_nPages(nPages), m_nextPage(nextPage)
+    {
+    }
+
+    void run() override
+    {
+        forever
+        {
+            const int index = m_nextPage->fetchAndAddOrdered(1);
+            if (index >= m_nPages)
+                return;
+            SearchIndex::extractPage(m_doc, index, &m_pages[index]);
+        }
+    }
+
+private:
+    PDFDoc *m_doc;
+    SearchIndex::PageText *m_pages;
+    int m_nPages;
+    QAtomicInt *m_nextPage;
+};
+
+SearchIndex::SearchIndex()
+  : m_modificationCount(0)
+{
+}
+
+SearchIndex::SearchIndex(PDFDoc *doc, int threadCount)
+{
+    m_modificationCount = doc->getXRef()->getModificationCount();
+    getDocumentIds(doc, &m_permanentId, &m_updateId);
+
+    const int nPages = doc->getNumPages();
+    m_pages.resize(nPages);
+    // workers write to their own pages only, don't let QVector detach under them
+    PageText *pages = m_pages.data();
+
+    if (threadCount <= 0)
+        threadCount = QThread::idealThreadCount();
+    threadCount = qMin(threadCount, nPages);
+
+    QAtomicInt nextPage;
+    if (threadCount <= 1) {
+        SearchIndexWorker(doc, pages, nPages, &nextPage).run();
+        return;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount);
+    for (int i = 0; i < threadCount; ++i)
+        pool.start(new SearchIndexWorker(doc, pages, nPages, &nextPage));
+    pool.waitForDone();
+}
+
+void SearchIndex::extractPage(PDFDoc *doc, int index, PageText *pageText)
+{
+    // same extraction as Page::search() does
+    TextOutputDev td(nullptr, gFalse, 0, gFalse, gFalse);
+    doc->displayPageSlice(&td, index + 1, 72, 72, 0, false, true, false,
+                          -1, -1, -1, -1, nullptr, nullptr, nullptr, nullptr, gTrue);
+    TextWordList *wordList = td.makeWordList();
+    if (!wordList)
+        return;
+
+    const int nWords = wordList->getLength();
+    for (int i = 0; i < nWords; ++i) {
+        TextWord *word = wordList->get(i);
+        const int len = word->getLength();
+        if (len > 0) {
+            int normalizedLen;
+            int *offsets;
+            Unicode *normalized = unicodeNormalizeNFKC(const_cast<Unicode *>(word->getChar(0)), len,
+                                                       &normalizedLen, &offsets);
+            for (int j = 0; j < normalizedLen; ++j) {
+                double xMin, yMin, xMax, yMax;
+                word->getCharBBox(qMin(offsets[j], len - 1), &xMin, &yMin, &xMax, &yMax);
+                pageText->text.append(normalized[j]);
+                pageText->boxes << xMin << yMin << xMax << yMax;
+            }
+            gfree(normalized);
+            gfree(offsets);
+        }
+
+        // words of a line are linked together, other words start a new line
+        if (i + 1 < nWords) {
+            const Unicode separator = word->nextWord() == wordList->get(i + 1) ? ' ' : '\n';
+            if (separator == '\n' || word->hasSpaceAfter()) {
+                pageText->text.append(separator);
+                pageText->boxes << 1 << 1 << 0 << 0;
+            }
+        }
+    }
+    pageText->text.squeeze();
+    pageText->boxes.squeeze();
+
+    delete wordList;
+}
+
+bool SearchIndex::isStale(PDFDoc *doc) const
+{
+    return doc->getXRef()->getModificationCount() != m_modificationCount;
+}
+
+QList< QPair<int, QRectF> > SearchIndex::search(const QString &text, bool caseSensitive, bool wholeWords) const
+{
+    QList< QPair<int, QRectF> > results;
+
+    QVector<Unicode> s = normalize(text);
+    const int len = s.count();
+    if (len == 0)
+        return results;
+    if (!caseSensitive) {
+        for (int i = 0; i < len; ++i)
+            s[i] = unicodeToUpper(s[i]);
+    }
+
+    QVector<Unicode> folded;
+    for (int page = 0; page < m_pages.count(); ++page) {
+        const PageText &pageText = m_pages.at(page);
+        const Unicode *txt = pageText.text.constData();
+        const int n = pageText.text.count();
+        if (!caseSensitive) {
+            folded.resize(n);
+            for (int i = 0; i < n; ++i)
+                folded[i] = unicodeToUpper(txt[i]);
+            txt = folded.constData();
+        }
+
+        int i = 0;
+        while (i <= n - len) {
+            if (txt[i] != s[0] || memcmp(txt + i + 1, s.constData() + 1, (len - 1) * sizeof(Unicode)) != 0) {
+                ++i;
+                continue;
+            }
+            if (wholeWords &&
+                ((i > 0 && unicodeTypeAlphaNum(txt[i - 1])) ||
+                 (i + len < n && unicodeTypeAlphaNum(txt[i + len])))) {
+                ++i;
+                continue;
+            }
+
+            const float *box = pageText.boxes.constData() + 4 * i;
+            double xMin = 0, yMin = 0, xMax = 0, yMax = 0;
+            bool first = true;
+            for (int j = 0; j < len; ++j, box += 4) {
+                if (box[0] > box[2])
+                    continue;
+                if (first || box[0] < xMin) xMin = box[0];
+                if (first || box[1] < yMin) yMin = box[1];
+                if (first || box[2] > xMax) xMax = box[2];
+                if (first || box[3] > yMax) yMax = box[3];
+                first = false;
+            }
+
+            QRectF result;
+            result.setLeft(xMin);
+            result.setTop(yMin);
+            result.setRight(xMax);
+            result.setBottom(yMax);
+            results.append(qMakePair(page, result));
+
+            i += len;
+        }
+    }
+
+    return results;
+}
+
+bool SearchIndex::save(QIODevice *device) const
+{
+    QDataStream out(device);
+    out.setVersion(QDataStream::Qt_4_6);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    out << searchIndexMagic << searchIndexVersion;
+    out << m_permanentId << m_updateId;
+    out << (qint32)m_pages.count();
+    foreach (const PageText &pageText, m_pages)
+        out << pageText.text << pageText.boxes;
+
+    return out.status() == QDataStream::Ok;
+}
+
+SearchIndex *SearchIndex::load(PDFDoc *doc, QIODevice *device)
+{
+    QDataStream in(device);
+    in.setVersion(QDataStream::Qt_4_6);
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    quint32 magic, version;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != searchIndexMagic || version != searchIndexVersion)
+        return nullptr;
+
+    SearchIndex *index = new SearchIndex();
+    QByteArray permanentId, updateId;
+    getDocumentIds(doc, &permanentId, &updateId);
+    qint32 nPages;
+    in >> index->m_permanentId >> index->m_updateId >> nPages;
+    // an index for another document, or another revision of this one
+    if (in.status() != QDataStream::Ok || index->m_permanentId != permanentId ||
+        index->m_updateId != updateId || nPages != doc->getNumPages()) {
+        delete index;
+        return nullptr;
+    }
+
+    index->m_pages.resize(nPages);
+    for (int i = 0; i < nPages; ++i) {
+        PageText &pageText = index->m_pages[i];
+        in >> pageText.text >> pageText.boxes;
+        if (in.status() != QDataStream::Ok || pageText.boxes.count() != 4 * pageText.text.count()) {
+            delete index;
+            return nullptr;
+        }
+    }
+    index->m_modificationCount = doc->getXRef()->getModificationCount();
+
+    return index;
+}
+
+}
@@ -9,6 +9,7 @@ private slots:
     void bug7063();
     void testNextAndPrevious();
     void testWholeWordsOnly();
+    void testDocumentSearch();
 };
 
 void TestSearch::bug7063()
@@ -170,6 +171,36 @@ void TestSearch::testWholeWordsOnly()
     QCOMPARE( page->search(QLatin1String("Own"), left, top, right, bottom, direction, mode3), false );
 }
 
+void TestSearch::testDocumentSearch()
+{
+    QScopedPointer< Poppler::Document > document(Poppler::Document::load(TESTDATADIR "/unittestcases/xr01.pdf"));
+    QVERIFY( document );
+
+    QScopedPointer< Poppler::Page > page(document->page(0));
+    QVERIFY( page );
+
+    const QList<QRectF> pageResults = page->search(QString("is"), Poppler::Page::NoSearchFlags);
+    const QList< QPair<int, QRectF> > results = document->search(QString("is"));
+    QCOMPARE( results.count(), pageResults.count() );
+    for (int i = 0; i < results.count(); ++i) {
+        QCOMPARE( results.at(i).first, 0 );
+        QVERIFY( qAbs(results.at(i).second.x() - pageResults.at(i).x()) < 0.01 );
+        QVERIFY( qAbs(results.at(i).second.width() - pageResults.at(i).width()) < 0.01 );
+        QVERIFY( results.at(i).second.intersects(pageResults.at(i)) );
+    }
+
+    QCOMPARE( document->search(QString("IS")).count(), 0 );
+    QCOMPARE( document->search(QString("IS"), Poppler::Page::IgnoreCase).count(), results.count() );
+
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    QVERIFY( document->saveSearchIndex(&buffer) );
+    document->clearSearchIndex();
+    buffer.seek(0);
+    QVERIFY( document->loadSearchIndex(&buffer) );
+    QCOMPARE( document->search(QString("is")), results );
+}
+
 QTEST_MAIN(TestSearch)
 #include "moc_check_search.cpp"
 
@@ -14,6 +14,7 @@
 #include <QtCore/QFile>
 #include <QtCore/QMutex>
 #include <QtCore/QThread>
+#include <QtCore/QTime>
 #include <QtGui/QImage>
 
 class SillyThread : public QThread
@@ -43,6 +44,21 @@ private:
 
 };
 
+// renders every threadCount-th page once, starting at firstPage
+class ScalingThread : public QThread
+{
+public:
+    ScalingThread(Poppler::Document* document, int firstPage, int threadCount, QObject* parent = nullptr);
+
+    void run();
+
+private:
+    Poppler::Document* m_document;
+    int m_firstPage;
+    int m_threadCount;
+
+};
+
 static Poppler::Page* loadPage(Poppler::Document* document, int index)
 {
     Poppler::Page* page = document->page(index);
@@ -258,11 +274,94 @@ void CrazyThread::run()
     }
 }
 
+ScalingThread::ScalingThread(Poppler::Document* document, int firstPage, int threadCount, QObject* parent) : QThread(parent),
+    m_document(document),
+    m_firstPage(firstPage),
+    m_threadCount(threadCount)
+{
+}
+
+void ScalingThread::run()
+{
+    for(int index = m_firstPage; index < m_document->numPages(); index += m_threadCount)
+    {
+        QScopedPointer< Poppler::Page > page(loadPage(m_document, index));
+
+        QImage image = page->renderToImage();
+
+        if(image.isNull())
+        {
+            qDebug() << "!Page::renderToImage";
+
+            ::exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// Renders all the pages of a freshly loaded document with 1, 2, 4, ...
+// threads, each one drawing different pages, and prints how the
+// throughput scales with the number of threads.
+static int runScaling(int maxThreadCount, const QString& file)
+{
+    double singleThreadTime = 0.0;
+
+    for(int threadCount = 1; threadCount <= maxThreadCount; threadCount *= 2)
+    {
+        Poppler::Document* document = Poppler::Document::load(file);
+
+        if(document == nullptr || document->isLocked())
+        {
+            qDebug() << "Could not load" << file;
+
+            delete document;
+            return EXIT_FAILURE;
+        }
+
+        QVector< ScalingThread* > threads;
+        QTime time;
+
+        time.start();
+
+        for(int i = 0; i < threadCount; ++i)
+        {
+            threads.append(new ScalingThread(document, i, threadCount));
+            threads.last()->start();
+        }
+
+        foreach(ScalingThread* thread, threads)
+        {
+            thread->wait();
+        }
+
+        const double elapsed = time.elapsed() / 1000.0;
+
+        if(threadCount == 1)
+        {
+            singleThreadTime = elapsed;
+        }
+
+        qDebug() << threadCount << "threads:" << elapsed << "s,"
+                 << (elapsed > 0.0 ? document->numPages() / elapsed : 0.0) << "pages/s, speedup"
+                 << (elapsed > 0.0 ? singleThreadTime / elapsed : 0.0);
+
+        qDeleteAll(threads);
+        delete document;
+    }
+
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, char** argv)
 {
+    if(argc == 4 && qstrcmp(argv[1], "-scaling") == 0)
+    {
+        return runScaling(qMax(1, atoi(argv[2])), QFile::decodeName(argv[3]));
+    }
+
     if(argc < 5)
     {
         qDebug() << "usage: stress-threads-qt duration sillyCount crazyCount file(s)";
+        qDebug() << "       stress-threads-qt -scaling maxThreadCount file";
         
         return EXIT_FAILURE;
     }
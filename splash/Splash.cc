@@ -47,6 +47,7 @@
 #include "SplashPath.h"
 #include "SplashXPath.h"
 #include "SplashXPathScanner.h"
+#include "SplashAreaScanner.h"
 #include "SplashPattern.h"
 #include "SplashScreen.h"
 #include "SplashFont.h"
@@ -54,6 +55,11 @@
 #include "Splash.h"
 #include <algorithm>
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#define USE_SSE2_SPANS 1
+#include <immintrin.h>
+#endif
+
 //------------------------------------------------------------------------
 
 #define splashAAGamma 1.5
@@ -163,6 +169,11 @@ struct SplashPipe {
 
   // the "run" function
   void (Splash::*run)(SplashPipe *pipe);
+
+  // the function drawing whole spans, NULL if the pixels must go through
+  // "run" one at a time
+  void (Splash::*runSpan)(SplashPipe *pipe, int x0, int x1, int y,
+			  Guchar *shape);
 };
 
 SplashPipeResultColorCtrl Splash::pipeResultColorNoAlphaBlend[] = {
@@ -340,6 +351,19 @@ inline void Splash::pipeInit(SplashPipe *pipe, int x, int y,
 #endif
     }
   }
+
+  // select the 'runSpan' function
+  pipe->runSpan = nullptr;
+  if (!pipe->pattern && !state->blendFunc && pipe->destAlphaPtr &&
+      (bitmap->mode == splashModeMono8 || bitmap->mode == splashModeRGB8 ||
+       bitmap->mode == splashModeXBGR8)) {
+    if (pipe->noTransparency) {
+      pipe->runSpan = &Splash::pipeRunSpanSolid;
+    } else if (!(state->inNonIsolatedGroup && alpha0Bitmap->alpha) &&
+	       !pipe->nonIsolatedGroup && state->identityTransfer) {
+      pipe->runSpan = &Splash::pipeRunSpanComposite;
+    }
+  }
 }
 
 // general case
@@ -1323,6 +1347,487 @@ void Splash::pipeRunAADeviceN8(SplashPipe *pipe) {
 }
 #endif
 
+//------------------------------------------------------------------------
+// span kernels
+//------------------------------------------------------------------------
+
+// The span kernels draw <n> pixels of a Mono8, RGB8 or XBGR8 row at
+// once, <nBytes> being the number of bytes per pixel, for the pipes with
+// no pattern, blend function, group correction or transfer function.
+// <src> is the source color in the byte order of the bitmap.  The
+// composite kernels leave the pixels whose <shape> is zero untouched, as
+// drawAALine() does; without <shape> every pixel is drawn, with the
+// source alpha <aInput> times <softMask>, if any.  SSE2 being always
+// there on x86-64, the SSE2 kernels composite 4 pixels at a time; the
+// AVX2 ones, 8 pixels, are picked at run time.
+
+// Fills the pixels with <src>, opaque.
+template<int nBytes>
+static void fillSpan(Guchar *dest, Guchar *alpha, int n, const Guchar *src) {
+  int i, k;
+
+  i = 0;
+  if (nBytes == 1) {
+    memset(dest, src[0], n);
+    i = n;
+  }
+#ifdef USE_SSE2_SPANS
+  if (nBytes == 4) {
+    Guint pixel;
+    memcpy(&pixel, src, 4);
+    const __m128i v = _mm_set1_epi32(pixel);
+    for (; i + 4 <= n; i += 4) {
+      _mm_storeu_si128((__m128i *)(dest + 4 * i), v);
+    }
+  } else if (nBytes == 3) {
+    // 16 pixels are 3 vectors
+    Guchar pattern[48];
+    for (k = 0; k < 48; ++k) {
+      pattern[k] = src[k % 3];
+    }
+    const __m128i v0 = _mm_loadu_si128((const __m128i *)pattern);
+    const __m128i v1 = _mm_loadu_si128((const __m128i *)(pattern + 16));
+    const __m128i v2 = _mm_loadu_si128((const __m128i *)(pattern + 32));
+    for (; i + 16 <= n; i += 16) {
+      _mm_storeu_si128((__m128i *)(dest + 3 * i), v0);
+      _mm_storeu_si128((__m128i *)(dest + 3 * i + 16), v1);
+      _mm_storeu_si128((__m128i *)(dest + 3 * i + 32), v2);
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    for (k = 0; k < nBytes; ++k) {
+      dest[nBytes * i + k] = src[k];
+    }
+  }
+  memset(alpha, 255, n);
+}
+
+// Composites the pixels from <i> on, one at a time.
+template<int nBytes>
+static void compositeSpanScalar(Guchar *dest, Guchar *alpha,
+				const Guchar *softMask, const Guchar *shape,
+				int n, Guchar aInput, const Guchar *src,
+				int i) {
+  Guchar aIn, aSrc, aDest, aResult;
+  Guchar *p;
+  int k;
+
+  for (; i < n; ++i) {
+    if (shape && !shape[i]) {
+      continue;
+    }
+    aIn = softMask ? div255(aInput * softMask[i]) : aInput;
+    aSrc = shape ? div255(aIn * shape[i]) : aIn;
+    aDest = alpha[i];
+    aResult = aSrc + aDest - div255(aSrc * aDest);
+    p = dest + nBytes * i;
+    for (k = 0; k < (nBytes == 4 ? 3 : nBytes); ++k) {
+      if (aResult == 0) {
+	p[k] = 0;
+      } else {
+	p[k] = (Guchar)(((aResult - aSrc) * p[k] + aSrc * src[k]) / aResult);
+      }
+    }
+    if (nBytes == 4) {
+      p[3] = 255;
+    }
+    alpha[i] = aResult;
+  }
+}
+
+#ifdef USE_SSE2_SPANS
+
+// The values are kept in 32-bit lanes, all under 256, so that 16-bit
+// multiplies are exact.  The divisions by the result alpha are done in
+// single precision, exact once truncated for such small numbers.
+
+static inline __m128i div255SSE2(__m128i x) {
+  return _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(x, _mm_srli_epi32(x, 8)),
+				      _mm_set1_epi32(0x80)), 8);
+}
+
+static inline __m128i load4SSE2(const Guchar *p) {
+  const __m128i zero = _mm_setzero_si128();
+  int v;
+
+  memcpy(&v, p, 4);
+  return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero),
+			    zero);
+}
+
+static inline void store4SSE2(Guchar *p, __m128i x) {
+  int v;
+
+  x = _mm_packs_epi32(x, x);
+  v = _mm_cvtsi128_si32(_mm_packus_epi16(x, x));
+  memcpy(p, &v, 4);
+}
+
+// (w * c + a * s) / d
+static inline __m128i blendSSE2(__m128i w, __m128i c, __m128i a, __m128i s,
+				__m128 d) {
+  const __m128i num = _mm_add_epi32(_mm_mullo_epi16(w, c),
+				    _mm_mullo_epi16(a, s));
+  return _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(num), d));
+}
+
+// <keep> ? <a> : <b>
+static inline __m128i selectSSE2(__m128i keep, __m128i a, __m128i b) {
+  return _mm_or_si128(_mm_and_si128(keep, a), _mm_andnot_si128(keep, b));
+}
+
+template<int nBytes>
+static void compositeSpanSSE2(Guchar *dest, Guchar *alpha,
+			      const Guchar *softMask, const Guchar *shape,
+			      int n, Guchar aInput, const Guchar *src) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i k255 = _mm_set1_epi32(255);
+  const __m128i byteMask = _mm_set1_epi32(0xff);
+  const int nComps = nBytes == 4 ? 3 : nBytes;
+  __m128i aIn, aSrc, aDest, aResult, w, keep, pixels, c[3], s[3];
+  __m128 d;
+  int cs[3][4];
+  Guchar *p;
+  int i, j, k;
+
+  pixels = zero;
+  for (k = 0; k < nComps; ++k) {
+    s[k] = _mm_set1_epi32(src[k]);
+  }
+  for (i = 0; i + 4 <= n; i += 4) {
+    p = dest + nBytes * i;
+
+    // source and result alpha
+    aIn = _mm_set1_epi32(aInput);
+    if (softMask) {
+      aIn = div255SSE2(_mm_mullo_epi16(aIn, load4SSE2(softMask + i)));
+    }
+    if (shape) {
+      keep = load4SSE2(shape + i);
+      aSrc = div255SSE2(_mm_mullo_epi16(aIn, keep));
+      keep = _mm_cmpeq_epi32(keep, zero);
+      if (_mm_movemask_epi8(keep) == 0xffff) {
+	continue;
+      }
+    } else {
+      aSrc = aIn;
+      keep = zero;
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(aSrc, k255)) == 0xffff) {
+      fillSpan<nBytes>(p, alpha + i, 4, src);
+      continue;
+    }
+    aDest = load4SSE2(alpha + i);
+    aResult = _mm_sub_epi32(_mm_add_epi32(aSrc, aDest),
+			    div255SSE2(_mm_mullo_epi16(aSrc, aDest)));
+    w = _mm_sub_epi32(aResult, aSrc);
+    d = _mm_cvtepi32_ps(_mm_or_si128(aResult,
+				     _mm_and_si128(_mm_cmpeq_epi32(aResult,
+								   zero),
+						   one)));
+
+    // result color
+    if (nBytes == 1) {
+      c[0] = load4SSE2(p);
+    } else if (nBytes == 3) {
+      for (k = 0; k < 3; ++k) {
+	c[k] = _mm_setr_epi32(p[k], p[3 + k], p[6 + k], p[9 + k]);
+      }
+    } else {
+      pixels = _mm_loadu_si128((const __m128i *)p);
+      for (k = 0; k < 3; ++k) {
+	c[k] = _mm_and_si128(_mm_srli_epi32(pixels, 8 * k), byteMask);
+      }
+    }
+    for (k = 0; k < nComps; ++k) {
+      c[k] = blendSSE2(w, c[k], aSrc, s[k], d);
+    }
+    if (nBytes == 1) {
+      store4SSE2(p, selectSSE2(keep, load4SSE2(p), c[0]));
+    } else if (nBytes == 3) {
+      for (k = 0; k < 3; ++k) {
+	_mm_storeu_si128((__m128i *)cs[k], c[k]);
+      }
+      for (j = 0; j < 4; ++j) {
+	if (!shape || shape[i + j]) {
+	  p[3 * j] = cs[0][j];
+	  p[3 * j + 1] = cs[1][j];
+	  p[3 * j + 2] = cs[2][j];
+	}
+      }
+    } else {
+      c[0] = _mm_or_si128(_mm_or_si128(c[0], _mm_slli_epi32(c[1], 8)),
+			  _mm_or_si128(_mm_slli_epi32(c[2], 16),
+				       _mm_slli_epi32(k255, 24)));
+      _mm_storeu_si128((__m128i *)p, selectSSE2(keep, pixels, c[0]));
+    }
+    store4SSE2(alpha + i, selectSSE2(keep, aDest, aResult));
+  }
+  compositeSpanScalar<nBytes>(dest, alpha, softMask, shape, n, aInput, src,
+			      i);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i div255AVX2(__m256i x) {
+  return _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(x,
+						_mm256_srli_epi32(x, 8)),
+					    _mm256_set1_epi32(0x80)), 8);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i load8AVX2(const Guchar *p) {
+  return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)p));
+}
+
+__attribute__((target("avx2")))
+static inline void store8AVX2(Guchar *p, __m256i x) {
+  x = _mm256_packus_epi32(x, x);
+  x = _mm256_packus_epi16(x, x);
+  _mm_storel_epi64((__m128i *)p,
+		   _mm_unpacklo_epi32(_mm256_castsi256_si128(x),
+				      _mm256_extracti128_si256(x, 1)));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i blendAVX2(__m256i w, __m256i c, __m256i a, __m256i s,
+				__m256 d) {
+  const __m256i num = _mm256_add_epi32(_mm256_mullo_epi16(w, c),
+				       _mm256_mullo_epi16(a, s));
+  return _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(num), d));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i selectAVX2(__m256i keep, __m256i a, __m256i b) {
+  return _mm256_blendv_epi8(b, a, keep);
+}
+
+template<int nBytes>
+__attribute__((target("avx2")))
+static void compositeSpanAVX2(Guchar *dest, Guchar *alpha,
+			      const Guchar *softMask, const Guchar *shape,
+			      int n, Guchar aInput, const Guchar *src) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i k255 = _mm256_set1_epi32(255);
+  const __m256i byteMask = _mm256_set1_epi32(0xff);
+  const int nComps = nBytes == 4 ? 3 : nBytes;
+  __m256i aIn, aSrc, aDest, aResult, w, keep, pixels, c[3], s[3];
+  __m256 d;
+  int cs[3][8];
+  Guchar *p;
+  int i, j, k;
+
+  pixels = zero;
+  for (k = 0; k < nComps; ++k) {
+    s[k] = _mm256_set1_epi32(src[k]);
+  }
+  for (i = 0; i + 8 <= n; i += 8) {
+    p = dest + nBytes * i;
+
+    // source and result alpha
+    aIn = _mm256_set1_epi32(aInput);
+    if (softMask) {
+      aIn = div255AVX2(_mm256_mullo_epi16(aIn, load8AVX2(softMask + i)));
+    }
+    if (shape) {
+      keep = load8AVX2(shape + i);
+      aSrc = div255AVX2(_mm256_mullo_epi16(aIn, keep));
+      keep = _mm256_cmpeq_epi32(keep, zero);
+      if (_mm256_movemask_epi8(keep) == -1) {
+	continue;
+      }
+    } else {
+      aSrc = aIn;
+      keep = zero;
+    }
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(aSrc, k255)) == -1) {
+      fillSpan<nBytes>(p, alpha + i, 8, src);
+      continue;
+    }
+    aDest = load8AVX2(alpha + i);
+    aResult = _mm256_sub_epi32(_mm256_add_epi32(aSrc, aDest),
+			       div255AVX2(_mm256_mullo_epi16(aSrc, aDest)));
+    w = _mm256_sub_epi32(aResult, aSrc);
+    d = _mm256_cvtepi32_ps(_mm256_or_si256(aResult,
+			     _mm256_and_si256(_mm256_cmpeq_epi32(aResult,
+								 zero),
+					      one)));
+
+    // result color
+    if (nBytes == 1) {
+      c[0] = load8AVX2(p);
+    } else if (nBytes == 3) {
+      for (k = 0; k < 3; ++k) {
+	c[k] = _mm256_setr_epi32(p[k], p[3 + k], p[6 + k], p[9 + k],
+				 p[12 + k], p[15 + k], p[18 + k], p[21 + k]);
+      }
+    } else {
+      pixels = _mm256_loadu_si256((const __m256i *)p);
+      for (k = 0; k < 3; ++k) {
+	c[k] = _mm256_and_si256(_mm256_srli_epi32(pixels, 8 * k), byteMask);
+      }
+    }
+    for (k = 0; k < nComps; ++k) {
+      c[k] = blendAVX2(w, c[k], aSrc, s[k], d);
+    }
+    if (nBytes == 1) {
+      store8AVX2(p, selectAVX2(keep, load8AVX2(p), c[0]));
+    } else if (nBytes == 3) {
+      for (k = 0; k < 3; ++k) {
+	_mm256_storeu_si256((__m256i *)cs[k], c[k]);
+      }
+      for (j = 0; j < 8; ++j) {
+	if (!shape || shape[i + j]) {
+	  p[3 * j] = cs[0][j];
+	  p[3 * j + 1] = cs[1][j];
+	  p[3 * j + 2] = cs[2][j];
+	}
+      }
+    } else {
+      c[0] = _mm256_or_si256(_mm256_or_si256(c[0],
+					     _mm256_slli_epi32(c[1], 8)),
+			     _mm256_or_si256(_mm256_slli_epi32(c[2], 16),
+					     _mm256_slli_epi32(k255, 24)));
+      _mm256_storeu_si256((__m256i *)p, selectAVX2(keep, pixels, c[0]));
+    }
+    store8AVX2(alpha + i, selectAVX2(keep, aDest, aResult));
+  }
+  compositeSpanSSE2<nBytes>(dest + nBytes * i, alpha + i,
+			    softMask ? softMask + i : nullptr,
+			    shape ? shape + i : nullptr,
+			    n - i, aInput, src);
+}
+
+static GBool haveAVX2() {
+  static const GBool avx2 = __builtin_cpu_supports("avx2") ? gTrue : gFalse;
+
+  return avx2;
+}
+
+#endif // USE_SSE2_SPANS
+
+template<int nBytes>
+static void compositeSpanVec(Guchar *dest, Guchar *alpha,
+			     const Guchar *softMask, const Guchar *shape,
+			     int n, Guchar aInput, const Guchar *src) {
+#ifdef USE_SSE2_SPANS
+  if (haveAVX2()) {
+    compositeSpanAVX2<nBytes>(dest, alpha, softMask, shape, n, aInput, src);
+  } else {
+    compositeSpanSSE2<nBytes>(dest, alpha, softMask, shape, n, aInput, src);
+  }
+#else
+  compositeSpanScalar<nBytes>(dest, alpha, softMask, shape, n, aInput, src,
+			      0);
+#endif
+}
+
+// runs of fully covered opaque pixels, the inside of filled shapes, are
+// filled rather than composited if at least this long
+#define splashMinOpaqueRun 16
+
+template<int nBytes>
+static void compositeSpan(Guchar *dest, Guchar *alpha,
+			  const Guchar *softMask, const Guchar *shape,
+			  int n, Guchar aInput, const Guchar *src) {
+  int start, i, j;
+
+  start = 0;
+  if (shape && !softMask && aInput == 255) {
+    for (i = 0; i < n; i = j) {
+      for (j = i; j < n && shape[j] == 255; ++j) ;
+      if (j - i >= splashMinOpaqueRun) {
+	compositeSpanVec<nBytes>(dest + nBytes * start, alpha + start,
+				 nullptr, shape + start, i - start,
+				 aInput, src);
+	fillSpan<nBytes>(dest + nBytes * i, alpha + i, j - i, src);
+	start = j;
+      }
+      if (j == i) {
+	++j;
+      }
+    }
+  }
+  compositeSpanVec<nBytes>(dest + nBytes * start, alpha + start,
+			   softMask ? softMask + start : nullptr,
+			   shape ? shape + start : nullptr, n - start,
+			   aInput, src);
+}
+
+// span version of the pipeRunSimple* functions:
+// pipe->noTransparency && !state->blendFunc && !pipe->pattern &&
+// bitmap->mode is Mono8, RGB8 or XBGR8 && pipe->destAlphaPtr
+void Splash::pipeRunSpanSolid(SplashPipe *pipe, int x0, int x1, int y,
+			      Guchar * /*shape*/) {
+  SplashColor src;
+  Guchar *dest, *alpha;
+
+  dest = &bitmap->data[y * bitmap->rowSize];
+  alpha = &bitmap->alpha[y * bitmap->width + x0];
+  switch (bitmap->mode) {
+  case splashModeMono8:
+    src[0] = state->grayTransfer[pipe->cSrc[0]];
+    fillSpan<1>(dest + x0, alpha, x1 - x0 + 1, src);
+    break;
+  case splashModeRGB8:
+    src[0] = state->rgbTransferR[pipe->cSrc[0]];
+    src[1] = state->rgbTransferG[pipe->cSrc[1]];
+    src[2] = state->rgbTransferB[pipe->cSrc[2]];
+    fillSpan<3>(dest + 3 * x0, alpha, x1 - x0 + 1, src);
+    break;
+  case splashModeXBGR8:
+    src[0] = state->rgbTransferB[pipe->cSrc[2]];
+    src[1] = state->rgbTransferG[pipe->cSrc[1]];
+    src[2] = state->rgbTransferR[pipe->cSrc[0]];
+    src[3] = 255;
+    fillSpan<4>(dest + 4 * x0, alpha, x1 - x0 + 1, src);
+    break;
+  default:
+    break;
+  }
+}
+
+// span version of pipeRun, and the pipeRunAA* functions, with a soft
+// mask or not:
+// !pipe->noTransparency && !state->blendFunc && !pipe->pattern &&
+// !pipe->alpha0Ptr && !pipe->nonIsolatedGroup &&
+// state->identityTransfer &&
+// bitmap->mode is Mono8, RGB8 or XBGR8 && pipe->destAlphaPtr
+void Splash::pipeRunSpanComposite(SplashPipe *pipe, int x0, int x1, int y,
+				  Guchar *shape) {
+  SplashColor src;
+  Guchar *dest, *alpha, *softMask;
+
+  dest = &bitmap->data[y * bitmap->rowSize];
+  alpha = &bitmap->alpha[y * bitmap->width + x0];
+  softMask = nullptr;
+  if (state->softMask) {
+    softMask = &state->softMask->data[y * state->softMask->rowSize + x0];
+  }
+  switch (bitmap->mode) {
+  case splashModeMono8:
+    compositeSpan<1>(dest + x0, alpha, softMask, shape, x1 - x0 + 1,
+		     pipe->aInput, pipe->cSrc);
+    break;
+  case splashModeRGB8:
+    compositeSpan<3>(dest + 3 * x0, alpha, softMask, shape, x1 - x0 + 1,
+		     pipe->aInput, pipe->cSrc);
+    break;
+  case splashModeXBGR8:
+    src[0] = pipe->cSrc[2];
+    src[1] = pipe->cSrc[1];
+    src[2] = pipe->cSrc[0];
+    src[3] = 255;
+    compositeSpan<4>(dest + 4 * x0, alpha, softMask, shape, x1 - x0 + 1,
+		     pipe->aInput, src);
+    break;
+  default:
+    break;
+  }
+}
+
 inline void Splash::pipeSetXY(SplashPipe *pipe, int x, int y) {
   pipe->x = x;
   pipe->y = y;
@@ -1483,32 +1988,37 @@ inline void Splash::drawAAPixel(SplashPipe *pipe, int x, int y) {
 
 inline void Splash::drawSpan(SplashPipe *pipe, int x0, int x1, int y,
 			     GBool noClip) {
-  int x;
+  int x, xa, xb;
 
   if (noClip) {
-    pipeSetXY(pipe, x0, y);
-    for (x = x0; x <= x1; ++x) {
-      (this->*pipe->run)(pipe);
+    if (pipe->runSpan && !pipe->usesShape) {
+      if (x0 <= x1) {
+	(this->*pipe->runSpan)(pipe, x0, x1, y, nullptr);
+      }
+    } else {
+      pipeSetXY(pipe, x0, y);
+      for (x = x0; x <= x1; ++x) {
+	(this->*pipe->run)(pipe);
+      }
     }
     updateModX(x0);
     updateModX(x1);
     updateModY(y);
   } else {
-    if (x0 < state->clip->getXMinI()) {
-      x0 = state->clip->getXMinI();
-    }
-    if (x1 > state->clip->getXMaxI()) {
-      x1 = state->clip->getXMaxI();
-    }
-    pipeSetXY(pipe, x0, y);
-    for (x = x0; x <= x1; ++x) {
-      if (state->clip->test(x, y)) {
-	(this->*pipe->run)(pipe);
-	updateModX(x);
-	updateModY(y);
+    // draw the runs of pixels inside the clip region
+    while (state->clip->getInsideSpan(x0, x1, y, &xa, &xb)) {
+      if (pipe->runSpan && !pipe->usesShape) {
+	(this->*pipe->runSpan)(pipe, xa, xb, y, nullptr);
       } else {
-	pipeIncX(pipe);
+	pipeSetXY(pipe, xa, y);
+	for (x = xa; x <= xb; ++x) {
+	  (this->*pipe->run)(pipe);
+	}
       }
+      updateModX(xa);
+      updateModX(xb);
+      updateModY(y);
+      x0 = xb + 1;
     }
   }
 }
@@ -1523,7 +2033,8 @@ inline void Splash::drawAALine(SplashPipe *pipe, int x0, int x1, int y, GBool ad
   SplashColorPtr p;
   int xx, yy, t;
 #endif
-  int x;
+  GBool spans;
+  int x, xMin, xMax;
 
 #if splashAASize == 4
   p0 = aaBuf->getDataPtr() + (x0 >> 1);
@@ -1531,6 +2042,12 @@ inline void Splash::drawAALine(SplashPipe *pipe, int x0, int x1, int y, GBool ad
   p2 = p1 + aaBuf->getRowSize();
   p3 = p2 + aaBuf->getRowSize();
 #endif
+  // with a span function the shape values are gathered first, then the
+  // pixels drawn all at once; a shape of zero is a pixel left untouched,
+  // which thin lines can't have
+  spans = pipe->runSpan && aaShape && !adjustLine;
+  xMin = x1 + 1;
+  xMax = x0 - 1;
   pipeSetXY(pipe, x0, y);
   for (x = x0; x <= x1; ++x) {
 
@@ -1555,7 +2072,15 @@ inline void Splash::drawAALine(SplashPipe *pipe, int x0, int x1, int y, GBool ad
     }
 #endif
 
-    if (t != 0) {
+    if (spans) {
+      aaShape[x - x0] = (Guchar)aaGamma[t];
+      if (t != 0) {
+	if (xMin > x1) {
+	  xMin = x;
+	}
+	xMax = x;
+      }
+    } else if (t != 0) {
       pipe->shape = (adjustLine) ? div255((int) lineOpacity * (double)aaGamma[t]) : (double)aaGamma[t];
       (this->*pipe->run)(pipe);
       updateModX(x);
@@ -1564,6 +2089,119 @@ inline void Splash::drawAALine(SplashPipe *pipe, int x0, int x1, int y, GBool ad
       pipeIncX(pipe);
     }
   }
+
+  if (spans && xMin <= xMax) {
+    (this->*pipe->runSpan)(pipe, xMin, xMax, y, aaShape + (xMin - x0));
+    updateModX(xMin);
+    updateModX(xMax);
+    updateModY(y);
+  }
+}
+
+// Draw the pixels of line <y> in [<x0>, <x1>] with the coverage values
+// in aaCoverage, as computed by the splashAAQualityDraft and
+// splashAAQualityAnalytic rasterizers.  If <clip> is set, the coverage
+// is reduced to the part of each pixel inside the clip region, as
+// sampled in aaBuf.
+void Splash::drawCoverageLine(SplashPipe *pipe, int x0, int x1, int y,
+			      GBool clip) {
+#if splashAASize == 4
+  static int bitCount4[16] = { 0, 1, 1, 2, 1, 2, 2, 3,
+			       1, 2, 2, 3, 2, 3, 3, 4 };
+  SplashColorPtr p0, p1, p2, p3;
+#else
+  SplashColorPtr p;
+  int xx, yy;
+#endif
+  int x, xMin, xMax, t;
+
+  if (clip) {
+    if (y < state->clip->getYMinI() || y > state->clip->getYMaxI()) {
+      return;
+    }
+    if (x0 < state->clip->getXMinI()) {
+      x0 = state->clip->getXMinI();
+    }
+    if (x1 > state->clip->getXMaxI()) {
+      x1 = state->clip->getXMaxI();
+    }
+    if (x0 > x1) {
+      return;
+    }
+    for (t = 0; t < splashAASize; ++t) {
+      memset(aaBuf->getDataPtr() + t * aaBuf->getRowSize()
+	       + ((x0 * splashAASize) >> 3),
+	     0xff, ((x1 * splashAASize + splashAASize - 1) >> 3)
+		     - ((x0 * splashAASize) >> 3) + 1);
+    }
+    xMin = x0;
+    xMax = x1;
+    state->clip->clipAALine(aaBuf, &xMin, &xMax, y);
+    if (xMin > x0) {
+      x0 = xMin;
+    }
+    if (xMax < x1) {
+      x1 = xMax;
+    }
+#if splashAASize == 4
+    p0 = aaBuf->getDataPtr() + (x0 >> 1);
+    p1 = p0 + aaBuf->getRowSize();
+    p2 = p1 + aaBuf->getRowSize();
+    p3 = p2 + aaBuf->getRowSize();
+#endif
+    for (x = x0; x <= x1; ++x) {
+#if splashAASize == 4
+      if (x & 1) {
+	t = bitCount4[*p0 & 0x0f] + bitCount4[*p1 & 0x0f] +
+	    bitCount4[*p2 & 0x0f] + bitCount4[*p3 & 0x0f];
+	++p0; ++p1; ++p2; ++p3;
+      } else {
+	t = bitCount4[*p0 >> 4] + bitCount4[*p1 >> 4] +
+	    bitCount4[*p2 >> 4] + bitCount4[*p3 >> 4];
+      }
+#else
+      t = 0;
+      for (yy = 0; yy < splashAASize; ++yy) {
+	for (xx = 0; xx < splashAASize; ++xx) {
+	  p = aaBuf->getDataPtr() + yy * aaBuf->getRowSize() +
+	      ((x * splashAASize + xx) >> 3);
+	  t += (*p >> (7 - ((x * splashAASize + xx) & 7))) & 1;
+	}
+      }
+#endif
+      aaCoverage[x] = (Guchar)((aaCoverageGamma[aaCoverage[x]] * t
+				+ splashAASize * splashAASize / 2)
+			       / (splashAASize * splashAASize));
+    }
+  } else {
+    for (x = x0; x <= x1; ++x) {
+      aaCoverage[x] = aaCoverageGamma[aaCoverage[x]];
+    }
+  }
+
+  if (pipe->runSpan) {
+    // the span function leaves the pixels with a shape of zero untouched
+    for (xMin = x0; xMin <= x1 && !aaCoverage[xMin]; ++xMin) ;
+    for (xMax = x1; xMax >= xMin && !aaCoverage[xMax]; --xMax) ;
+    if (xMin <= xMax) {
+      (this->*pipe->runSpan)(pipe, xMin, xMax, y, aaCoverage + xMin);
+      updateModX(xMin);
+      updateModX(xMax);
+      updateModY(y);
+    }
+  } else {
+    pipeSetXY(pipe, x0, y);
+    for (x = x0; x <= x1; ++x) {
+      if (aaCoverage[x]) {
+	pipe->shape = aaCoverage[x];
+	(this->*pipe->run)(pipe);
+	updateModX(x);
+	updateModY(y);
+      } else {
+	pipeIncX(pipe);
+      }
+    }
+  }
 }
 
 //------------------------------------------------------------------------
@@ -1595,15 +2233,25 @@ Splash::Splash(SplashBitmap *bitmapA, GBool vectorAntialiasA,
   if (vectorAntialias) {
     aaBuf = new SplashBitmap(splashAASize * bitmap->width, splashAASize,
 			     1, splashModeMono1, gFalse);
+    aaShape = (Guchar *)gmalloc(bitmap->width);
     for (i = 0; i <= splashAASize * splashAASize; ++i) {
       aaGamma[i] = (Guchar)splashRound(
 		       splashPow((SplashCoord)i /
 				 (SplashCoord)(splashAASize * splashAASize),
 				 splashAAGamma) * 255);
     }
+    aaCoverage = (Guchar *)gmalloc(bitmap->width);
+    for (i = 0; i < 256; ++i) {
+      aaCoverageGamma[i] = (Guchar)splashRound(
+			       splashPow((SplashCoord)i / 255,
+					 splashAAGamma) * 255);
+    }
   } else {
     aaBuf = nullptr;
+    aaShape = nullptr;
+    aaCoverage = nullptr;
   }
+  aaQuality = splashAAQualityNormal;
   minLineWidth = 0;
   thinLineMode = splashThinLineDefault;
   clearModRegion();
@@ -1623,15 +2271,25 @@ Splash::Splash(SplashBitmap *bitmapA, GBool vectorAntialiasA,
   if (vectorAntialias) {
     aaBuf = new SplashBitmap(splashAASize * bitmap->width, splashAASize,
 			     1, splashModeMono1, gFalse);
+    aaShape = (Guchar *)gmalloc(bitmap->width);
     for (i = 0; i <= splashAASize * splashAASize; ++i) {
       aaGamma[i] = (Guchar)splashRound(
 		       splashPow((SplashCoord)i /
 				 (SplashCoord)(splashAASize * splashAASize),
 				 splashAAGamma) * 255);
     }
+    aaCoverage = (Guchar *)gmalloc(bitmap->width);
+    for (i = 0; i < 256; ++i) {
+      aaCoverageGamma[i] = (Guchar)splashRound(
+			       splashPow((SplashCoord)i / 255,
+					 splashAAGamma) * 255);
+    }
   } else {
     aaBuf = nullptr;
+    aaShape = nullptr;
+    aaCoverage = nullptr;
   }
+  aaQuality = splashAAQualityNormal;
   minLineWidth = 0;
   thinLineMode = splashThinLineDefault;
   clearModRegion();
@@ -1645,6 +2303,8 @@ Splash::~Splash() {
   }
   delete state;
   delete aaBuf;
+  gfree(aaShape);
+  gfree(aaCoverage);
 }
 
 //------------------------------------------------------------------------
@@ -2519,6 +3179,12 @@ SplashError Splash::fillWithPattern(SplashPath *path, GBool eo,
 
   xPath = new SplashXPath(path, state->matrix, state->flatness, gTrue, 
     adjustLine, linePosI);
+  if (vectorAntialias && !inShading && aaQuality != splashAAQualityNormal &&
+      thinLineMode == splashThinLineDefault) {
+    fillWithCoverage(xPath, eo, pattern, alpha);
+    delete xPath;
+    return splashOk;
+  }
   if (vectorAntialias && !inShading) {
     xPath->aaScale();
   }
@@ -2606,6 +3272,84 @@ SplashError Splash::fillWithPattern(SplashPath *path, GBool eo,
   return splashOk;
 }
 
+// Fills <xPath> (not yet scaled or sorted) with the anti-aliasing of
+// aaQuality, which yields a coverage value for each pixel instead of
+// the splashAASize x splashAASize samples in aaBuf.
+void Splash::fillWithCoverage(SplashXPath *xPath, GBool eo,
+			      SplashPattern *pattern, SplashCoord alpha) {
+  SplashPipe pipe;
+  SplashXPathScanner *scanner;
+  SplashAreaScanner *areaScanner;
+  SplashClipResult clipRes;
+  int xMinI, yMinI, xMaxI, yMaxI, x0, x1, x, y, n;
+
+  n = splashAADraftSize * splashAADraftSize;
+  if (aaQuality == splashAAQualityDraft) {
+    xPath->aaScale(splashAADraftSize);
+    xPath->sort();
+    scanner = new SplashXPathScanner(xPath, eo,
+				     state->clip->getYMinI() * splashAADraftSize,
+				     (state->clip->getYMaxI() + 1)
+				       * splashAADraftSize - 1);
+    areaScanner = nullptr;
+    scanner->getBBox(&xMinI, &yMinI, &xMaxI, &yMaxI);
+    xMinI = splashFloor((SplashCoord)xMinI / splashAADraftSize);
+    yMinI = splashFloor((SplashCoord)yMinI / splashAADraftSize);
+    xMaxI = splashFloor((SplashCoord)xMaxI / splashAADraftSize);
+    yMaxI = splashFloor((SplashCoord)yMaxI / splashAADraftSize);
+    // the scanner only limits the y range
+    if (xMinI < state->clip->getXMinI()) {
+      xMinI = state->clip->getXMinI();
+    }
+    if (xMaxI > state->clip->getXMaxI()) {
+      xMaxI = state->clip->getXMaxI();
+    }
+  } else {
+    xPath->sort();
+    scanner = nullptr;
+    areaScanner = new SplashAreaScanner(xPath, eo,
+					state->clip->getXMinI(),
+					state->clip->getXMaxI(),
+					state->clip->getYMinI(),
+					state->clip->getYMaxI());
+    areaScanner->getBBox(&xMinI, &yMinI, &xMaxI, &yMaxI);
+  }
+
+  // check clipping
+  if (xMinI > xMaxI || yMinI > yMaxI) {
+    clipRes = splashClipAllOutside;
+  } else if ((clipRes = state->clip->testRect(xMinI, yMinI, xMaxI, yMaxI))
+	     != splashClipAllOutside) {
+    if ((scanner && scanner->hasPartialClip()) ||
+	(areaScanner && areaScanner->hasPartialClip())) {
+      clipRes = splashClipPartial;
+    }
+
+    pipeInit(&pipe, xMinI, yMinI, pattern, nullptr,
+	     (Guchar)splashRound(alpha * 255), gTrue, gFalse);
+
+    // draw the lines
+    for (y = yMinI; y <= yMaxI; ++y) {
+      if (scanner) {
+	scanner->countAASamples(aaCoverage, splashAADraftSize, xMinI, xMaxI,
+				&x0, &x1, y);
+	for (x = x0; x <= x1; ++x) {
+	  aaCoverage[x] = (Guchar)((aaCoverage[x] * 255 + n / 2) / n);
+	}
+      } else {
+	areaScanner->renderLine(aaCoverage, &x0, &x1, y);
+      }
+      if (x0 <= x1) {
+	drawCoverageLine(&pipe, x0, x1, y, clipRes != splashClipAllInside);
+      }
+    }
+  }
+  opClipRes = clipRes;
+
+  delete scanner;
+  delete areaScanner;
+}
+
 GBool Splash::pathAllOutside(SplashPath *path) {
   SplashCoord xMin1, yMin1, xMax1, yMax1;
   SplashCoord xMin2, yMin2, xMax2, yMax2;
@@ -261,6 +261,12 @@ public:
   void setThinLineMode(SplashThinLineMode thinLineModeA) { thinLineMode = thinLineModeA; }
   SplashThinLineMode getThinLineMode() { return thinLineMode; }
 
+  // Setter/Getter for the anti-aliasing quality of filled paths; thin
+  // line modes other than splashThinLineDefault always use
+  // splashAAQualityNormal
+  void setAAQuality(SplashAAQuality aaQualityA) { aaQuality = aaQualityA; }
+  SplashAAQuality getAAQuality() { return aaQuality; }
+
   // Get a bounding box which includes all modifications since the
   // last call to clearModRegion.
   void getModRegion(int *xMin, int *yMin, int *xMax, int *yMax)
@@ -314,6 +320,10 @@ private:
   void pipeRunAACMYK8(SplashPipe *pipe);
   void pipeRunAADeviceN8(SplashPipe *pipe);
 #endif
+  void pipeRunSpanSolid(SplashPipe *pipe, int x0, int x1, int y,
+			Guchar *shape);
+  void pipeRunSpanComposite(SplashPipe *pipe, int x0, int x1, int y,
+			    Guchar *shape);
   void pipeSetXY(SplashPipe *pipe, int x, int y);
   void pipeIncX(SplashPipe *pipe);
   void drawPixel(SplashPipe *pipe, int x, int y, GBool noClip);
@@ -321,6 +331,8 @@ private:
   void drawAAPixel(SplashPipe *pipe, int x, int y);
   void drawSpan(SplashPipe *pipe, int x0, int x1, int y, GBool noClip);
   void drawAALine(SplashPipe *pipe, int x0, int x1, int y, GBool adjustLine = gFalse, Guchar lineOpacity = 0);
+  void drawCoverageLine(SplashPipe *pipe, int x0, int x1, int y,
+			GBool clip);
   void transform(SplashCoord *matrix, SplashCoord xi, SplashCoord yi,
 		 SplashCoord *xo, SplashCoord *yo);
   void updateModX(int x);
@@ -337,6 +349,8 @@ private:
 		    SplashPath *fPath);
   SplashPath *makeDashedPath(SplashPath *xPath);
   void getBBoxFP(SplashPath *path, SplashCoord *xMinA, SplashCoord *yMinA, SplashCoord *xMaxA, SplashCoord *yMaxA);
+  void fillWithCoverage(SplashXPath *xPath, GBool eo,
+			SplashPattern *pattern, SplashCoord alpha);
   SplashError fillWithPattern(SplashPath *path, GBool eo,
 			      SplashPattern *pattern, SplashCoord alpha);
   GBool pathAllOutside(SplashPath *path);
@@ -418,10 +432,16 @@ private:
   SplashState *state;
   SplashBitmap *aaBuf;
   int aaBufY;
+  Guchar *aaShape;		// shape values of the pixels of an
+				//   anti-aliased line
   SplashBitmap *alpha0Bitmap;	// for non-isolated groups, this is the
 				//   bitmap containing the alpha0 values
   int alpha0X, alpha0Y;		// offset within alpha0Bitmap
   SplashCoord aaGamma[splashAASize * splashAASize + 1];
+  Guchar *aaCoverage;		// coverage of the pixels of an anti-aliased
+				//   line, for the other AA qualities
+  Guchar aaCoverageGamma[256];
+  SplashAAQuality aaQuality;
   SplashCoord minLineWidth;
   SplashThinLineMode thinLineMode;
   int modXMin, modYMin, modXMax, modYMax;
@@ -0,0 +1,293 @@
+//========================================================================
+//
+// SplashAreaScanner.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+//========================================================================
+
+#include <config.h>
+
+#include <string.h>
+#include <math.h>
+#include "goo/gmem.h"
+#include "SplashMath.h"
+#include "SplashXPath.h"
+#include "SplashAreaScanner.h"
+
+//------------------------------------------------------------------------
+// SplashAreaScanner
+//------------------------------------------------------------------------
+
+SplashAreaScanner::SplashAreaScanner(SplashXPath *xPathA, GBool eoA,
+				     int clipXMin, int clipXMax,
+				     int clipYMin, int clipYMax) {
+  SplashXPathSeg *seg;
+  SplashCoord xMinFP, yMinFP, xMaxFP, yMaxFP;
+  int i;
+
+  xPath = xPathA;
+  eo = eoA;
+  partialClip = gFalse;
+
+  // compute the bbox
+  if (xPath->length == 0) {
+    xMin = yMin = 1;
+    xMax = yMax = 0;
+  } else {
+    xMinFP = xMaxFP = xPath->segs[0].x0;
+    yMinFP = yMaxFP = xPath->segs[0].y0;
+    for (i = 0; i < xPath->length; ++i) {
+      seg = &xPath->segs[i];
+      if (seg->x0 < xMinFP) {
+	xMinFP = seg->x0;
+      } else if (seg->x0 > xMaxFP) {
+	xMaxFP = seg->x0;
+      }
+      if (seg->x1 < xMinFP) {
+	xMinFP = seg->x1;
+      } else if (seg->x1 > xMaxFP) {
+	xMaxFP = seg->x1;
+      }
+      if (seg->y0 < yMinFP) {
+	yMinFP = seg->y0;
+      } else if (seg->y0 > yMaxFP) {
+	yMaxFP = seg->y0;
+      }
+      if (seg->y1 < yMinFP) {
+	yMinFP = seg->y1;
+      } else if (seg->y1 > yMaxFP) {
+	yMaxFP = seg->y1;
+      }
+    }
+    xMin = splashFloor(xMinFP);
+    xMax = splashFloor(xMaxFP);
+    yMin = splashFloor(yMinFP);
+    yMax = splashFloor(yMaxFP);
+    if (clipXMin > xMin) {
+      xMin = clipXMin;
+      partialClip = gTrue;
+    }
+    if (clipXMax < xMax) {
+      xMax = clipXMax;
+      partialClip = gTrue;
+    }
+    if (clipYMin > yMin) {
+      yMin = clipYMin;
+      partialClip = gTrue;
+    }
+    if (clipYMax < yMax) {
+      yMax = clipYMax;
+      partialClip = gTrue;
+    }
+  }
+
+  if (xMin <= xMax) {
+    acc = (double *)gmallocn(xMax - xMin + 3, sizeof(double));
+    memset(acc, 0, (xMax - xMin + 3) * sizeof(double));
+  } else {
+    acc = nullptr;
+  }
+  accMin = xMax - xMin + 3;
+  accMax = -1;
+  active = (int *)gmallocn(xPath->length + 1, sizeof(int));
+  nActive = 0;
+  nextSeg = 0;
+  lineY = yMin;
+}
+
+SplashAreaScanner::~SplashAreaScanner() {
+  gfree(acc);
+  gfree(active);
+}
+
+// Adds a piece of segment to the current line, going from <xa> to <xb>
+// (in either order) over a height of <d>, signed with the direction of
+// the segment.
+void SplashAreaScanner::addLine(double xa, double xb, double d) {
+  double lo, hi, t, xf0, xf1, s, a0, a1, a2, am;
+  int xi0, xi1, xi;
+
+  if (xa < xb) {
+    lo = xa - xMin;
+    hi = xb - xMin;
+  } else {
+    lo = xb - xMin;
+    hi = xa - xMin;
+  }
+
+  // the part left of the pixels covers them all, like a vertical line
+  // at their left edge would; the part right of them covers none
+  if (hi <= 0) {
+    acc[0] += d;
+    accMin = 0;
+    if (accMax < 0) {
+      accMax = 0;
+    }
+    return;
+  }
+  if (lo >= xMax - xMin + 1) {
+    return;
+  }
+  if (lo < 0) {
+    t = d * (0 - lo) / (hi - lo);
+    acc[0] += t;
+    accMin = 0;
+    if (accMax < 0) {
+      accMax = 0;
+    }
+    d -= t;
+    lo = 0;
+  }
+  if (hi > xMax - xMin + 1) {
+    d -= d * (hi - (xMax - xMin + 1)) / (hi - lo);
+    hi = xMax - xMin + 1;
+  }
+
+  xi0 = (int)lo;
+  xi1 = (int)ceil(hi);
+  if (xi1 <= xi0 + 1) {
+    // within a single pixel
+    t = 0.5 * (lo + hi) - xi0;
+    acc[xi0] += d - d * t;
+    acc[xi0 + 1] += d * t;
+    xi1 = xi0 + 1;
+  } else {
+    s = 1 / (hi - lo);
+    xf0 = lo - xi0;
+    a0 = 0.5 * s * (1 - xf0) * (1 - xf0);
+    xf1 = hi - xi1 + 1;
+    am = 0.5 * s * xf1 * xf1;
+    acc[xi0] += d * a0;
+    if (xi1 == xi0 + 2) {
+      acc[xi0 + 1] += d * (1 - a0 - am);
+    } else {
+      a1 = s * (1.5 - xf0);
+      acc[xi0 + 1] += d * (a1 - a0);
+      for (xi = xi0 + 2; xi < xi1 - 1; ++xi) {
+	acc[xi] += d * s;
+      }
+      a2 = a1 + (xi1 - xi0 - 3) * s;
+      acc[xi1 - 1] += d * (1 - a2 - am);
+    }
+    acc[xi1] += d * am;
+  }
+  if (xi0 < accMin) {
+    accMin = xi0;
+  }
+  if (xi1 > accMax) {
+    accMax = xi1;
+  }
+}
+
+void SplashAreaScanner::renderLine(Guchar *line, int *x0, int *x1, int y) {
+  SplashXPathSeg *seg;
+  SplashCoord segYMin, segYMax, ya, yb, xa, xb;
+  double sum, cover;
+  Guchar c;
+  int width, x, i, j;
+
+  *x0 = xMax + 1;
+  *x1 = xMax;
+  if (y < yMin || y > yMax || xMin > xMax) {
+    return;
+  }
+
+  // update the active segments: lines are usually asked for in order,
+  // otherwise start over
+  if (y < lineY) {
+    nActive = 0;
+    nextSeg = 0;
+  }
+  lineY = y;
+  for (i = j = 0; i < nActive; ++i) {
+    seg = &xPath->segs[active[i]];
+    segYMax = (seg->flags & splashXPathFlip) ? seg->y0 : seg->y1;
+    if (segYMax > y) {
+      active[j++] = active[i];
+    }
+  }
+  nActive = j;
+  for (; nextSeg < xPath->length; ++nextSeg) {
+    seg = &xPath->segs[nextSeg];
+    if (seg->flags & splashXPathFlip) {
+      segYMin = seg->y1;
+      segYMax = seg->y0;
+    } else {
+      segYMin = seg->y0;
+      segYMax = seg->y1;
+    }
+    if (segYMin >= y + 1) {
+      break;
+    }
+    // horizontal segments don't cover anything
+    if (segYMax > y && !(seg->flags & splashXPathHoriz)) {
+      active[nActive++] = nextSeg;
+    }
+  }
+
+  // accumulate the area deltas of the pieces of segments in the line
+  for (i = 0; i < nActive; ++i) {
+    seg = &xPath->segs[active[i]];
+    if (seg->flags & splashXPathFlip) {
+      segYMin = seg->y1;
+      segYMax = seg->y0;
+    } else {
+      segYMin = seg->y0;
+      segYMax = seg->y1;
+    }
+    ya = segYMin > y ? segYMin : (SplashCoord)y;
+    yb = segYMax < y + 1 ? segYMax : (SplashCoord)(y + 1);
+    if (ya >= yb) {
+      continue;
+    }
+    if (seg->flags & splashXPathVert) {
+      xa = xb = seg->x0;
+    } else {
+      xa = seg->x0 + (ya - seg->y0) * seg->dxdy;
+      xb = seg->x0 + (yb - seg->y0) * seg->dxdy;
+    }
+    addLine((double)xa, (double)xb,
+	    (seg->flags & splashXPathFlip) ? (double)(ya - yb)
+	                                   : (double)(yb - ya));
+  }
+  if (accMin > accMax) {
+    return;
+  }
+
+  // the coverage is the running sum of the deltas
+  width = xMax - xMin + 1;
+  sum = 0;
+  c = 0;
+  for (x = accMin; x <= accMax; ++x) {
+    sum += acc[x];
+    acc[x] = 0;
+    if (x >= width) {
+      continue;
+    }
+    cover = fabs(sum);
+    if (eo) {
+      cover -= 2 * floor(cover * 0.5);
+      if (cover > 1) {
+	cover = 2 - cover;
+      }
+    } else if (cover > 1) {
+      cover = 1;
+    }
+    c = (Guchar)(cover * 255 + 0.5);
+    if (c) {
+      if (*x0 > xMax) {
+	*x0 = xMin + x;
+      }
+      *x1 = xMin + x;
+    }
+    line[xMin + x] = c;
+  }
+  // parts of the path right of the pixels leave the rest covered
+  if (c && accMax < width - 1) {
+    memset(line + xMin + accMax + 1, c, width - 1 - accMax);
+    *x1 = xMax;
+  }
+  accMin = width + 2;
+  accMax = -1;
+}
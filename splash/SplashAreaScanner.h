@@ -0,0 +1,71 @@
+//========================================================================
+//
+// SplashAreaScanner.h
+//
+// This file is licensed under the GPLv2 or later
+//
+//========================================================================
+
+#ifndef SPLASHAREASCANNER_H
+#define SPLASHAREASCANNER_H
+
+#include "SplashTypes.h"
+
+class SplashXPath;
+
+//------------------------------------------------------------------------
+// SplashAreaScanner
+//
+// Computes how much of the area of each pixel a path covers, one line
+// at a time, by accumulating the signed area each segment leaves at
+// its right, as TrueType rasterizers do.  This is the anti-aliasing of
+// splashAAQualityAnalytic.
+//------------------------------------------------------------------------
+
+class SplashAreaScanner {
+public:
+
+  // Create a new SplashAreaScanner object for the pixels in
+  // [<clipXMin>, <clipXMax>] x [<clipYMin>, <clipYMax>].  <xPathA> must
+  // be sorted, and not scaled for anti-aliasing.
+  SplashAreaScanner(SplashXPath *xPathA, GBool eoA,
+		    int clipXMin, int clipXMax, int clipYMin, int clipYMax);
+
+  ~SplashAreaScanner();
+
+  SplashAreaScanner(const SplashAreaScanner&) = delete;
+  SplashAreaScanner& operator=(const SplashAreaScanner&) = delete;
+
+  // Return the path's bounding box.
+  void getBBox(int *xMinA, int *yMinA, int *xMaxA, int *yMaxA)
+    { *xMinA = xMin; *yMinA = yMin; *xMaxA = xMax; *yMaxA = yMax; }
+
+  // Returns true if at least part of the path was outside the clip
+  // bounds passed to the constructor.
+  GBool hasPartialClip() { return partialClip; }
+
+  // Computes the coverage of the pixels of line <y>, from 0 to 255,
+  // into <line>, indexed by x.  Returns the min and max x coordinates
+  // with non-zero coverage in <x0> and <x1> (<x0> > <x1> if there are
+  // none); <line> is left untouched outside of them.  Lines are
+  // fastest in increasing order.
+  void renderLine(Guchar *line, int *x0, int *x1, int y);
+
+private:
+
+  void addLine(double xa, double xb, double d);
+
+  SplashXPath *xPath;
+  GBool eo;
+  int xMin, yMin, xMax, yMax;
+  GBool partialClip;
+
+  double *acc;			// area deltas for x in [xMin, xMax + 2]
+  int accMin, accMax;		// range of non-zero <acc> entries
+  int *active;			// segments crossing the current line
+  int nActive;
+  int nextSeg;			// next segment to become active
+  int lineY;			// current line
+};
+
+#endif
@@ -335,6 +335,72 @@ SplashClipResult SplashClip::testSpan(int spanXMin, int spanXMax, int spanY) {
   return splashClipAllInside;
 }
 
+// Returns the smallest x such that x * <n> >= <xx>.
+static inline int divCeil(int xx, int n) {
+  return xx >= 0 ? (xx + n - 1) / n : -(-xx / n);
+}
+
+// Returns the largest x such that x * <n> <= <xx>.
+static inline int divFloor(int xx, int n) {
+  return xx >= 0 ? xx / n : -((-xx + n - 1) / n);
+}
+
+GBool SplashClip::getInsideSpan(int x0, int x1, int y,
+				int *spanX0, int *spanX1) {
+  int n, xa, xb, xx0, xx1, px0, px1, i;
+  GBool moved;
+
+  if (y < yMinI || y > yMaxI) {
+    return gFalse;
+  }
+  if (x0 < xMinI) {
+    x0 = xMinI;
+  }
+  if (x1 > xMaxI) {
+    x1 = xMaxI;
+  }
+
+  // a pixel is inside a path if its top-left sample is, so each span of
+  // samples covers the pixels whose samples it contains; move x0 right
+  // until it is inside all the paths
+  n = antialias ? splashAASize : 1;
+  xa = x0;
+  do {
+    if (xa > x1) {
+      return gFalse;
+    }
+    moved = gFalse;
+    xb = x1;
+    for (i = 0; i < length; ++i) {
+      if (!scanners[i]->getSpanFrom(xa * n, y * n, &xx0, &xx1)) {
+	return gFalse;
+      }
+      px0 = divCeil(xx0, n);
+      px1 = divFloor(xx1, n);
+      if (px0 > px1) {
+	// no sample of this span is at a pixel
+	xa = px1 + 1;
+	moved = gTrue;
+	break;
+      }
+      if (px0 > xa) {
+	xa = px0;
+	moved = gTrue;
+	break;
+      }
+      if (px1 < xb) {
+	xb = px1;
+      }
+    }
+  } while (moved);
+  if (xa > x1) {
+    return gFalse;
+  }
+  *spanX0 = xa;
+  *spanX1 = xb;
+  return gTrue;
+}
+
 void SplashClip::clipAALine(SplashBitmap *aaBuf, int *x0, int *x1, int y, GBool adjustVertLine) {
   int xx0, xx1, xx, yy, i;
   SplashColorPtr p;
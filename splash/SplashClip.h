@@ -117,6 +117,12 @@ public:
   // Similar to testRect, but tests a horizontal span.
   SplashClipResult testSpan(int spanXMin, int spanXMax, int spanY);
 
+  // Finds the first run [<spanX0>, <spanX1>] of pixels of line <y>,
+  // within [<x0>, <x1>], that are inside the clip region -- the pixels
+  // for which test() is true -- by intersecting the spans of the clip
+  // paths.  Returns false if there is none.
+  GBool getInsideSpan(int x0, int x1, int y, int *spanX0, int *spanX1);
+
   // Clips an anti-aliased line by setting pixels to zero.  On entry,
   // all non-zero pixels are between <x0> and <x1>.  This function
   // will update <x0> and <x1>.
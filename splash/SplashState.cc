@@ -93,6 +93,7 @@ SplashState::SplashState(int width, int height, GBool vectorAntialias,
       deviceNTransfer[cp][i] = (Guchar)i;
 #endif
   }
+  identityTransfer = gTrue;
   overprintMask = 0xffffffff;
   overprintAdditive = gFalse;
   next = nullptr;
@@ -146,6 +147,7 @@ SplashState::SplashState(int width, int height, GBool vectorAntialias,
       deviceNTransfer[cp][i] = (Guchar)i;
 #endif
   }
+  identityTransfer = gTrue;
   overprintMask = 0xffffffff;
   overprintAdditive = gFalse;
   next = nullptr;
@@ -188,6 +190,7 @@ SplashState::SplashState(SplashState *state) {
   memcpy(rgbTransferG, state->rgbTransferG, 256);
   memcpy(rgbTransferB, state->rgbTransferB, 256);
   memcpy(grayTransfer, state->grayTransfer, 256);
+  identityTransfer = state->identityTransfer;
 #ifdef SPLASH_CMYK
   memcpy(cmykTransferC, state->cmykTransferC, 256);
   memcpy(cmykTransferM, state->cmykTransferM, 256);
@@ -270,4 +273,9 @@ void SplashState::setTransfer(Guchar *red, Guchar *green, Guchar *blue,
   memcpy(rgbTransferG, green, 256);
   memcpy(rgbTransferB, blue, 256);
   memcpy(grayTransfer, gray, 256);
+  identityTransfer = gTrue;
+  for (int j = 0; j < 256 && identityTransfer; ++j) {
+    identityTransfer = rgbTransferR[j] == j && rgbTransferG[j] == j &&
+                       rgbTransferB[j] == j && grayTransfer[j] == j;
+  }
 }
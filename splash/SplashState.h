@@ -129,6 +129,8 @@ private:
          rgbTransferG[256],
          rgbTransferB[256];
   Guchar grayTransfer[256];
+  GBool identityTransfer;	// are the RGB and gray transfers all
+				//   identities?
 #ifdef SPLASH_CMYK
   Guchar cmykTransferC[256],
          cmykTransferM[256],
@@ -47,6 +47,17 @@ typedef double SplashCoord;
 
 #define splashAASize 4
 
+// the supersampling of splashAAQualityDraft
+#define splashAADraftSize 2
+
+enum SplashAAQuality {
+  splashAAQualityNormal,	// splashAASize x splashAASize supersampling
+  splashAAQualityDraft,		// splashAADraftSize x splashAADraftSize
+				//   supersampling, faster, for thumbnails
+  splashAAQualityAnalytic	// exact area of each pixel covered by
+				//   the path
+};
+
 #ifndef SPOT_NCOMPS
 #define SPOT_NCOMPS 4
 #endif
@@ -456,15 +456,15 @@ struct cmpXPathSegsFunctor {
   }
 };
 
-void SplashXPath::aaScale() {
+void SplashXPath::aaScale(int aaSize) {
   SplashXPathSeg *seg;
   int i;
 
   for (i = 0, seg = segs; i < length; ++i, ++seg) {
-    seg->x0 *= splashAASize;
-    seg->y0 *= splashAASize;
-    seg->x1 *= splashAASize;
-    seg->y1 *= splashAASize;
+    seg->x0 *= aaSize;
+    seg->y0 *= aaSize;
+    seg->x1 *= aaSize;
+    seg->y1 *= aaSize;
   }
 }
 
@@ -76,9 +76,9 @@ public:
   SplashXPath(const SplashXPath&) = delete;
   SplashXPath& operator=(const SplashXPath&) = delete;
 
-  // Multiply all coordinates by splashAASize, in preparation for
+  // Multiply all coordinates by <aaSize>, in preparation for
   // anti-aliased rendering.
-  void aaScale();
+  void aaScale(int aaSize = splashAASize);
 
   // Sort by upper coordinate (lower y), in y-major order.
   void sort();
@@ -104,6 +104,7 @@ protected:
   int length, size;		// length and size of segs array
 
   friend class SplashXPathScanner;
+  friend class SplashAreaScanner;
   friend class SplashClip;
   friend class Splash;
 };
@@ -37,18 +37,28 @@
 
 //------------------------------------------------------------------------
 
+// lines between two saved states of the active segments
+#define splashXPathScanCheckpoint 32
+
 struct SplashIntersect {
-  int y;
   int x0, x1;			// intersection of segment with [y, y+1)
   int count;			// EO/NZWN counter increment
 };
 
 struct cmpIntersectFunctor {
   bool operator()(const SplashIntersect &i0, const SplashIntersect &i1) {
-    return (i0.y != i1.y) ? (i0.y < i1.y) : (i0.x0 < i1.x0);
+    return i0.x0 < i1.x0;
   }
 };
 
+static inline SplashCoord getSegYMin(SplashXPathSeg *seg) {
+  return (seg->flags & splashXPathFlip) ? seg->y1 : seg->y0;
+}
+
+static inline SplashCoord getSegYMax(SplashXPathSeg *seg) {
+  return (seg->flags & splashXPathFlip) ? seg->y0 : seg->y1;
+}
+
 //------------------------------------------------------------------------
 // SplashXPathScanner
 //------------------------------------------------------------------------
@@ -119,15 +129,31 @@ SplashXPathScanner::SplashXPathScanner(SplashXPath *xPathA, GBool eoA,
     }
   }
 
-  allInter = nullptr;
-  inter = nullptr;
-  computeIntersections();
+  active = nullptr;
+  nActive = activeSize = 0;
+  activeY = yMin - 1;
+  nextSeg = 0;
+  ckActive = nullptr;
+  ckActiveLen = ckActiveSize = 0;
+  ckStart = nullptr;
+  ckNextSeg = nullptr;
+  nCheckpoints = ckSize = 0;
+  lineInter = nullptr;
+  lineInterLen = lineInterSize = 0;
+  lineY = yMin - 1;
+  lineSpans = nullptr;
+  nLineSpans = -1;
+  lineSpansSize = 0;
   interY = yMin - 1;
 }
 
 SplashXPathScanner::~SplashXPathScanner() {
-  gfree(inter);
-  gfree(allInter);
+  gfree(active);
+  gfree(ckActive);
+  gfree(ckStart);
+  gfree(ckNextSeg);
+  gfree(lineInter);
+  gfree(lineSpans);
 }
 
 void SplashXPathScanner::getBBoxAA(int *xMinA, int *yMinA,
@@ -139,20 +165,15 @@ void SplashXPathScanner::getBBoxAA(int *xMinA, int *yMinA,
 }
 
 void SplashXPathScanner::getSpanBounds(int y, int *spanXMin, int *spanXMax) {
-  int interBegin, interEnd, xx, i;
-
-  if (y < yMin || y > yMax) {
-    interBegin = interEnd = 0;
-  } else {
-    interBegin = inter[y - yMin];
-    interEnd = inter[y - yMin + 1];
-  }
-  if (interBegin < interEnd) {
-    *spanXMin = allInter[interBegin].x0;
-    xx = allInter[interBegin].x1;
-    for (i = interBegin + 1; i < interEnd; ++i) {
-      if (allInter[i].x1 > xx) {
-	xx = allInter[i].x1;
+  int xx, i;
+
+  computeLine(y);
+  if (lineInterLen > 0) {
+    *spanXMin = lineInter[0].x0;
+    xx = lineInter[0].x1;
+    for (i = 1; i < lineInterLen; ++i) {
+      if (lineInter[i].x1 > xx) {
+	xx = lineInter[i].x1;
       }
     }
     *spanXMax = xx;
@@ -163,82 +184,110 @@ void SplashXPathScanner::getSpanBounds(int y, int *spanXMin, int *spanXMax) {
 }
 
 GBool SplashXPathScanner::test(int x, int y) {
-  int interBegin, interEnd, count, i;
+  int count, i;
 
   if (y < yMin || y > yMax) {
     return gFalse;
   }
-  interBegin = inter[y - yMin];
-  interEnd = inter[y - yMin + 1];
+  computeLine(y);
   count = 0;
-  for (i = interBegin; i < interEnd && allInter[i].x0 <= x; ++i) {
-    if (x <= allInter[i].x1) {
+  for (i = 0; i < lineInterLen && lineInter[i].x0 <= x; ++i) {
+    if (x <= lineInter[i].x1) {
       return gTrue;
     }
-    count += allInter[i].count;
+    count += lineInter[i].count;
   }
   return eo ? (count & 1) : (count != 0);
 }
 
 GBool SplashXPathScanner::testSpan(int x0, int x1, int y) {
-  int interBegin, interEnd, count, xx1, i;
+  int count, xx1, i;
 
   if (y < yMin || y > yMax) {
     return gFalse;
   }
-  interBegin = inter[y - yMin];
-  interEnd = inter[y - yMin + 1];
+  computeLine(y);
   count = 0;
-  for (i = interBegin; i < interEnd && allInter[i].x1 < x0; ++i) {
-    count += allInter[i].count;
+  for (i = 0; i < lineInterLen && lineInter[i].x1 < x0; ++i) {
+    count += lineInter[i].count;
   }
 
   // invariant: the subspan [x0,xx1] is inside the path
   xx1 = x0 - 1;
   while (xx1 < x1) {
-    if (i >= interEnd) {
+    if (i >= lineInterLen) {
       return gFalse;
     }
-    if (allInter[i].x0 > xx1 + 1 &&
+    if (lineInter[i].x0 > xx1 + 1 &&
 	!(eo ? (count & 1) : (count != 0))) {
       return gFalse;
     }
-    if (allInter[i].x1 > xx1) {
-      xx1 = allInter[i].x1;
+    if (lineInter[i].x1 > xx1) {
+      xx1 = lineInter[i].x1;
     }
-    count += allInter[i].count;
+    count += lineInter[i].count;
     ++i;
   }
 
   return gTrue;
 }
 
+GBool SplashXPathScanner::getSpanFrom(int x, int y, int *x0, int *x1) {
+  int lo, hi, mid;
+
+  if (y < yMin || y > yMax) {
+    return gFalse;
+  }
+  computeLine(y);
+  if (nLineSpans < 0) {
+    computeSpans();
+  }
+
+  // find the first span that ends at or after x
+  lo = 0;
+  hi = nLineSpans;
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (lineSpans[2 * mid + 1] < x) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == nLineSpans) {
+    return gFalse;
+  }
+  *x0 = lineSpans[2 * lo];
+  *x1 = lineSpans[2 * lo + 1];
+  return gTrue;
+}
+
 GBool SplashXPathScanner::getNextSpan(int y, int *x0, int *x1) {
-  int interEnd, xx0, xx1;
+  int xx0, xx1;
 
   if (y < yMin || y > yMax) {
     return gFalse;
   }
+  computeLine(y);
   if (interY != y) {
     interY = y;
-    interIdx = inter[y - yMin];
+    interIdx = 0;
     interCount = 0;
   }
-  interEnd = inter[y - yMin + 1];
-  if (interIdx >= interEnd) {
+  if (interIdx >= lineInterLen) {
     return gFalse;
   }
-  xx0 = allInter[interIdx].x0;
-  xx1 = allInter[interIdx].x1;
-  interCount += allInter[interIdx].count;
+  xx0 = lineInter[interIdx].x0;
+  xx1 = lineInter[interIdx].x1;
+  interCount += lineInter[interIdx].count;
   ++interIdx;
-  while (interIdx < interEnd &&
-	 (allInter[interIdx].x0 <= xx1 ||
+  while (interIdx < lineInterLen &&
+	 (lineInter[interIdx].x0 <= xx1 ||
 	  (eo ? (interCount & 1) : (interCount != 0)))) {
-    if (allInter[interIdx].x1 > xx1) {
-      xx1 = allInter[interIdx].x1;
+    if (lineInter[interIdx].x1 > xx1) {
+      xx1 = lineInter[interIdx].x1;
     }
-    interCount += allInter[interIdx].count;
+    interCount += lineInter[interIdx].count;
     ++interIdx;
   }
   *x0 = xx0;
@@ -246,50 +295,55 @@ GBool SplashXPathScanner::getNextSpan(int y, int *x0, int *x1) {
   return gTrue;
 }
 
-void SplashXPathScanner::computeIntersections() {
+// Makes <lineInter> the intersections of the path with line <y>.
+void SplashXPathScanner::computeLine(int y) {
   SplashXPathSeg *seg;
   SplashCoord segXMin, segXMax, segYMin, segYMax, xx0, xx1;
-  int x, y, y0, y1, i;
+  int ck, i;
 
-  if (yMin > yMax) {
+  if (y == lineY) {
+    return;
+  }
+  lineY = y;
+  lineInterLen = 0;
+  nLineSpans = -1;
+  if (y < yMin || y > yMax) {
     return;
   }
 
-  // build the list of all intersections
-  allInterLen = 0;
-  allInterSize = 16;
-  allInter = (SplashIntersect *)gmallocn(allInterSize,
-					 sizeof(SplashIntersect));
-  for (i = 0; i < xPath->length; ++i) {
-    seg = &xPath->segs[i];
-    if (seg->flags & splashXPathFlip) {
-      segYMin = seg->y1;
-      segYMax = seg->y0;
-    } else {
-      segYMin = seg->y0;
-      segYMax = seg->y1;
-    }
+  // going back up, or far down to a line already passed, starts again
+  // from the last checkpoint before it
+  ck = (y - yMin) / splashXPathScanCheckpoint;
+  if (ck >= nCheckpoints) {
+    ck = nCheckpoints - 1;
+  }
+  if (ck >= 0 &&
+      (y < activeY || yMin + ck * splashXPathScanCheckpoint > activeY)) {
+    restoreCheckpoint(ck);
+  }
+  while (yMin + nCheckpoints * splashXPathScanCheckpoint <= y) {
+    advance(yMin + nCheckpoints * splashXPathScanCheckpoint);
+    saveCheckpoint();
+  }
+  advance(y);
+
+  if (lineInterSize < nActive) {
+    lineInterSize = nActive;
+    lineInter = (SplashIntersect *)greallocn(lineInter, lineInterSize,
+					     sizeof(SplashIntersect));
+  }
+  for (i = 0; i < nActive; ++i) {
+    seg = &xPath->segs[active[i]];
+    segYMin = getSegYMin(seg);
+    segYMax = getSegYMax(seg);
     if (seg->flags & splashXPathHoriz) {
-      y = splashFloor(seg->y0);
-      if (y >= yMin && y <= yMax) {
-	if (!addIntersection(segYMin, segYMax, seg->flags,
-			y, splashFloor(seg->x0), splashFloor(seg->x1)))
-          break;
+      if (splashFloor(seg->y0) == y) {
+	addIntersection(segYMin, segYMax, seg->flags,
+			splashFloor(seg->x0), splashFloor(seg->x1), y);
       }
     } else if (seg->flags & splashXPathVert) {
-      y0 = splashFloor(segYMin);
-      if (y0 < yMin) {
-	y0 = yMin;
-      }
-      y1 = splashFloor(segYMax);
-      if (y1 > yMax) {
-	y1 = yMax;
-      }
-      x = splashFloor(seg->x0);
-      for (y = y0; y <= y1; ++y) {
-	if (!addIntersection(segYMin, segYMax, seg->flags, y, x, x))
-          break;
-      }
+      addIntersection(segYMin, segYMax, seg->flags,
+		      splashFloor(seg->x0), splashFloor(seg->x0), y);
     } else {
       if (seg->x0 < seg->x1) {
 	segXMin = seg->x0;
@@ -298,157 +352,208 @@ void SplashXPathScanner::computeIntersections() {
 	segXMin = seg->x1;
 	segXMax = seg->x0;
       }
-      y0 = splashFloor(segYMin);
-      if (y0 < yMin) {
-	y0 = yMin;
+      xx0 = seg->x0 + ((SplashCoord)y - seg->y0) * seg->dxdy;
+      xx1 = seg->x0 + ((SplashCoord)(y + 1) - seg->y0) * seg->dxdy;
+      // the segment may not actually extend to the top and/or bottom edges
+      if (xx0 < segXMin) {
+	xx0 = segXMin;
+      } else if (xx0 > segXMax) {
+	xx0 = segXMax;
       }
-      y1 = splashFloor(segYMax);
-      if (y1 > yMax) {
-	y1 = yMax;
-      }
-      // this loop could just add seg->dxdy to xx1 on each iteration,
-      // but that introduces numerical accuracy problems
-      xx1 = seg->x0 + ((SplashCoord)y0 - seg->y0) * seg->dxdy;
-      for (y = y0; y <= y1; ++y) {
-	xx0 = xx1;
-	xx1 = seg->x0 + ((SplashCoord)(y + 1) - seg->y0) * seg->dxdy;
-	// the segment may not actually extend to the top and/or bottom edges
-	if (xx0 < segXMin) {
-	  xx0 = segXMin;
-	} else if (xx0 > segXMax) {
-	  xx0 = segXMax;
-	}
-	if (xx1 < segXMin) {
-	  xx1 = segXMin;
-	} else if (xx1 > segXMax) {
-	  xx1 = segXMax;
-	}
-	if (!addIntersection(segYMin, segYMax, seg->flags, y,
-			splashFloor(xx0), splashFloor(xx1)))
-          break;
+      if (xx1 < segXMin) {
+	xx1 = segXMin;
+      } else if (xx1 > segXMax) {
+	xx1 = segXMax;
       }
+      addIntersection(segYMin, segYMax, seg->flags,
+		      splashFloor(xx0), splashFloor(xx1), y);
     }
   }
-  std::sort(allInter, allInter + allInterLen, cmpIntersectFunctor());
+  std::sort(lineInter, lineInter + lineInterLen, cmpIntersectFunctor());
+}
 
-  // build the list of y pointers
-  inter = (int *)gmallocn(yMax - yMin + 2, sizeof(int));
-  i = 0;
-  for (y = yMin; y <= yMax; ++y) {
-    inter[y - yMin] = i;
-    while (i < allInterLen && allInter[i].y <= y) {
-      ++i;
+// Moves the active segments down to line <y>, which must not be above
+// <activeY>.
+void SplashXPathScanner::advance(int y) {
+  SplashXPathSeg *seg;
+  int i, j;
+
+  // drop the segments that end above y
+  for (i = j = 0; i < nActive; ++i) {
+    if (splashFloor(getSegYMax(&xPath->segs[active[i]])) >= y) {
+      active[j++] = active[i];
     }
   }
-  inter[yMax - yMin + 1] = i;
+  nActive = j;
+
+  // add the ones that start at or above y -- the segments are sorted by
+  // their top
+  for (; nextSeg < xPath->length; ++nextSeg) {
+    seg = &xPath->segs[nextSeg];
+    if (splashFloor(getSegYMin(seg)) > y) {
+      break;
+    }
+    if (splashFloor(getSegYMax(seg)) >= y) {
+      if (nActive == activeSize) {
+	activeSize = activeSize ? 2 * activeSize : 16;
+	active = (int *)greallocn(active, activeSize, sizeof(int));
+      }
+      active[nActive++] = nextSeg;
+    }
+  }
+  activeY = y;
 }
 
-GBool SplashXPathScanner::addIntersection(double segYMin, double segYMax,
-					 Guint segFlags,
-					 int y, int x0, int x1) {
-  if (allInterLen == allInterSize) {
-    unsigned int newInterSize = ((unsigned int) allInterSize * 2 > INT_MAX / sizeof(SplashIntersect)) ? allInterSize + 32768 : allInterSize * 2;
-    if (newInterSize >= INT_MAX / sizeof(SplashIntersect)) {
-      error(errInternal, -1, "Bogus memory allocation size in SplashXPathScanner::addIntersection {0:d}", newInterSize);
-      return gFalse;
+void SplashXPathScanner::saveCheckpoint() {
+  if (nCheckpoints == ckSize) {
+    ckSize = ckSize ? 2 * ckSize : 16;
+    ckStart = (int *)greallocn(ckStart, ckSize + 1, sizeof(int));
+    ckNextSeg = (int *)greallocn(ckNextSeg, ckSize, sizeof(int));
+  }
+  if (ckActiveLen + nActive > ckActiveSize) {
+    ckActiveSize = ckActiveSize ? 2 * ckActiveSize : 64;
+    if (ckActiveSize < ckActiveLen + nActive) {
+      ckActiveSize = ckActiveLen + nActive;
     }
-    allInterSize = newInterSize;
-    allInter = (SplashIntersect *)greallocn(allInter, newInterSize,
-					    sizeof(SplashIntersect));
+    ckActive = (int *)greallocn(ckActive, ckActiveSize, sizeof(int));
+  }
+  if (nActive > 0) {
+    memcpy(ckActive + ckActiveLen, active, nActive * sizeof(int));
   }
-  allInter[allInterLen].y = y;
+  ckStart[nCheckpoints] = ckActiveLen;
+  ckNextSeg[nCheckpoints] = nextSeg;
+  ckActiveLen += nActive;
+  ++nCheckpoints;
+  ckStart[nCheckpoints] = ckActiveLen;
+}
+
+void SplashXPathScanner::restoreCheckpoint(int ck) {
+  nActive = ckStart[ck + 1] - ckStart[ck];
+  if (nActive > activeSize) {
+    activeSize = nActive;
+    active = (int *)greallocn(active, activeSize, sizeof(int));
+  }
+  if (nActive > 0) {
+    memcpy(active, ckActive + ckStart[ck], nActive * sizeof(int));
+  }
+  nextSeg = ckNextSeg[ck];
+  activeY = yMin + ck * splashXPathScanCheckpoint;
+}
+
+void SplashXPathScanner::addIntersection(double segYMin, double segYMax,
+					 Guint segFlags,
+					 int x0, int x1, int y) {
+  SplashIntersect *inter;
+
+  inter = &lineInter[lineInterLen];
   if (x0 < x1) {
-    allInter[allInterLen].x0 = x0;
-    allInter[allInterLen].x1 = x1;
+    inter->x0 = x0;
+    inter->x1 = x1;
   } else {
-    allInter[allInterLen].x0 = x1;
-    allInter[allInterLen].x1 = x0;
+    inter->x0 = x1;
+    inter->x1 = x0;
   }
   if (segYMin <= y &&
       (SplashCoord)y < segYMax &&
       !(segFlags & splashXPathHoriz)) {
-    allInter[allInterLen].count = eo ? 1
-                                     : (segFlags & splashXPathFlip) ? 1 : -1;
+    inter->count = eo ? 1 : (segFlags & splashXPathFlip) ? 1 : -1;
   } else {
-    allInter[allInterLen].count = 0;
+    inter->count = 0;
+  }
+  ++lineInterLen;
+}
+
+// Merges the intersections of line <lineY> into the spans inside the
+// path.
+void SplashXPathScanner::computeSpans() {
+  int xx0, xx1, count, i;
+
+  nLineSpans = 0;
+  count = 0;
+  i = 0;
+  while (i < lineInterLen) {
+    xx0 = lineInter[i].x0;
+    xx1 = lineInter[i].x1;
+    count += lineInter[i].count;
+    ++i;
+    while (i < lineInterLen &&
+	   (lineInter[i].x0 <= xx1 || (eo ? (count & 1) : (count != 0)))) {
+      if (lineInter[i].x1 > xx1) {
+	xx1 = lineInter[i].x1;
+      }
+      count += lineInter[i].count;
+      ++i;
+    }
+    if (nLineSpans == lineSpansSize) {
+      lineSpansSize = lineSpansSize ? 2 * lineSpansSize : 16;
+      lineSpans = (int *)greallocn(lineSpans, 2 * lineSpansSize,
+				   sizeof(int));
+    }
+    lineSpans[2 * nLineSpans] = xx0;
+    lineSpans[2 * nLineSpans + 1] = xx1;
+    ++nLineSpans;
   }
-  ++allInterLen;
-  return gTrue;
 }
 
 void SplashXPathScanner::renderAALine(SplashBitmap *aaBuf,
 				      int *x0, int *x1, int y, GBool adjustVertLine) {
-  int xx0, xx1, xx, xxMin, xxMax, yy, interEnd;
+  int xx0, xx1, xx, xxMin, xxMax, yy, count, i;
   Guchar mask;
   SplashColorPtr p;
 
   memset(aaBuf->getDataPtr(), 0, aaBuf->getRowSize() * aaBuf->getHeight());
   xxMin = aaBuf->getWidth();
   xxMax = -1;
-  if (yMin <= yMax) {
-    if (splashAASize * y < yMin) {
-      interIdx = inter[0];
-    } else if (splashAASize * y > yMax) {
-      interIdx = inter[yMax - yMin + 1];
-    } else {
-      interIdx = inter[splashAASize * y - yMin];
-    }
-    for (yy = 0; yy < splashAASize; ++yy) {
-      if (splashAASize * y + yy < yMin) {
-	interEnd = inter[0];
-      } else if (splashAASize * y + yy > yMax) {
-	interEnd = inter[yMax - yMin + 1];
-      } else {
-	interEnd = inter[splashAASize * y + yy - yMin + 1];
-      }
-      interCount = 0;
-      while (interIdx < interEnd) {
-	xx0 = allInter[interIdx].x0;
-	xx1 = allInter[interIdx].x1;
-	interCount += allInter[interIdx].count;
-	++interIdx;
-	while (interIdx < interEnd &&
-	       (allInter[interIdx].x0 <= xx1 ||
-		(eo ? (interCount & 1) : (interCount != 0)))) {
-	  if (allInter[interIdx].x1 > xx1) {
-	    xx1 = allInter[interIdx].x1;
-	  }
-	  interCount += allInter[interIdx].count;
-	  ++interIdx;
-	}
-	if (xx0 < 0) {
-	  xx0 = 0;
-	}
-	++xx1;
-	if (xx1 > aaBuf->getWidth()) {
-	  xx1 = aaBuf->getWidth();
+  for (yy = 0; yy < splashAASize; ++yy) {
+    computeLine(splashAASize * y + yy);
+    count = 0;
+    i = 0;
+    while (i < lineInterLen) {
+      xx0 = lineInter[i].x0;
+      xx1 = lineInter[i].x1;
+      count += lineInter[i].count;
+      ++i;
+      while (i < lineInterLen &&
+	     (lineInter[i].x0 <= xx1 ||
+	      (eo ? (count & 1) : (count != 0)))) {
+	if (lineInter[i].x1 > xx1) {
+	  xx1 = lineInter[i].x1;
 	}
-	// set [xx0, xx1) to 1
-	if (xx0 < xx1) {
-	  xx = xx0;
-	  p = aaBuf->getDataPtr() + yy * aaBuf->getRowSize() + (xx >> 3);
-	  if (xx & 7) {
-	    mask = adjustVertLine ? 0xff : 0xff >> (xx & 7);
-	    if (!adjustVertLine && (xx & ~7) == (xx1 & ~7)) {
-	      mask &= (Guchar)(0xff00 >> (xx1 & 7));
-	    }
-	    *p++ |= mask;
-	    xx = (xx & ~7) + 8;
-	  }
-	  for (; xx + 7 < xx1; xx += 8) {
-	    *p++ |= 0xff;
-	  }
-	  if (xx < xx1) {
-	    *p |= adjustVertLine ? 0xff : (Guchar)(0xff00 >> (xx1 & 7));
+	count += lineInter[i].count;
+	++i;
+      }
+      if (xx0 < 0) {
+	xx0 = 0;
+      }
+      ++xx1;
+      if (xx1 > aaBuf->getWidth()) {
+	xx1 = aaBuf->getWidth();
+      }
+      // set [xx0, xx1) to 1
+      if (xx0 < xx1) {
+	xx = xx0;
+	p = aaBuf->getDataPtr() + yy * aaBuf->getRowSize() + (xx >> 3);
+	if (xx & 7) {
+	  mask = adjustVertLine ? 0xff : 0xff >> (xx & 7);
+	  if (!adjustVertLine && (xx & ~7) == (xx1 & ~7)) {
+	    mask &= (Guchar)(0xff00 >> (xx1 & 7));
 	  }
+	  *p++ |= mask;
+	  xx = (xx & ~7) + 8;
 	}
-	if (xx0 < xxMin) {
-	  xxMin = xx0;
+	for (; xx + 7 < xx1; xx += 8) {
+	  *p++ |= 0xff;
 	}
-	if (xx1 > xxMax) {
-	  xxMax = xx1;
+	if (xx < xx1) {
+	  *p |= adjustVertLine ? 0xff : (Guchar)(0xff00 >> (xx1 & 7));
 	}
       }
+      if (xx0 < xxMin) {
+	xxMin = xx0;
+      }
+      if (xx1 > xxMax) {
+	xxMax = xx1;
+      }
     }
   }
   if (xxMin > xxMax) {
@@ -460,65 +565,53 @@ void SplashXPathScanner::renderAALine(SplashBitmap *aaBuf,
 
 void SplashXPathScanner::clipAALine(SplashBitmap *aaBuf,
 				    int *x0, int *x1, int y) {
-  int xx0, xx1, xx, yy, interEnd;
+  int xx0, xx1, xx, yy, count, i;
   Guchar mask;
   SplashColorPtr p;
 
   for (yy = 0; yy < splashAASize; ++yy) {
     xx = *x0 * splashAASize;
-    if (yMin <= yMax) {
-      if (splashAASize * y + yy < yMin) {
-	interIdx = interEnd = inter[0];
-      } else if (splashAASize * y + yy > yMax) {
-	interIdx = interEnd = inter[yMax - yMin + 1];
-      } else {
-	interIdx = inter[splashAASize * y + yy - yMin];
-	if (splashAASize * y + yy > yMax) {
-	  interEnd = inter[yMax - yMin + 1];
-	} else {
-	  interEnd = inter[splashAASize * y + yy - yMin + 1];
+    computeLine(splashAASize * y + yy);
+    count = 0;
+    i = 0;
+    while (i < lineInterLen && xx < (*x1 + 1) * splashAASize) {
+      xx0 = lineInter[i].x0;
+      xx1 = lineInter[i].x1;
+      count += lineInter[i].count;
+      ++i;
+      while (i < lineInterLen &&
+	     (lineInter[i].x0 <= xx1 ||
+	      (eo ? (count & 1) : (count != 0)))) {
+	if (lineInter[i].x1 > xx1) {
+	  xx1 = lineInter[i].x1;
 	}
+	count += lineInter[i].count;
+	++i;
+      }
+      if (xx0 > aaBuf->getWidth()) {
+	xx0 = aaBuf->getWidth();
       }
-      interCount = 0;
-      while (interIdx < interEnd && xx < (*x1 + 1) * splashAASize) {
-	xx0 = allInter[interIdx].x0;
-	xx1 = allInter[interIdx].x1;
-	interCount += allInter[interIdx].count;
-	++interIdx;
-	while (interIdx < interEnd &&
-	       (allInter[interIdx].x0 <= xx1 ||
-		(eo ? (interCount & 1) : (interCount != 0)))) {
-	  if (allInter[interIdx].x1 > xx1) {
-	    xx1 = allInter[interIdx].x1;
+      // set [xx, xx0) to 0
+      if (xx < xx0) {
+	p = aaBuf->getDataPtr() + yy * aaBuf->getRowSize() + (xx >> 3);
+	if (xx & 7) {
+	  mask = (Guchar)(0xff00 >> (xx & 7));
+	  if ((xx & ~7) == (xx0 & ~7)) {
+	    mask |= 0xff >> (xx0 & 7);
 	  }
-	  interCount += allInter[interIdx].count;
-	  ++interIdx;
+	  *p++ &= mask;
+	  xx = (xx & ~7) + 8;
 	}
-	if (xx0 > aaBuf->getWidth()) {
-	  xx0 = aaBuf->getWidth();
+	for (; xx + 7 < xx0; xx += 8) {
+	  *p++ = 0x00;
 	}
-	// set [xx, xx0) to 0
 	if (xx < xx0) {
-	  p = aaBuf->getDataPtr() + yy * aaBuf->getRowSize() + (xx >> 3);
-	  if (xx & 7) {
-	    mask = (Guchar)(0xff00 >> (xx & 7));
-	    if ((xx & ~7) == (xx0 & ~7)) {
-	      mask |= 0xff >> (xx0 & 7);
-	    }
-	    *p++ &= mask;
-	    xx = (xx & ~7) + 8;
-	  }
-	  for (; xx + 7 < xx0; xx += 8) {
-	    *p++ = 0x00;
-	  }
-	  if (xx < xx0) {
-	    *p &= 0xff >> (xx0 & 7);
-	  }
-	}
-	if (xx1 >= xx) {
-	  xx = xx1 + 1;
+	  *p &= 0xff >> (xx0 & 7);
 	}
       }
+      if (xx1 >= xx) {
+	xx = xx1 + 1;
+      }
     }
     xx0 = (*x1 + 1) * splashAASize;
     if (xx0 > aaBuf->getWidth()) xx0 = aaBuf->getWidth();
@@ -542,3 +635,57 @@ void SplashXPathScanner::clipAALine(SplashBitmap *aaBuf,
     }
   }
 }
+
+void SplashXPathScanner::countAASamples(Guchar *line, int aaSize,
+					int xMinA, int xMaxA,
+					int *x0, int *x1, int y) {
+  int xx0, xx1, xxMin, xxMax, px0, px1, px, yy, i;
+
+  if (xMinA <= xMaxA) {
+    memset(line + xMinA, 0, xMaxA - xMinA + 1);
+  }
+  xxMin = (xMaxA + 1) * aaSize;
+  xxMax = xMinA * aaSize - 1;
+  for (yy = aaSize * y; yy < aaSize * (y + 1); ++yy) {
+    if (yy < yMin || yy > yMax) {
+      continue;
+    }
+    computeLine(yy);
+    if (nLineSpans < 0) {
+      computeSpans();
+    }
+    for (i = 0; i < nLineSpans; ++i) {
+      xx0 = lineSpans[2 * i];
+      xx1 = lineSpans[2 * i + 1];
+      if (xx0 < xMinA * aaSize) {
+	xx0 = xMinA * aaSize;
+      }
+      if (xx1 > (xMaxA + 1) * aaSize - 1) {
+	xx1 = (xMaxA + 1) * aaSize - 1;
+      }
+      if (xx0 > xx1) {
+	continue;
+      }
+      if (xx0 < xxMin) {
+	xxMin = xx0;
+      }
+      if (xx1 > xxMax) {
+	xxMax = xx1;
+      }
+      // add the samples [xx0, xx1]
+      px0 = xx0 / aaSize;
+      px1 = xx1 / aaSize;
+      if (px0 == px1) {
+	line[px0] += xx1 - xx0 + 1;
+      } else {
+	line[px0] += (px0 + 1) * aaSize - xx0;
+	for (px = px0 + 1; px < px1; ++px) {
+	  line[px] += aaSize;
+	}
+	line[px1] += xx1 - px1 * aaSize + 1;
+      }
+    }
+  }
+  *x0 = xxMin / aaSize;
+  *x1 = xxMax / aaSize;
+}
@@ -34,6 +34,12 @@ struct SplashIntersect;
 
 //------------------------------------------------------------------------
 // SplashXPathScanner
+//
+// Finds the intersections of the path with one line at a time, from
+// an active edge table updated as the lines go down, so that memory
+// use doesn't grow with the height of the path.  The active edges are
+// saved every few lines, which makes going back up, as clip paths do
+// for each fill, cheap as well.
 //------------------------------------------------------------------------
 
 class SplashXPathScanner {
@@ -69,6 +75,11 @@ public:
   // path.
   GBool testSpan(int x0, int x1, int y);
 
+  // Returns the first span inside the path at <y> that ends at or
+  // after <x> in [<x0>, <x1>] (<x0> may be less than <x>).  Returns
+  // false if there is none.
+  GBool getSpanFrom(int x, int y, int *x0, int *x1);
+
   // Returns the next span inside the path at <y>.  If <y> is
   // different than the previous call to getNextSpan, this returns the
   // first span at <y>; otherwise it returns the next span (relative
@@ -86,25 +97,60 @@ public:
   // will update <x0> and <x1>.
   void clipAALine(SplashBitmap *aaBuf, int *x0, int *x1, int y);
 
+  // Counts how many of the <aaSize> x <aaSize> samples of each pixel
+  // of line <y> are inside the path, which must have been scaled by
+  // <aaSize>, into <line>, indexed by x, for x in [<xMinA>, <xMaxA>].
+  // Returns the min and max x coordinates with non-zero counts in <x0>
+  // and <x1> (<x0> > <x1> if there are none).
+  void countAASamples(Guchar *line, int aaSize, int xMinA, int xMaxA,
+		      int *x0, int *x1, int y);
+
 private:
 
-  void computeIntersections();
-  GBool addIntersection(double segYMin, double segYMax,
-		       Guint segFlags,
-		       int y, int x0, int x1);
+  void computeLine(int y);
+  void advance(int y);
+  void saveCheckpoint();
+  void restoreCheckpoint(int ck);
+  void addIntersection(double segYMin, double segYMax,
+		       Guint segFlags, int x0, int x1, int y);
+  void computeSpans();
 
   SplashXPath *xPath;
   GBool eo;
   int xMin, yMin, xMax, yMax;
   GBool partialClip;
 
-  SplashIntersect *allInter;	// array of intersections
-  int allInterLen;		// number of intersections in <allInter>
-  int allInterSize;		// size of the <allInter> array
-  int *inter;			// indexes into <allInter> for each y value
+  int *active;			// segments that intersect line <activeY>
+  int nActive;			// number of segments in <active>
+  int activeSize;		// size of the <active> array
+  int activeY;			// line of the active segments, yMin - 1
+				//   before the first line
+  int nextSeg;			// first segment not yet active
+
+  int *ckActive;		// active segments at each checkpoint, one
+				//   every splashXPathScanCheckpoint lines
+				//   from yMin
+  int ckActiveLen;		// number of entries in <ckActive>
+  int ckActiveSize;		// size of the <ckActive> array
+  int *ckStart;			// start of each checkpoint in <ckActive>,
+				//   plus the end of the last one
+  int *ckNextSeg;		// <nextSeg> at each checkpoint
+  int nCheckpoints;		// number of checkpoints saved
+  int ckSize;			// size of the <ckStart>/<ckNextSeg> arrays
+
+  SplashIntersect *lineInter;	// intersections with line <lineY>
+  int lineInterLen;		// number of intersections in <lineInter>
+  int lineInterSize;		// size of the <lineInter> array
+  int lineY;			// line of <lineInter>
+  int *lineSpans;		// spans inside the path at line <lineY>,
+				//   as pairs of x values
+  int nLineSpans;		// number of spans in <lineSpans>, -1 if
+				//   they haven't been computed yet
+  int lineSpansSize;		// size of the <lineSpans> array, in spans
+
   int interY;			// current y value - used by getNextSpan
-  int interIdx;			// current index into <inter> - used by
-				//   getNextSpan 
+  int interIdx;			// current index into <lineInter> - used
+				//   by getNextSpan
   int interCount;		// current EO/NZWN counter - used by
 				//   getNextSpan
 };
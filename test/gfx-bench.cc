@@ -0,0 +1,151 @@
+//========================================================================
+//
+// gfx-bench.cc
+//
+// Measures how many content stream operators per second Gfx runs, with
+// an output device that draws nothing: parsing the content streams each
+// time, building their display lists each time and running them, or
+// running them from the display lists already built.
+//
+// This file is licensed under the GPLv2 or later
+//
+//========================================================================
+
+#include <config.h>
+
+#include <stdio.h>
+
+#include "goo/GooString.h"
+#include "goo/GooTimer.h"
+#include "GlobalParams.h"
+#include "Object.h"
+#include "OutputDev.h"
+#include "DisplayList.h"
+#include "PDFDoc.h"
+#include "Page.h"
+#include "parseargs.h"
+
+static int firstPage = 1;
+static int lastPage = 0;
+static int iterations = 10;
+static GBool printHelp = gFalse;
+
+static const ArgDesc argDesc[] = {
+  {"-f",      argInt,      &firstPage,       0,
+   "first page to run"},
+  {"-l",      argInt,      &lastPage,        0,
+   "last page to run"},
+  {"-n",      argInt,      &iterations,      0,
+   "number of times each page is run"},
+  {"-h",      argFlag,     &printHelp,       0,
+   "print usage information"},
+  {"-help",   argFlag,     &printHelp,       0,
+   "print usage information"},
+  {"--help",  argFlag,     &printHelp,       0,
+   "print usage information"},
+  {"-?",      argFlag,     &printHelp,       0,
+   "print usage information"},
+  { }
+};
+
+class NullOutputDev: public OutputDev {
+public:
+  GBool upsideDown() override { return gTrue; }
+  GBool useDrawChar() override { return gTrue; }
+  GBool interpretType3Chars() override { return gFalse; }
+};
+
+enum RunMode {
+  runParsed,			// Gfx::go() on a parser, no display list
+  runListBuilt,			// display lists built, then run
+  runListCached			// display lists from the cache
+};
+
+// Runs the pages n times, returns the time it took in seconds
+static double runPages(PDFDoc *doc, OutputDev *out, int n, RunMode mode)
+{
+  GooTimer timer;
+
+  for (int i = 0; i < n; ++i) {
+    for (int pg = firstPage; pg <= lastPage; ++pg) {
+      if (mode == runListBuilt) {
+        doc->getDisplayListCache()->clear();
+      }
+      // the display list cache is only used with the document's own
+      // xref, not with a copy of it
+      doc->displayPage(out, pg, 72, 72, 0, gFalse, gFalse, gFalse,
+		       nullptr, nullptr, nullptr, nullptr,
+		       mode == runParsed);
+    }
+  }
+  timer.stop();
+  return timer.getElapsed();
+}
+
+int main(int argc, char *argv[])
+{
+  PDFDoc *doc;
+  NullOutputDev out;
+  long nOps;
+  double parseTime, buildTime, listTime;
+
+  GBool ok = parseArgs(argDesc, &argc, argv);
+  if (!ok || argc != 2 || printHelp || iterations < 1) {
+    printUsage(argv[0], "PDF-FILE", argDesc);
+    return printHelp ? 0 : 1;
+  }
+
+  globalParams = new GlobalParams();
+  doc = new PDFDoc(new GooString(argv[1]));
+  if (!doc->isOk()) {
+    fprintf(stderr, "Error loading document\n");
+    delete doc;
+    delete globalParams;
+    return 1;
+  }
+  if (firstPage < 1) {
+    firstPage = 1;
+  }
+  if (lastPage < 1 || lastPage > doc->getNumPages()) {
+    lastPage = doc->getNumPages();
+  }
+
+  // operators of the page contents, those of the forms they draw aren't
+  // counted
+  nOps = 0;
+  for (int pg = firstPage; pg <= lastPage; ++pg) {
+    Object contents = doc->getPage(pg)->getContents();
+    if (contents.isNull()) {
+      continue;
+    }
+    DisplayList *list = DisplayList::parse(doc->getXRef(), &contents, (size_t)-1);
+    if (list) {
+      nOps += list->getNumCmds();
+      list->decRefCnt();
+    } else {
+      printf("page %d has inline images, it is always parsed\n", pg);
+    }
+  }
+  nOps *= iterations;
+
+  // the first run loads fonts and such
+  runPages(doc, &out, 1, runParsed);
+  parseTime = runPages(doc, &out, iterations, runParsed);
+  buildTime = runPages(doc, &out, iterations, runListBuilt);
+
+  // build the display lists first
+  runPages(doc, &out, 1, runListCached);
+  listTime = runPages(doc, &out, iterations, runListCached);
+
+  printf("%ld operators\n", nOps);
+  printf("parsed:              %8.3f s  %12.0f ops/s\n",
+	 parseTime, nOps / parseTime);
+  printf("display list built:  %8.3f s  %12.0f ops/s\n",
+	 buildTime, nOps / buildTime);
+  printf("display list cached: %8.3f s  %12.0f ops/s\n",
+	 listTime, nOps / listTime);
+
+  delete doc;
+  delete globalParams;
+  return 0;
+}
@@ -0,0 +1,142 @@
+//========================================================================
+//
+// jbig2-bench.cc
+//
+// Measures how fast the JBIG2 images of a set of PDF files are decoded,
+// in pixels per second.  Each image is decoded on its own, with its
+// globals, as when a page showing it is rendered.
+//
+// This file is licensed under the GPLv2 or later
+//
+//========================================================================
+
+#include <config.h>
+
+#include <stdio.h>
+
+#include "goo/GooString.h"
+#include "goo/GooTimer.h"
+#include "GlobalParams.h"
+#include "Object.h"
+#include "PDFDoc.h"
+#include "Stream.h"
+#include "XRef.h"
+#include "parseargs.h"
+
+static int iterations = 5;
+static GBool printHelp = gFalse;
+
+static const ArgDesc argDesc[] = {
+  {"-n",      argInt,      &iterations,      0,
+   "number of times each image is decoded"},
+  {"-h",      argFlag,     &printHelp,       0,
+   "print usage information"},
+  {"-help",   argFlag,     &printHelp,       0,
+   "print usage information"},
+  {"--help",  argFlag,     &printHelp,       0,
+   "print usage information"},
+  {"-?",      argFlag,     &printHelp,       0,
+   "print usage information"},
+  { }
+};
+
+// Is <obj> an image whose last filter is JBIG2Decode?
+static GBool isJBIG2Image(Object *obj) {
+  if (!obj->isStream()) {
+    return gFalse;
+  }
+  Dict *dict = obj->streamGetDict();
+  if (!dict->lookup("Subtype").isName("Image")) {
+    return gFalse;
+  }
+  Object filter = dict->lookup("Filter");
+  if (filter.isArray() && filter.arrayGetLength() > 0) {
+    filter = filter.arrayGet(filter.arrayGetLength() - 1);
+  }
+  return filter.isName("JBIG2Decode");
+}
+
+// Decodes the image stream <obj> <iterations> times, returns the time
+// it took in seconds
+static double decodeImage(Object *obj, long *nBytes) {
+  Stream *str;
+  Guchar buf[4096];
+  GooTimer timer;
+  int n;
+
+  str = obj->getStream();
+  for (int i = 0; i < iterations; ++i) {
+    *nBytes = 0;
+    str->reset();
+    while ((n = str->doGetChars(sizeof(buf), buf)) > 0) {
+      *nBytes += n;
+    }
+    str->close();
+  }
+  timer.stop();
+  return timer.getElapsed();
+}
+
+int main(int argc, char *argv[])
+{
+  PDFDoc *doc;
+  XRef *xref;
+  XRefEntry *entry;
+  long nBytes;
+  double time, totalTime, pixels, totalPixels;
+  int nImages, totalImages;
+
+  GBool ok = parseArgs(argDesc, &argc, argv);
+  if (!ok || argc < 2 || printHelp || iterations < 1) {
+    printUsage(argv[0], "PDF-FILE...", argDesc);
+    return printHelp ? 0 : 1;
+  }
+
+  globalParams = new GlobalParams();
+  printf("%-32s %7s %10s %10s %14s\n", "file", "images", "Mpixels", "s",
+	 "pixels/s");
+  totalImages = 0;
+  totalPixels = 0;
+  totalTime = 0;
+  for (int i = 1; i < argc; ++i) {
+    doc = new PDFDoc(new GooString(argv[i]));
+    if (!doc->isOk()) {
+      fprintf(stderr, "Error loading %s\n", argv[i]);
+      delete doc;
+      continue;
+    }
+    xref = doc->getXRef();
+    nImages = 0;
+    pixels = 0;
+    time = 0;
+    for (int num = 0; num < xref->getNumObjects(); ++num) {
+      entry = xref->getEntry(num, gFalse);
+      if (!entry || entry->type == xrefEntryFree) {
+	continue;
+      }
+      Object obj = xref->fetch(num, entry->type == xrefEntryCompressed ?
+				      0 : entry->gen);
+      if (!isJBIG2Image(&obj)) {
+	continue;
+      }
+      time += decodeImage(&obj, &nBytes);
+      // 1 bit per pixel, give or take the padding of the rows
+      pixels += (double)nBytes * 8 * iterations;
+      ++nImages;
+    }
+    printf("%-32s %7d %10.1f %10.3f %14.0f\n", argv[i], nImages,
+	   pixels / iterations / 1e6, time, time > 0 ? pixels / time : 0);
+    totalImages += nImages;
+    totalPixels += pixels;
+    totalTime += time;
+    delete doc;
+  }
+  if (argc > 2) {
+    printf("%-32s %7d %10.1f %10.3f %14.0f\n", "total", totalImages,
+	   totalPixels / iterations / 1e6, totalTime,
+	   totalTime > 0 ? totalPixels / totalTime : 0);
+  }
+
+  delete globalParams;
+  return 0;
+}
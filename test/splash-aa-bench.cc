@@ -0,0 +1,233 @@
+//========================================================================
+//
+// splash-aa-bench.cc
+//
+// Fills synthetic paths with each anti-aliasing quality of Splash and
+// prints how many paths per second each of them draws, and how far its
+// pixels are from those of splashAAQualityNormal.
+//
+// This file is licensed under the GPLv2 or later
+//
+//========================================================================
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "goo/GooTimer.h"
+#include "splash/SplashTypes.h"
+#include "splash/SplashBitmap.h"
+#include "splash/SplashPath.h"
+#include "splash/SplashPattern.h"
+#include "splash/Splash.h"
+#include "parseargs.h"
+
+static int width = 1024;
+static int height = 1024;
+static int nPaths = 2000;
+static int iterations = 3;
+static GBool printHelp = gFalse;
+
+static const ArgDesc argDesc[] = {
+  {"-width",  argInt,      &width,           0,
+   "width of the bitmap"},
+  {"-height", argInt,      &height,          0,
+   "height of the bitmap"},
+  {"-p",      argInt,      &nPaths,          0,
+   "number of paths of each kind"},
+  {"-n",      argInt,      &iterations,      0,
+   "number of times the paths are drawn"},
+  {"-h",      argFlag,     &printHelp,       0,
+   "print usage information"},
+  {"-help",   argFlag,     &printHelp,       0,
+   "print usage information"},
+  {"--help",  argFlag,     &printHelp,       0,
+   "print usage information"},
+  {"-?",      argFlag,     &printHelp,       0,
+   "print usage information"},
+  { }
+};
+
+struct Quality {
+  const char *name;
+  SplashAAQuality quality;
+};
+
+static const Quality qualities[] = {
+  { "normal",   splashAAQualityNormal },
+  { "draft",    splashAAQualityDraft },
+  { "analytic", splashAAQualityAnalytic },
+  { nullptr,    splashAAQualityNormal }
+};
+
+enum PathKind {
+  pathPolygon,			// self-intersecting polygons, filled
+  pathRing,			// circles with a hole, even-odd filled
+  pathSmall,			// glyph-sized curved shapes
+  pathStroke			// stroked polylines
+};
+
+static const char *pathKindNames[] = {
+  "polygons", "rings", "small", "strokes"
+};
+
+static Guint seed;
+
+static double rnd(double max) {
+  seed = seed * 1103515245 + 12345;
+  return max * ((seed >> 8) & 0xffff) / 65536.0;
+}
+
+static void addCircle(SplashPath *path, double cx, double cy, double r) {
+  // the usual 4-curve approximation
+  double k = 0.5523 * r;
+
+  path->moveTo(cx + r, cy);
+  path->curveTo(cx + r, cy + k, cx + k, cy + r, cx, cy + r);
+  path->curveTo(cx - k, cy + r, cx - r, cy + k, cx - r, cy);
+  path->curveTo(cx - r, cy - k, cx - k, cy - r, cx, cy - r);
+  path->curveTo(cx + k, cy - r, cx + r, cy - k, cx + r, cy);
+  path->close();
+}
+
+static SplashPath *makePath(PathKind kind) {
+  SplashPath *path;
+  double cx, cy, r, a;
+  int n, i;
+
+  path = new SplashPath();
+  cx = rnd(width);
+  cy = rnd(height);
+  switch (kind) {
+  case pathPolygon:
+    r = 10 + rnd(90);
+    n = 5 + (int)rnd(10);
+    for (i = 0; i < n; ++i) {
+      a = 2 * M_PI * i * 2 / n;
+      if (i == 0) {
+	path->moveTo(cx + r * cos(a), cy + r * sin(a));
+      } else {
+	path->lineTo(cx + r * cos(a), cy + r * sin(a));
+      }
+    }
+    path->close();
+    break;
+  case pathRing:
+    r = 10 + rnd(90);
+    addCircle(path, cx, cy, r);
+    addCircle(path, cx + rnd(r / 4), cy, r / 2);
+    break;
+  case pathSmall:
+    r = 2 + rnd(6);
+    addCircle(path, cx, cy, r);
+    path->moveTo(cx - r, cy - 2 * r);
+    path->lineTo(cx + r, cy - 2 * r);
+    path->lineTo(cx, cy - r);
+    path->close();
+    break;
+  case pathStroke:
+    path->moveTo(cx, cy);
+    for (i = 0; i < 5; ++i) {
+      cx += rnd(100) - 50;
+      cy += rnd(100) - 50;
+      path->lineTo(cx, cy);
+    }
+    break;
+  }
+  return path;
+}
+
+// Draws <paths> with <quality>, returns the time it took in seconds
+static double draw(SplashBitmap *bitmap, SplashPath **paths,
+		   PathKind kind, SplashAAQuality quality) {
+  Splash *splash;
+  SplashColor color;
+  GooTimer timer;
+  int i;
+
+  for (int iter = 0; iter < iterations; ++iter) {
+    splash = new Splash(bitmap, gTrue);
+    splash->setAAQuality(quality);
+    color[0] = color[1] = color[2] = 0xff;
+    splash->clear(color, 0xff);
+    color[0] = 0x20;
+    color[1] = 0x40;
+    color[2] = 0x80;
+    splash->setFillPattern(new SplashSolidColor(color));
+    splash->setStrokePattern(new SplashSolidColor(color));
+    splash->setFillAlpha(0.5);
+    splash->setStrokeAlpha(0.5);
+    splash->setLineWidth(2.5);
+    for (i = 0; i < nPaths; ++i) {
+      if (kind == pathStroke) {
+	splash->stroke(paths[i]);
+      } else {
+	splash->fill(paths[i], kind == pathRing);
+      }
+    }
+    delete splash;
+  }
+  timer.stop();
+  return timer.getElapsed();
+}
+
+// Returns the mean absolute difference between the samples of <a> and <b>
+static double meanDiff(SplashBitmap *a, SplashBitmap *b) {
+  SplashColorPtr pa, pb;
+  double sum;
+  int x, y;
+
+  sum = 0;
+  for (y = 0; y < a->getHeight(); ++y) {
+    pa = a->getDataPtr() + y * a->getRowSize();
+    pb = b->getDataPtr() + y * b->getRowSize();
+    for (x = 0; x < 3 * a->getWidth(); ++x) {
+      sum += abs((int)pa[x] - (int)pb[x]);
+    }
+  }
+  return sum / ((double)a->getHeight() * 3 * a->getWidth());
+}
+
+int main(int argc, char *argv[])
+{
+  SplashBitmap *normal, *bitmap;
+  SplashPath **paths;
+  double t;
+  GBool ok;
+
+  ok = parseArgs(argDesc, &argc, argv);
+  if (!ok || argc != 1 || printHelp || width < 1 || height < 1 ||
+      nPaths < 1 || iterations < 1) {
+    printUsage(argv[0], nullptr, argDesc);
+    return printHelp ? 0 : 1;
+  }
+
+  normal = new SplashBitmap(width, height, 1, splashModeRGB8, gFalse);
+  bitmap = new SplashBitmap(width, height, 1, splashModeRGB8, gFalse);
+  paths = new SplashPath *[nPaths];
+  printf("%-9s %-9s %12s %10s\n", "paths", "quality", "paths/s",
+	 "mean diff");
+  for (int kind = pathPolygon; kind <= pathStroke; ++kind) {
+    seed = 12345 + kind;
+    for (int i = 0; i < nPaths; ++i) {
+      paths[i] = makePath((PathKind)kind);
+    }
+    for (const Quality *q = qualities; q->name; ++q) {
+      t = draw(q == qualities ? normal : bitmap, paths, (PathKind)kind,
+	       q->quality);
+      printf("%-9s %-9s %12.0f %10.3f\n", pathKindNames[kind], q->name,
+	     (double)nPaths * iterations / t,
+	     q == qualities ? 0.0 : meanDiff(normal, bitmap));
+    }
+    for (int i = 0; i < nPaths; ++i) {
+      delete paths[i];
+    }
+  }
+
+  delete[] paths;
+  delete bitmap;
+  delete normal;
+  return 0;
+}
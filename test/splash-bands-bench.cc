@@ -0,0 +1,130 @@
+//========================================================================
+//
+// splash-bands-bench.cc
+//
+// Renders pages with SplashOutputDev on one thread, then split in bands
+// rasterized concurrently with displayPageBands(), and prints the time
+// each took and whether the bitmaps are the same.
+//
+// This file is licensed under the GPLv2 or later
+//
+//========================================================================
+
+#include <config.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "goo/GooString.h"
+#include "goo/GooTimer.h"
+#include "GlobalParams.h"
+#include "PDFDoc.h"
+#include "SplashOutputDev.h"
+#include "splash/SplashBitmap.h"
+#include "parseargs.h"
+
+static int firstPage = 1;
+static int lastPage = 0;
+static double resolution = 300;
+static int nBands = 0;
+static GBool mono = gFalse;
+static GBool gray = gFalse;
+static GBool printHelp = gFalse;
+
+static const ArgDesc argDesc[] = {
+  {"-f",      argInt,      &firstPage,       0,
+   "first page to render"},
+  {"-l",      argInt,      &lastPage,        0,
+   "last page to render"},
+  {"-r",      argFP,       &resolution,      0,
+   "resolution, in DPI (default is 300)"},
+  {"-bands",  argInt,      &nBands,          0,
+   "number of bands (default is one per core)"},
+  {"-mono",   argFlag,     &mono,            0,
+   "render monochrome bitmaps"},
+  {"-gray",   argFlag,     &gray,            0,
+   "render grayscale bitmaps"},
+  {"-h",      argFlag,     &printHelp,       0,
+   "print usage information"},
+  {"-help",   argFlag,     &printHelp,       0,
+   "print usage information"},
+  {"--help",  argFlag,     &printHelp,       0,
+   "print usage information"},
+  {"-?",      argFlag,     &printHelp,       0,
+   "print usage information"},
+  { }
+};
+
+static GBool sameBitmaps(SplashBitmap *a, SplashBitmap *b)
+{
+  if (a->getWidth() != b->getWidth() || a->getHeight() != b->getHeight() ||
+      a->getRowSize() != b->getRowSize()) {
+    return gFalse;
+  }
+  return memcmp(a->getDataPtr(), b->getDataPtr(),
+		a->getRowSize() * a->getHeight()) == 0;
+}
+
+int main(int argc, char *argv[])
+{
+  PDFDoc *doc;
+  SplashOutputDev *singleOut, *bandsOut;
+  SplashColorMode colorMode;
+  SplashColor paperColor;
+  double singleTime, bandsTime;
+
+  GBool ok = parseArgs(argDesc, &argc, argv);
+  if (!ok || argc != 2 || printHelp || resolution <= 0) {
+    printUsage(argv[0], "PDF-FILE", argDesc);
+    return printHelp ? 0 : 1;
+  }
+
+  globalParams = new GlobalParams();
+  doc = new PDFDoc(new GooString(argv[1]));
+  if (!doc->isOk()) {
+    fprintf(stderr, "Error loading document\n");
+    delete doc;
+    delete globalParams;
+    return 1;
+  }
+  if (firstPage < 1) {
+    firstPage = 1;
+  }
+  if (lastPage < 1 || lastPage > doc->getNumPages()) {
+    lastPage = doc->getNumPages();
+  }
+
+  colorMode = mono ? splashModeMono1 : gray ? splashModeMono8
+                                            : splashModeRGB8;
+  paperColor[0] = paperColor[1] = paperColor[2] = 0xff;
+  singleOut = new SplashOutputDev(colorMode, 4, gFalse, paperColor);
+  singleOut->startDoc(doc);
+  bandsOut = new SplashOutputDev(colorMode, 4, gFalse, paperColor);
+  bandsOut->startDoc(doc);
+
+  for (int pg = firstPage; pg <= lastPage; ++pg) {
+    GooTimer singleTimer;
+    doc->displayPage(singleOut, pg, resolution, resolution, 0,
+		     gFalse, gTrue, gFalse);
+    singleTimer.stop();
+    singleTime = singleTimer.getElapsed();
+
+    GooTimer bandsTimer;
+    bandsOut->displayPageBands(pg, resolution, resolution, 0,
+			       gFalse, gTrue, gFalse, nBands);
+    bandsTimer.stop();
+    bandsTime = bandsTimer.getElapsed();
+
+    printf("page %d: %dx%d  single %8.3f s  bands %8.3f s%s\n", pg,
+	   singleOut->getBitmapWidth(), singleOut->getBitmapHeight(),
+	   singleTime, bandsTime,
+	   sameBitmaps(singleOut->getBitmap(), bandsOut->getBitmap()) ?
+	     "" : "  DIFFERENT");
+  }
+
+  delete bandsOut;
+  delete singleOut;
+  delete doc;
+  delete globalParams;
+  return 0;
+}
@@ -0,0 +1,418 @@
+//========================================================================
+//
+// stream-bench.cc
+//
+// Measures how many bytes per second each decoding filter delivers,
+// read one byte at a time with getChar() and in blocks with
+// doGetChars().  The data is synthetic, encoded with poppler's own
+// encoders.
+//
+// This file is licensed under the GPLv2 or later
+//
+//========================================================================
+
+#include <config.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "goo/GooString.h"
+#include "goo/GooTimer.h"
+#include "Object.h"
+#include "Stream.h"
+#include "Decrypt.h"
+#include "parseargs.h"
+#ifdef ENABLE_ZLIB
+#include "FlateEncoder.h"
+#endif
+#ifdef ENABLE_ZLIB_UNCOMPRESS
+#include "FlateStream.h"
+#endif
+
+// CCITTFax rows, each encoded as a single bit
+#define ccittColumns 1728
+
+// RGB rows of the PNG predicted data
+#define pngColumns 1024
+
+static int dataSize = 4;
+static int iterations = 5;
+static GBool printHelp = gFalse;
+
+static const ArgDesc argDesc[] = {
+  {"-s",      argInt,      &dataSize,        0,
+   "size of the decoded data, in MB"},
+  {"-n",      argInt,      &iterations,      0,
+   "number of times each filter is run"},
+  {"-h",      argFlag,     &printHelp,       0,
+   "print usage information"},
+  {"-help",   argFlag,     &printHelp,       0,
+   "print usage information"},
+  {"--help",  argFlag,     &printHelp,       0,
+   "print usage information"},
+  {"-?",      argFlag,     &printHelp,       0,
+   "print usage information"},
+  { }
+};
+
+static Guchar cryptKey[16] = {
+  0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+  0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10
+};
+
+static Stream *memStream(GooString *s) {
+  return new MemStream(s->getCString(), 0, s->getLength(), Object(objNull));
+}
+
+// Reads <str> till its end into a new string
+static GooString *readAll(Stream *str) {
+  GooString *s;
+  char buf[4096];
+  int n;
+
+  s = new GooString();
+  str->reset();
+  while ((n = str->doGetChars(sizeof(buf), (Guchar *)buf)) > 0) {
+    s->append(buf, n);
+  }
+  str->close();
+  return s;
+}
+
+// Image-like data: runs of a repeated byte mixed with noise, so that
+// RunLength and LZW have something to compress
+static GooString *makeData(int size) {
+  GooString *s;
+  Guint seed;
+  int run, c;
+
+  s = new GooString();
+  seed = 12345;
+  while (s->getLength() < size) {
+    seed = seed * 1103515245 + 12345;
+    run = (seed >> 16) & 63;
+    c = (seed >> 8) & 0xff;
+    if (run < 32) {
+      for (; run >= 0 && s->getLength() < size; --run) {
+	s->append((char)c);
+      }
+    } else {
+      for (; run >= 0 && s->getLength() < size; --run) {
+	seed = seed * 1103515245 + 12345;
+	s->append((char)(seed >> 16));
+      }
+    }
+  }
+  return s;
+}
+
+static GooString *encodeNone(GooString *data) {
+  return data->copy();
+}
+
+static Stream *decodeNone(Stream *str) {
+  return str;
+}
+
+static GooString *encodeASCIIHex(GooString *data) {
+  Stream *base = memStream(data);
+  Stream *enc = new ASCIIHexEncoder(base);
+  GooString *s = readAll(enc);
+  delete enc;
+  delete base;
+  return s;
+}
+
+static Stream *decodeASCIIHex(Stream *str) {
+  return new ASCIIHexStream(str);
+}
+
+static GooString *encodeASCII85(GooString *data) {
+  Stream *base = memStream(data);
+  Stream *enc = new ASCII85Encoder(base);
+  GooString *s = readAll(enc);
+  delete enc;
+  delete base;
+  return s;
+}
+
+static Stream *decodeASCII85(Stream *str) {
+  return new ASCII85Stream(str);
+}
+
+static GooString *encodeRunLength(GooString *data) {
+  Stream *base = memStream(data);
+  Stream *enc = new RunLengthEncoder(base);
+  GooString *s = readAll(enc);
+  delete enc;
+  delete base;
+  return s;
+}
+
+static Stream *decodeRunLength(Stream *str) {
+  return new RunLengthStream(str);
+}
+
+static GooString *encodeLZW(GooString *data) {
+  Stream *base = memStream(data);
+  Stream *enc = new LZWEncoder(base);
+  GooString *s = readAll(enc);
+  delete enc;
+  delete base;
+  return s;
+}
+
+static Stream *decodeLZW(Stream *str) {
+  return new LZWStream(str, 1, 0, 0, 0, 1);
+}
+
+#ifdef ENABLE_ZLIB
+static GooString *encodeFlate(GooString *data) {
+  Stream *base = memStream(data);
+  Stream *enc = new FlateEncoder(base);
+  GooString *s = readAll(enc);
+  delete enc;
+  delete base;
+  return s;
+}
+
+static Stream *decodeFlate(Stream *str) {
+  return new FlateStream(str, 1, 0, 0, 0);
+}
+
+// Applies the PNG predictors to the rows of <data>, cycling through the
+// five of them
+static GooString *predictPNG(GooString *data) {
+  GooString *s;
+  const Guchar *line, *prev;
+  int rowBytes, nRows, left, up, upLeft, p, pa, pb, pc, pred;
+  int x, y;
+
+  rowBytes = pngColumns * 3;
+  nRows = data->getLength() / rowBytes;
+  s = new GooString();
+  for (y = 0; y < nRows; ++y) {
+    line = (const Guchar *)data->getCString() + y * rowBytes;
+    prev = y > 0 ? line - rowBytes : nullptr;
+    s->append((char)(y % 5));
+    for (x = 0; x < rowBytes; ++x) {
+      left = x >= 3 ? line[x - 3] : 0;
+      up = prev ? prev[x] : 0;
+      upLeft = prev && x >= 3 ? prev[x - 3] : 0;
+      switch (y % 5) {
+      case 1:
+	pred = left;
+	break;
+      case 2:
+	pred = up;
+	break;
+      case 3:
+	pred = (left + up) >> 1;
+	break;
+      case 4:
+	p = left + up - upLeft;
+	pa = p > left ? p - left : left - p;
+	pb = p > up ? p - up : up - p;
+	pc = p > upLeft ? p - upLeft : upLeft - p;
+	pred = (pa <= pb && pa <= pc) ? left : pb <= pc ? up : upLeft;
+	break;
+      default:
+	pred = 0;
+	break;
+      }
+      s->append((char)(line[x] - pred));
+    }
+  }
+  return s;
+}
+
+static GooString *encodeFlatePNG(GooString *data) {
+  GooString *predicted = predictPNG(data);
+  GooString *s = encodeFlate(predicted);
+  delete predicted;
+  return s;
+}
+
+// predictPNG() drops the last partial row
+static GooString *decodedFlatePNG(GooString *data) {
+  int rowBytes = pngColumns * 3;
+
+  return new GooString(data->getCString(),
+		       data->getLength() / rowBytes * rowBytes);
+}
+
+static Stream *decodeFlatePNG(Stream *str) {
+  return new FlateStream(str, 15, pngColumns, 3, 8);
+}
+#endif
+
+static GooString *encodeCCITTFax(GooString *data) {
+  GooString *s;
+  int rows, i;
+
+  // in 2D (K < 0) mode a white row under a white row is a single V0 code,
+  // i.e. one bit set
+  rows = data->getLength() / (ccittColumns / 8);
+  s = new GooString();
+  for (i = 0; i < (rows + 7) / 8; ++i) {
+    s->append((char)0xff);
+  }
+  return s;
+}
+
+// The rows of white pixels encodeCCITTFax() stands for
+static GooString *decodedCCITTFax(GooString *data) {
+  GooString *s;
+  int rows, i;
+
+  rows = data->getLength() / (ccittColumns / 8);
+  s = new GooString();
+  for (i = 0; i < rows * (ccittColumns / 8); ++i) {
+    s->append((char)0xff);
+  }
+  return s;
+}
+
+static Stream *decodeCCITTFax(Stream *str) {
+  return new CCITTFaxStream(str, -1, gFalse, gFalse, ccittColumns,
+			    dataSize * 1024 * 1024 / (ccittColumns / 8),
+			    gFalse, gFalse, 0);
+}
+
+static GooString *encodeRC4(GooString *data) {
+  Stream *enc = new EncryptStream(memStream(data), cryptKey, cryptRC4,
+				  16, 1, 0);
+  GooString *s = readAll(enc);
+  delete enc;
+  return s;
+}
+
+static Stream *decodeRC4(Stream *str) {
+  return new DecryptStream(str, cryptKey, cryptRC4, 16, 1, 0);
+}
+
+static GooString *encodeAES(GooString *data) {
+  Stream *enc = new EncryptStream(memStream(data), cryptKey, cryptAES,
+				  16, 1, 0);
+  GooString *s = readAll(enc);
+  delete enc;
+  return s;
+}
+
+static Stream *decodeAES(Stream *str) {
+  return new DecryptStream(str, cryptKey, cryptAES, 16, 1, 0);
+}
+
+struct Filter {
+  const char *name;
+  GooString *(*encode)(GooString *data);
+  Stream *(*decode)(Stream *str);
+  GooString *(*decoded)(GooString *data);	// what decode() should return
+						//   for <data>, if not <data>
+};
+
+static const Filter filters[] = {
+  { "none",      &encodeNone,      &decodeNone,      nullptr },
+  { "ASCIIHex",  &encodeASCIIHex,  &decodeASCIIHex,  nullptr },
+  { "ASCII85",   &encodeASCII85,   &decodeASCII85,   nullptr },
+  { "RunLength", &encodeRunLength, &decodeRunLength, nullptr },
+  { "LZW",       &encodeLZW,       &decodeLZW,       nullptr },
+#ifdef ENABLE_ZLIB
+  { "Flate",     &encodeFlate,     &decodeFlate,     nullptr },
+  { "Flate+PNG", &encodeFlatePNG,  &decodeFlatePNG,  &decodedFlatePNG },
+#endif
+  { "CCITTFax",  &encodeCCITTFax,  &decodeCCITTFax,  &decodedCCITTFax },
+  { "RC4",       &encodeRC4,       &decodeRC4,       nullptr },
+  { "AES",       &encodeAES,       &decodeAES,       nullptr },
+  { nullptr,     nullptr,          nullptr,          nullptr }
+};
+
+// Decodes <encoded> <iterations> times, returns the time it took in
+// seconds, and the number of bytes decoded in <length>
+static double runFilter(const Filter *filter, GooString *encoded,
+			GBool block, int *length) {
+  Stream *str;
+  Guchar buf[4096];
+  GooTimer timer;
+  int n;
+
+  for (int iter = 0; iter < iterations; ++iter) {
+    str = filter->decode(memStream(encoded));
+    str->reset();
+    *length = 0;
+    if (block) {
+      while ((n = str->doGetChars(sizeof(buf), buf)) > 0) {
+	*length += n;
+      }
+    } else {
+      while (str->getChar() != EOF) {
+	++*length;
+      }
+    }
+    delete str;
+  }
+  timer.stop();
+  return timer.getElapsed();
+}
+
+// Decodes <encoded> once more, with getChar() or doGetChars(), and
+// checks the result against <expected>
+static GBool checkFilter(const Filter *filter, GooString *encoded,
+			 GBool block, GooString *expected) {
+  Stream *str;
+  GooString *s;
+  int c;
+  GBool same;
+
+  str = filter->decode(memStream(encoded));
+  if (block) {
+    s = readAll(str);
+  } else {
+    s = new GooString();
+    str->reset();
+    while ((c = str->getChar()) != EOF) {
+      s->append((char)c);
+    }
+    str->close();
+  }
+  delete str;
+  same = s->getLength() == expected->getLength() &&
+	 !memcmp(s->getCString(), expected->getCString(), s->getLength());
+  delete s;
+  return same;
+}
+
+int main(int argc, char *argv[])
+{
+  GooString *data, *encoded, *expected;
+  double charTime, blockTime;
+  int charLength, blockLength;
+  GBool ok;
+
+  ok = parseArgs(argDesc, &argc, argv);
+  if (!ok || argc != 1 || printHelp || dataSize < 1 || iterations < 1) {
+    printUsage(argv[0], nullptr, argDesc);
+    return printHelp ? 0 : 1;
+  }
+
+  data = makeData(dataSize * 1024 * 1024);
+  printf("%-10s %10s %14s %14s\n", "filter", "decoded", "getChar B/s",
+	 "getChars B/s");
+  for (const Filter *filter = filters; filter->name; ++filter) {
+    encoded = (*filter->encode)(data);
+    expected = filter->decoded ? (*filter->decoded)(data) : data->copy();
+    charTime = runFilter(filter, encoded, gFalse, &charLength);
+    blockTime = runFilter(filter, encoded, gTrue, &blockLength);
+    ok = checkFilter(filter, encoded, gFalse, expected) &&
+	 checkFilter(filter, encoded, gTrue, expected);
+    printf("%-10s %10d %14.0f %14.0f%s\n", filter->name, blockLength,
+	   (double)charLength * iterations / charTime,
+	   (double)blockLength * iterations / blockTime,
+	   ok ? "" : "  MISMATCH");
+    delete expected;
+    delete encoded;
+  }
+
+  delete data;
+  return 0;
+}